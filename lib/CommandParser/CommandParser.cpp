@@ -0,0 +1,123 @@
+/*******************************************************************************
+ * @file    CommandParser.cpp
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ *******************************************************************************/
+
+#include <string.h>
+#include "CommandParser.h"
+
+E_COMMAND_STATUS COMMAND_PARSER::feed(uint8_t c)
+{
+  if (this->_done)
+  {
+    this->_len = 0;
+    this->_argc = 0;
+    this->_done = false;
+  }
+
+  if (c == '\r' || c == '\n')
+  {
+    if (this->_overflow)
+    {
+      this->_overflow = false;
+      this->_len = 0;
+      this->_stats.too_long++;
+
+      return COMMAND_TOO_LONG;
+    }
+
+    this->_line[this->_len] = '\0';
+    this->_split();
+    this->_done = true;
+    if (this->_argc == 0)
+      return COMMAND_PENDING;
+    this->_stats.lines++;
+
+    return COMMAND_READY;
+  }
+
+  if (this->_overflow)
+    return COMMAND_PENDING;
+
+  if (c == '\b' || c == 0x7F)
+  {
+    if (this->_len > 0)
+      this->_len--;
+  }
+  else if (this->_len < COMMAND_LINE_MAX)
+  {
+    this->_line[this->_len++] = (char) c;
+  }
+  else
+  {
+    this->_overflow = true;
+  }
+
+  return COMMAND_PENDING;
+}
+
+uint8_t COMMAND_PARSER::get_argc(void)
+{
+  return this->_argc;
+}
+
+const char *COMMAND_PARSER::get_arg(uint8_t i)
+{
+  return i < this->_argc ? this->_args[i] : "";
+}
+
+bool COMMAND_PARSER::is(const char *command)
+{
+  return this->_argc > 0 && strcmp(this->_args[0], command) == 0;
+}
+
+bool COMMAND_PARSER::get_uint(uint8_t i, uint32_t &value)
+{
+  const char *arg = this->get_arg(i);
+  uint32_t v = 0;
+
+  if (*arg == '\0')
+    return false;
+
+  for (; *arg != '\0'; arg++)
+  {
+    const uint8_t digit = *arg - '0';
+
+    if (digit > 9 || v > (UINT32_MAX - digit) / 10)
+      return false;
+    v = v * 10 + digit;
+  }
+  value = v;
+
+  return true;
+}
+
+const ST_COMMAND_STATS &COMMAND_PARSER::get_stats(void)
+{
+  return this->_stats;
+}
+
+/***************************/
+/* Private methods         */
+/***************************/
+
+void COMMAND_PARSER::_split(void)
+{
+  char *p = this->_line;
+
+  this->_argc = 0;
+  while (this->_argc < COMMAND_ARGS_MAX)
+  {
+    while (*p == ' ' || *p == '\t')
+      p++;
+    if (*p == '\0')
+      break;
+
+    this->_args[this->_argc++] = p;
+    while (*p != '\0' && *p != ' ' && *p != '\t')
+      p++;
+    if (*p != '\0')
+      *p++ = '\0';
+  }
+}
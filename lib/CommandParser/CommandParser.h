@@ -0,0 +1,68 @@
+/*******************************************************************************
+ * @file    CommandParser.h
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Incremental parser of text command lines, e.g. from Serial.
+ *          feed() takes the received bytes one at a time, as they arrive, and
+ *          never waits for more. A line ends with '\r' or '\n', so both line
+ *          endings of a terminal work. Backspace and DEL erase the previous
+ *          character. An empty line is ignored.
+ *
+ *          A completed line is split in place into words separated by spaces
+ *          or tabs, at most COMMAND_ARGS_MAX, the words after those are
+ *          ignored. The words stay valid until the next call to feed(). A
+ *          line longer than COMMAND_LINE_MAX characters is discarded whole
+ *          and reported once, at its end.
+ *
+ *          No allocation: the line buffer and the words are members.
+ *
+ *          Statistics: lines completed and lines discarded as too long.
+*******************************************************************************/
+
+#ifndef _COMMAND_PARSER_H
+#define _COMMAND_PARSER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define COMMAND_LINE_MAX 32U
+#define COMMAND_ARGS_MAX 4U
+
+typedef enum {
+  COMMAND_PENDING = 0,
+  COMMAND_READY,
+  COMMAND_TOO_LONG,
+} E_COMMAND_STATUS;
+
+typedef struct {
+  uint32_t lines;
+  uint32_t too_long;
+} ST_COMMAND_STATS;
+
+class COMMAND_PARSER
+{
+  public:
+    E_COMMAND_STATUS feed(uint8_t c);
+    // Words of the last line, the command first
+    uint8_t get_argc(void);
+    // "" past the last word
+    const char *get_arg(uint8_t i);
+    bool is(const char *command);
+    // Returns false if the word is not a decimal number of 32 bits
+    bool get_uint(uint8_t i, uint32_t &value);
+    const ST_COMMAND_STATS &get_stats(void);
+
+  private:
+    void _split(void);
+
+    char _line[COMMAND_LINE_MAX + 1];
+    uint8_t _len = 0;
+    bool _overflow = false;
+    // The words are parsed, the next byte starts a new line
+    bool _done = false;
+    char *_args[COMMAND_ARGS_MAX];
+    uint8_t _argc = 0;
+    ST_COMMAND_STATS _stats = { 0, 0 };
+};
+
+#endif // _COMMAND_PARSER_H
@@ -0,0 +1,285 @@
+/*******************************************************************************
+ * @file    ConfigStore.cpp
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ *******************************************************************************/
+
+#include <string.h>
+#include "ConfigStore.h"
+
+// Offsets in a slot
+#define _SEQ 0
+#define _TYPE 2
+#define _VERSION 3
+#define _DATA 4
+#define _CRC (_DATA + CONFIG_STORE_DATA)
+
+static uint16_t _crc16(uint16_t crc, uint8_t value)
+{
+  crc ^= (uint16_t) value << 8;
+  for (uint8_t i = 0; i < 8; i++)
+    crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+
+  return crc;
+}
+
+CONFIG_STORE::CONFIG_STORE(uint16_t start /*=0*/, uint16_t size /*=HAL_EEPROM_SIZE*/,
+  read_fp read /*=hal_eeprom_read*/, write_fp write /*=hal_eeprom_update*/)
+{
+  this->_read_byte = read != NULL ? read : hal_eeprom_read;
+  this->_write_byte = write != NULL ? write : hal_eeprom_update;
+  this->_start = start;
+  this->_slots = size / CONFIG_STORE_RECORD;
+  for (uint8_t t = 0; t < CONFIG_STORE_TYPES; t++)
+    this->_latest[t] = CONFIG_STORE_NONE;
+}
+
+bool CONFIG_STORE::begin(void)
+{
+  uint16_t candidates[CONFIG_STORE_CANDIDATES];
+  uint16_t candidate_seqs[CONFIG_STORE_CANDIDATES];
+  uint8_t n = 0;
+  ST_CONFIG_RECORD record;
+
+  this->_empty = true;
+  this->_head = this->_slots - 1;
+  this->_seq = 0xFFFF;
+  for (uint8_t t = 0; t < CONFIG_STORE_TYPES; t++)
+    this->_latest[t] = CONFIG_STORE_NONE;
+  if (this->_slots <= CONFIG_STORE_TYPES)
+    return false;
+
+  // The newest headers, by sequence number across the wrap around
+  for (uint16_t slot = 0; slot < this->_slots; slot++)
+  {
+    uint16_t seq;
+    uint8_t type;
+    uint8_t i;
+
+    this->_read_header(slot, seq, type);
+    if (type >= CONFIG_STORE_TYPES)
+      continue;
+
+    for (i = n; i > 0 && (int16_t) (seq - candidate_seqs[i - 1]) > 0; i--)
+    {
+      if (i < CONFIG_STORE_CANDIDATES)
+      {
+        candidates[i] = candidates[i - 1];
+        candidate_seqs[i] = candidate_seqs[i - 1];
+      }
+    }
+    if (i < CONFIG_STORE_CANDIDATES)
+    {
+      candidates[i] = slot;
+      candidate_seqs[i] = seq;
+      if (n < CONFIG_STORE_CANDIDATES)
+        n++;
+    }
+  }
+
+  for (uint8_t i = 0; i < n && this->_empty; i++)
+  {
+    if (this->_read(candidates[i], record))
+    {
+      this->_head = candidates[i];
+      this->_seq = record.seq;
+      this->_empty = false;
+    }
+  }
+  if (this->_empty)
+    return false;
+
+  // The newest record of each type, walking back from the head. The slot of
+  // a record d appends older than the head is d slots before it.
+  for (uint16_t d = 0; d < this->_slots; d++)
+  {
+    const uint16_t slot = (this->_head + this->_slots - d) % this->_slots;
+    uint16_t seq;
+    uint8_t type;
+
+    this->_read_header(slot, seq, type);
+    if (seq != (uint16_t) (this->_seq - d) || type >= CONFIG_STORE_TYPES ||
+      this->_latest[type] != CONFIG_STORE_NONE)
+      continue;
+    if (this->_read(slot, record))
+      this->_latest[type] = slot;
+  }
+
+  return true;
+}
+
+bool CONFIG_STORE::append(uint8_t type, uint8_t version, const void *data, uint8_t len)
+{
+  ST_CONFIG_RECORD record;
+  uint16_t slot;
+
+  if (type >= CONFIG_STORE_TYPES || len > CONFIG_STORE_DATA || this->_slots <= CONFIG_STORE_TYPES)
+    return false;
+
+  // Copies the newest record of another type into the slot before its own,
+  // so it stays valid until its copy is written. Only a store written by an
+  // older firmware can hold one in the next slot, it is copied in place.
+  for (;;)
+  {
+    uint16_t from;
+    uint8_t t;
+
+    slot = (this->_head + 1) % this->_slots;
+    from = slot;
+    t = this->_latest_other(from, type);
+    if (t == CONFIG_STORE_TYPES)
+    {
+      from = (slot + 1) % this->_slots;
+      t = this->_latest_other(from, type);
+    }
+    if (t == CONFIG_STORE_TYPES)
+      break;
+    // Overwriting it would lose the only record of its type
+    if (!this->_read(from, record))
+      return false;
+
+    record.seq = this->_seq + 1;
+    this->_write(slot, record);
+    this->_head = slot;
+    this->_seq = record.seq;
+    this->_latest[t] = slot;
+    this->_stats.carried++;
+  }
+
+  for (uint8_t t = 0; t < CONFIG_STORE_TYPES; t++)
+    if (this->_latest[t] == slot)
+      this->_latest[t] = CONFIG_STORE_NONE;
+
+  record.seq = this->_seq + 1;
+  record.type = type;
+  record.version = version;
+  memset(record.data, 0, sizeof(record.data));
+  memcpy(record.data, data, len);
+  this->_write(slot, record);
+
+  this->_head = slot;
+  this->_seq = record.seq;
+  this->_empty = false;
+  this->_latest[type] = slot;
+  this->_stats.appends++;
+
+  return true;
+}
+
+bool CONFIG_STORE::find(uint8_t type, ST_CONFIG_RECORD &record, uint16_t age /*=0*/)
+{
+  if (type >= CONFIG_STORE_TYPES || this->_latest[type] == CONFIG_STORE_NONE)
+    return false;
+
+  if (age == 0)
+    return this->_read(this->_latest[type], record) && record.type == type;
+
+  // Older records, walking back from the newest one of the type
+  const uint16_t latest = this->_latest[type];
+  const uint16_t latest_d = (this->_head + this->_slots - latest) % this->_slots;
+
+  for (uint16_t d = latest_d + 1; d < this->_slots; d++)
+  {
+    const uint16_t slot = (this->_head + this->_slots - d) % this->_slots;
+    uint16_t seq;
+    uint8_t t;
+
+    this->_read_header(slot, seq, t);
+    if (t != type || seq != (uint16_t) (this->_seq - d))
+      continue;
+    if (this->_read(slot, record) && --age == 0)
+      return true;
+  }
+
+  return false;
+}
+
+bool CONFIG_STORE::is_empty(void)
+{
+  return this->_empty;
+}
+
+uint16_t CONFIG_STORE::get_slots(void)
+{
+  return this->_slots;
+}
+
+const ST_CONFIG_STORE_STATS &CONFIG_STORE::get_stats(void)
+{
+  return this->_stats;
+}
+
+/***************************/
+/* Private methods         */
+/***************************/
+
+bool CONFIG_STORE::_read(uint16_t slot, ST_CONFIG_RECORD &record)
+{
+  const uint16_t addr = this->_addr(slot);
+  uint8_t raw[CONFIG_STORE_RECORD];
+  uint16_t crc = 0xFFFF;
+
+  for (uint8_t i = 0; i < CONFIG_STORE_RECORD; i++)
+    raw[i] = this->_read_byte(addr + i);
+  this->_stats.reads += CONFIG_STORE_RECORD;
+
+  for (uint8_t i = 0; i < _CRC; i++)
+    crc = _crc16(crc, raw[i]);
+  if (crc != (raw[_CRC] | (uint16_t) raw[_CRC + 1] << 8))
+  {
+    this->_stats.crc_errors++;
+    return false;
+  }
+
+  record.seq = raw[_SEQ] | (uint16_t) raw[_SEQ + 1] << 8;
+  record.type = raw[_TYPE];
+  record.version = raw[_VERSION];
+  memcpy(record.data, &raw[_DATA], CONFIG_STORE_DATA);
+
+  return true;
+}
+
+void CONFIG_STORE::_write(uint16_t slot, const ST_CONFIG_RECORD &record)
+{
+  const uint16_t addr = this->_addr(slot);
+  uint8_t raw[CONFIG_STORE_RECORD];
+  uint16_t crc = 0xFFFF;
+
+  raw[_SEQ] = record.seq & 0xFF;
+  raw[_SEQ + 1] = record.seq >> 8;
+  raw[_TYPE] = record.type;
+  raw[_VERSION] = record.version;
+  memcpy(&raw[_DATA], record.data, CONFIG_STORE_DATA);
+  for (uint8_t i = 0; i < _CRC; i++)
+    crc = _crc16(crc, raw[i]);
+  raw[_CRC] = crc & 0xFF;
+  raw[_CRC + 1] = crc >> 8;
+
+  for (uint8_t i = 0; i < CONFIG_STORE_RECORD; i++)
+    this->_write_byte(addr + i, raw[i]);
+}
+
+void CONFIG_STORE::_read_header(uint16_t slot, uint16_t &seq, uint8_t &type)
+{
+  const uint16_t addr = this->_addr(slot);
+
+  seq = this->_read_byte(addr + _SEQ) | (uint16_t) this->_read_byte(addr + _SEQ + 1) << 8;
+  type = this->_read_byte(addr + _TYPE);
+  this->_stats.reads += 3;
+}
+
+uint8_t CONFIG_STORE::_latest_other(uint16_t slot, uint8_t type)
+{
+  uint8_t t;
+
+  for (t = 0; t < CONFIG_STORE_TYPES; t++)
+    if (t != type && this->_latest[t] == slot)
+      break;
+
+  return t;
+}
+
+uint16_t CONFIG_STORE::_addr(uint16_t slot)
+{
+  return this->_start + slot * CONFIG_STORE_RECORD;
+}
@@ -0,0 +1,109 @@
+/*******************************************************************************
+ * @file    ConfigStore.h
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Log-structured configuration store in the EEPROM.
+ *          The EEPROM range is a ring of CONFIG_STORE_RECORD bytes slots and
+ *          every append() writes the next slot, so the writes are spread
+ *          evenly over the whole range instead of rewriting the same cells.
+ *          Older records stay readable until the ring wraps around, which
+ *          keeps a history of every record type.
+ *
+ *          Record: sequence number (2 bytes), type, version, data
+ *          (CONFIG_STORE_DATA bytes) and a CRC-16/CCITT of all of them. The
+ *          sequence number increases by one per append, across the slots.
+ *          An erased slot (0xFF) or a record torn by a reset during append()
+ *          fails the CRC and is skipped.
+ *
+ *          begin() finds the newest record from the record headers only, in
+ *          two passes of 3 bytes per slot (~1.5KB of reads for 4KB), and
+ *          checks the CRC of the newest record and of the newest record of
+ *          each type. Only the last append() can be torn, so up to
+ *          CONFIG_STORE_CANDIDATES newest records are tried for the head.
+ *          Afterwards find() of the newest record of a type is a single
+ *          record read.
+ *
+ *          The newest record of every type is kept: one append() before
+ *          its slot is reached, it is copied forward into the slot before
+ *          it, so a reset during the copy leaves the original valid. So a
+ *          type appended often (a checkpoint) never pushes a rare one (a
+ *          calibration) out of the ring, only its older history.
+ *
+ *          Types are 0 ... CONFIG_STORE_TYPES - 1, the version is up to the
+ *          caller, e.g. to reject records of an older data layout.
+ *
+ *          The EEPROM access is injectable, hal_eeprom_read() and
+ *          hal_eeprom_update() by default, e.g. an EEPROM_QUEUE so that
+ *          append() does not wait for the EEPROM.
+*******************************************************************************/
+
+#ifndef _CONFIG_STORE_H
+#define _CONFIG_STORE_H
+
+#include <stdint.h>
+#include <Hal.h>
+
+#define CONFIG_STORE_RECORD 16U
+#define CONFIG_STORE_DATA 10U
+#define CONFIG_STORE_TYPES 8U
+#define CONFIG_STORE_CANDIDATES 4U
+#define CONFIG_STORE_NONE 0xFFFFU
+
+typedef struct {
+  uint16_t seq;
+  uint8_t type;
+  uint8_t version;
+  uint8_t data[CONFIG_STORE_DATA];
+} ST_CONFIG_RECORD;
+
+typedef struct {
+  uint32_t appends;
+  // Records copied forward to keep the newest of their type
+  uint32_t carried;
+  // EEPROM bytes read
+  uint32_t reads;
+  uint32_t crc_errors;
+} ST_CONFIG_STORE_STATS;
+
+class CONFIG_STORE
+{
+  public:
+    typedef uint8_t (*read_fp)(uint16_t addr);
+    typedef void (*write_fp)(uint16_t addr, uint8_t value);
+
+    CONFIG_STORE(uint16_t start=0, uint16_t size=HAL_EEPROM_SIZE, read_fp read=hal_eeprom_read,
+      write_fp write=hal_eeprom_update);
+
+    // Finds the newest records, returns false if the store is empty
+    bool begin(void);
+    // Returns false, appending nothing, if the newest record of another type
+    // to copy forward cannot be read back
+    bool append(uint8_t type, uint8_t version, const void *data, uint8_t len);
+    // age 0 is the newest record of the type, 1 the one before etc.
+    bool find(uint8_t type, ST_CONFIG_RECORD &record, uint16_t age=0);
+    bool is_empty(void);
+    uint16_t get_slots(void);
+    const ST_CONFIG_STORE_STATS &get_stats(void);
+
+  private:
+    bool _read(uint16_t slot, ST_CONFIG_RECORD &record);
+    void _write(uint16_t slot, const ST_CONFIG_RECORD &record);
+    void _read_header(uint16_t slot, uint16_t &seq, uint8_t &type);
+    // Type of the newest record in the slot, other than type, else
+    // CONFIG_STORE_TYPES
+    uint8_t _latest_other(uint16_t slot, uint8_t type);
+    uint16_t _addr(uint16_t slot);
+
+    read_fp _read_byte;
+    write_fp _write_byte;
+    uint16_t _start;
+    uint16_t _slots;
+    uint16_t _head = 0;
+    uint16_t _seq = 0;
+    bool _empty = true;
+    // Slot of the newest record of each type
+    uint16_t _latest[CONFIG_STORE_TYPES];
+    ST_CONFIG_STORE_STATS _stats = { 0, 0, 0, 0 };
+};
+
+#endif // _CONFIG_STORE_H
@@ -0,0 +1,116 @@
+/*******************************************************************************
+ * @file    EepromQueue.cpp
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ *******************************************************************************/
+
+#include "EepromQueue.h"
+
+bool EEPROM_QUEUE::write(uint16_t addr, uint8_t value)
+{
+  if (!this->_queue.push({ addr, value }))
+  {
+    this->_stats.full++;
+    return false;
+  }
+  if (this->_queue.size() > this->_stats.high_watermark)
+    this->_stats.high_watermark = this->_queue.size();
+
+  // The interrupt stops itself on an empty queue
+  if (!this->_running)
+  {
+    this->_running = true;
+    if (!hal_eeprom_start_ready_isr(_on_ready, this))
+    {
+      // No interrupt, written at once
+      _ST_WRITE item;
+
+      this->_running = false;
+      while (this->_queue.pop(item))
+      {
+        hal_eeprom_update(item.addr, item.value);
+        this->_stats.written++;
+      }
+      if (this->_done != NULL)
+        this->_done(this->_done_ctx);
+    }
+  }
+
+  return true;
+}
+
+void EEPROM_QUEUE::update(uint16_t addr, uint8_t value)
+{
+  while (!this->write(addr, value))
+    hal_idle();
+}
+
+uint8_t EEPROM_QUEUE::read(uint16_t addr)
+{
+  // Newest first, the interrupt only removes written entries
+  for (uint8_t age = 0; age < this->_queue.size(); age++)
+  {
+    const _ST_WRITE &item = this->_queue.newest(age);
+
+    if (item.addr == addr)
+      return item.value;
+  }
+
+  return hal_eeprom_read(addr);
+}
+
+bool EEPROM_QUEUE::is_idle(void)
+{
+  return this->_queue.empty();
+}
+
+uint8_t EEPROM_QUEUE::get_pending(void)
+{
+  return this->_queue.size();
+}
+
+void EEPROM_QUEUE::set_done_cb(done_fp done, void *ctx /*=NULL*/)
+{
+  this->_done = done;
+  this->_done_ctx = ctx;
+}
+
+const ST_EEPROM_QUEUE_STATS &EEPROM_QUEUE::get_stats(void)
+{
+  return this->_stats;
+}
+
+/***************************/
+/* Private methods         */
+/***************************/
+
+void EEPROM_QUEUE::_on_ready(void *ctx)
+{
+  EEPROM_QUEUE *queue = (EEPROM_QUEUE *) ctx;
+  _ST_WRITE item;
+
+  // The previous write is done
+  if (queue->_writing)
+  {
+    queue->_queue.pop(item);
+    queue->_writing = false;
+    queue->_stats.written++;
+  }
+
+  while (queue->_queue.peek(item))
+  {
+    if (hal_eeprom_read(item.addr) != item.value)
+    {
+      hal_eeprom_write_start(item.addr, item.value);
+      queue->_writing = true;
+      return;
+    }
+    queue->_queue.pop(item);
+    queue->_stats.skipped++;
+  }
+
+  hal_eeprom_stop_ready_isr();
+  queue->_running = false;
+  if (queue->_done != NULL)
+    queue->_done(queue->_done_ctx);
+}
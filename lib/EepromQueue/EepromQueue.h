@@ -0,0 +1,78 @@
+/*******************************************************************************
+ * @file    EepromQueue.h
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Non-blocking EEPROM write queue.
+ *          A byte write of the EEPROM takes ~3.3ms, so a record written with
+ *          EEPROM.put() stalls the caller for tens of ms. update() queues the
+ *          byte and returns, the EEPROM ready interrupt hands the queued bytes
+ *          to the EEPROM one by one while the main loop keeps running.
+ *          Bytes equal to the EEPROM content are skipped, like
+ *          EEPROM.update().
+ *
+ *          read() is coherent with the queue: a byte still queued is read
+ *          from the queue, newest first. Reading a byte not queued waits for
+ *          the byte being written, if any, at most HAL_EEPROM_WRITE_US.
+ *
+ *          Completion: is_idle() is true once every queued byte is written,
+ *          the done callback is called when the queue becomes empty, from
+ *          the interrupt.
+ *
+ *          When the queue is full update() waits for room in idle sleep,
+ *          write() fails instead. Without the ready interrupt (host
+ *          simulation without it, non AVR targets) the bytes are written
+ *          at once with hal_eeprom_update().
+*******************************************************************************/
+
+#ifndef _EEPROM_QUEUE_H
+#define _EEPROM_QUEUE_H
+
+#include <stdint.h>
+#include <Hal.h>
+#include <Spsc.h>
+
+#ifndef EEPROM_QUEUE_SIZE
+#define EEPROM_QUEUE_SIZE 64U
+#endif
+
+typedef struct {
+  uint32_t written;
+  uint32_t skipped;
+  // update() waits or write() failures on a full queue
+  uint16_t full;
+  uint8_t high_watermark;
+} ST_EEPROM_QUEUE_STATS;
+
+class EEPROM_QUEUE
+{
+  public:
+    typedef void (*done_fp)(void *ctx);
+
+    // Queues a byte, false if the queue is full
+    bool write(uint16_t addr, uint8_t value);
+    // Queues a byte, waits for room if the queue is full
+    void update(uint16_t addr, uint8_t value);
+    uint8_t read(uint16_t addr);
+    bool is_idle(void);
+    // Queued bytes, including the one being written
+    uint8_t get_pending(void);
+    void set_done_cb(done_fp done, void *ctx=NULL);
+    const ST_EEPROM_QUEUE_STATS &get_stats(void);
+
+  private:
+    typedef struct {
+      uint16_t addr;
+      uint8_t value;
+    } _ST_WRITE;
+    static void _on_ready(void *ctx);
+
+    // The oldest entry stays queued while it is written
+    SPSC<_ST_WRITE, EEPROM_QUEUE_SIZE> _queue;
+    volatile bool _running = false;
+    bool _writing = false;
+    done_fp _done = NULL;
+    void *_done_ctx = NULL;
+    ST_EEPROM_QUEUE_STATS _stats = { 0, 0, 0, 0 };
+};
+
+#endif // _EEPROM_QUEUE_H
@@ -0,0 +1,848 @@
+/*******************************************************************************
+ * @file    Hal.cpp
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ *******************************************************************************/
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "Hal.h"
+
+#ifdef ARDUINO
+#include <Wire.h>
+#include <EEPROM.h>
+#ifdef __AVR__
+#include <avr/sleep.h>
+#include <avr/wdt.h>
+#endif
+
+uint16_t hal_analog_read(uint8_t pin)
+{
+  return analogRead(pin);
+}
+
+void hal_pin_mode(uint8_t pin, uint8_t mode)
+{
+  pinMode(pin, mode);
+}
+
+uint32_t hal_millis(void)
+{
+  return millis();
+}
+
+uint32_t hal_micros(void)
+{
+  return micros();
+}
+
+#ifdef __AVR__
+static volatile hal_adc_isr_fp _adc_isr = NULL;
+static void * volatile _adc_ctx = NULL;
+
+ISR(ADC_vect)
+{
+  const uint16_t sample = ADC;
+
+  if (_adc_isr != NULL)
+    _adc_isr(_adc_ctx, sample);
+}
+
+bool hal_adc_start_free_running(uint8_t pin, hal_adc_isr_fp isr, void *ctx)
+{
+  const uint8_t channel = pin >= A0 ? pin - A0 : pin;
+
+  if (isr == NULL || _adc_isr != NULL)
+    return false;
+
+  _adc_ctx = ctx;
+  _adc_isr = isr;
+
+  ADCSRA = 0;
+  // ADTS[2:0] = 0: free running mode, MUX5 selects ADC8..ADC15
+#ifdef MUX5
+  ADCSRB = (channel & 0x08) ? _BV(MUX5) : 0;
+#else
+  ADCSRB = 0;
+#endif
+  // AVcc reference, as analogRead() with the DEFAULT reference
+  ADMUX = _BV(REFS0) | (channel & 0x07);
+  ADCSRA = _BV(ADEN) | _BV(ADSC) | _BV(ADATE) | _BV(ADIE) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+
+  return true;
+}
+
+void hal_adc_stop_free_running(void)
+{
+  // Back to the single conversion setup of the Arduino core
+  ADCSRA = _BV(ADEN) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+  _adc_isr = NULL;
+  _adc_ctx = NULL;
+}
+#else
+bool hal_adc_start_free_running(uint8_t pin, hal_adc_isr_fp isr, void *ctx)
+{
+  (void) pin;
+  (void) isr;
+  (void) ctx;
+
+  return false;
+}
+
+void hal_adc_stop_free_running(void)
+{
+}
+#endif
+
+void hal_idle(void)
+{
+#ifdef __AVR__
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  sleep_enable();
+  sleep_cpu();
+  sleep_disable();
+#endif
+}
+
+void hal_idle_until(uint32_t deadline_us)
+{
+  // Any interrupt wakes up, the caller checks its deadline again
+  (void) deadline_us;
+  hal_idle();
+}
+
+void hal_watchdog_reset(void)
+{
+#ifdef __AVR__
+  wdt_reset();
+#endif
+}
+
+#ifdef __AVR__
+// Not cleared at startup, written before the .bss is
+static uint8_t _reset_cause __attribute__((section(".noinit")));
+
+void _hal_save_reset_cause(void) __attribute__((naked, used, section(".init3")));
+void _hal_save_reset_cause(void)
+{
+  _reset_cause = MCUSR;
+  MCUSR = 0;
+  wdt_disable();
+}
+
+uint8_t hal_reset_cause(void)
+{
+  return _reset_cause & (HAL_RESET_POWER_ON | HAL_RESET_EXTERNAL | HAL_RESET_BROWN_OUT | HAL_RESET_WATCHDOG);
+}
+#else
+uint8_t hal_reset_cause(void)
+{
+  return 0;
+}
+#endif
+
+size_t hal_serial_write(const uint8_t *data, size_t len)
+{
+  return Serial.write(data, len);
+}
+
+int hal_serial_writable(void)
+{
+  return Serial.availableForWrite();
+}
+
+int hal_serial_read(void)
+{
+  return Serial.read();
+}
+
+void hal_delay_us(uint32_t us)
+{
+  // delayMicroseconds() is only accurate up to ~16ms
+  if (us >= 1000)
+    delay(us / 1000);
+  delayMicroseconds(us % 1000);
+}
+
+void hal_i2c_begin(uint32_t clock_hz)
+{
+  Wire.begin();
+  Wire.setClock(clock_hz);
+}
+
+bool hal_i2c_write(uint8_t address, const uint8_t *data, uint8_t len)
+{
+  Wire.beginTransmission(address);
+  Wire.write(data, len);
+
+  return Wire.endTransmission() == 0;
+}
+
+void hal_eeprom_update(uint16_t addr, uint8_t value)
+{
+  EEPROM.update(addr, value);
+}
+
+#ifdef __AVR__
+static volatile hal_eeprom_isr_fp _eeprom_isr = NULL;
+static void * volatile _eeprom_ctx = NULL;
+
+uint8_t hal_eeprom_read(uint16_t addr)
+{
+  const uint8_t sreg = SREG;
+  uint8_t value;
+
+  // With the interrupts off, else the EE_READY one would start the next
+  // queued write, changing EEAR, between the wait and the read
+  for (;;)
+  {
+    cli();
+    if (!(EECR & _BV(EEPE)))
+      break;
+    SREG = sreg;
+  }
+  EEAR = addr;
+  EECR |= _BV(EERE);
+  value = EEDR;
+  SREG = sreg;
+
+  return value;
+}
+
+ISR(EE_READY_vect)
+{
+  if (_eeprom_isr != NULL)
+    _eeprom_isr(_eeprom_ctx);
+  else
+    EECR &= ~_BV(EERIE);
+}
+
+void hal_eeprom_write_start(uint16_t addr, uint8_t value)
+{
+  const uint8_t sreg = SREG;
+
+  // EEPE must be set within 4 cycles of EEMPE, erase and write mode
+  cli();
+  EEAR = addr;
+  EEDR = value;
+  EECR = (EECR & _BV(EERIE)) | _BV(EEMPE);
+  EECR |= _BV(EEPE);
+  SREG = sreg;
+}
+
+bool hal_eeprom_is_ready(void)
+{
+  return !(EECR & _BV(EEPE));
+}
+
+bool hal_eeprom_start_ready_isr(hal_eeprom_isr_fp isr, void *ctx)
+{
+  if (isr == NULL || _eeprom_isr != NULL)
+    return false;
+
+  _eeprom_ctx = ctx;
+  _eeprom_isr = isr;
+  EECR |= _BV(EERIE);
+
+  return true;
+}
+
+void hal_eeprom_stop_ready_isr(void)
+{
+  EECR &= ~_BV(EERIE);
+  _eeprom_isr = NULL;
+  _eeprom_ctx = NULL;
+}
+#else
+uint8_t hal_eeprom_read(uint16_t addr)
+{
+  return EEPROM.read(addr);
+}
+
+void hal_eeprom_write_start(uint16_t addr, uint8_t value)
+{
+  EEPROM.write(addr, value);
+}
+
+bool hal_eeprom_is_ready(void)
+{
+  return true;
+}
+
+bool hal_eeprom_start_ready_isr(hal_eeprom_isr_fp isr, void *ctx)
+{
+  (void) isr;
+  (void) ctx;
+
+  return false;
+}
+
+void hal_eeprom_stop_ready_isr(void)
+{
+}
+#endif
+
+#else
+
+static uint16_t _adc_values[HAL_PIN_MAX] = {0};
+static hal_adc_source_fp _adc_source = NULL;
+static uint32_t _adc_conversion_us = 112;
+static uint32_t _adc_reads = 0;
+static uint64_t _time_us = 0;
+static hal_adc_isr_fp _adc_isr = NULL;
+static void *_adc_ctx = NULL;
+static uint8_t _adc_pin = 0;
+static uint64_t _adc_next_sample_us = 0;
+static bool _adc_free_running = true;
+static uint32_t _idles = 0;
+static bool _idle_skip = false;
+static uint32_t _watchdog_resets = 0;
+static uint8_t _reset_cause = HAL_RESET_POWER_ON;
+static uint32_t _serial_baud = 9600;
+static hal_serial_sink_fp _serial_sink = NULL;
+static uint32_t _serial_bytes = 0;
+static uint32_t _serial_blocked_us = 0;
+static uint8_t _serial_tx_level = 0;
+static uint64_t _serial_tx_ns = 0;
+static uint8_t _serial_rx[HAL_SERIAL_RX_BUFFER];
+static uint8_t _serial_rx_head = 0;
+static uint8_t _serial_rx_level = 0;
+static uint32_t _i2c_clock_hz = 100000;
+static hal_i2c_sink_fp _i2c_sink = NULL;
+static uint32_t _i2c_transactions = 0;
+static uint32_t _i2c_bytes = 0;
+static uint8_t _eeprom[HAL_EEPROM_SIZE];
+static uint32_t _eeprom_writes[HAL_EEPROM_SIZE] = {0};
+static uint32_t _eeprom_reads = 0;
+static hal_eeprom_isr_fp _eeprom_isr = NULL;
+static void *_eeprom_ctx = NULL;
+// Byte being written and when it is done
+static bool _eeprom_busy = false;
+static uint16_t _eeprom_addr = 0;
+static uint8_t _eeprom_value = 0;
+static uint64_t _eeprom_ready_us = 0;
+
+// Time to send a byte: start, 8 data and stop bits
+static uint64_t _serial_byte_ns(void)
+{
+  return 10000000000ULL / _serial_baud;
+}
+
+// Drains the TX buffer up to the current virtual time
+static void _serial_drain(void)
+{
+  const uint64_t now_ns = _time_us * 1000;
+
+  if (_serial_tx_level == 0)
+  {
+    _serial_tx_ns = now_ns;
+    return;
+  }
+
+  while (_serial_tx_level > 0 && _serial_tx_ns + _serial_byte_ns() <= now_ns)
+  {
+    _serial_tx_ns += _serial_byte_ns();
+    _serial_tx_level--;
+  }
+  if (_serial_tx_level == 0)
+    _serial_tx_ns = now_ns;
+}
+
+static uint16_t _adc_sample(uint8_t pin)
+{
+  uint16_t value = 0;
+
+  if (_adc_source != NULL)
+    value = _adc_source(pin);
+  else if (pin < HAL_PIN_MAX)
+    value = _adc_values[pin];
+
+  return value > HAL_ADC_MAX ? HAL_ADC_MAX : value;
+}
+
+uint16_t hal_analog_read(uint8_t pin)
+{
+  const uint16_t value = _adc_sample(pin);
+
+  _adc_reads++;
+  hal_sim_advance_us(_adc_conversion_us);
+
+  return value;
+}
+
+void hal_pin_mode(uint8_t pin, uint8_t mode)
+{
+  (void) pin;
+  (void) mode;
+}
+
+uint32_t hal_millis(void)
+{
+  return (uint32_t) (_time_us / 1000);
+}
+
+uint32_t hal_micros(void)
+{
+  return (uint32_t) _time_us;
+}
+
+bool hal_adc_start_free_running(uint8_t pin, hal_adc_isr_fp isr, void *ctx)
+{
+  if (isr == NULL || _adc_isr != NULL || !_adc_free_running)
+    return false;
+
+  _adc_pin = pin;
+  _adc_ctx = ctx;
+  _adc_isr = isr;
+  _adc_next_sample_us = _time_us + HAL_ADC_FREE_RUNNING_US;
+
+  return true;
+}
+
+void hal_adc_stop_free_running(void)
+{
+  _adc_isr = NULL;
+  _adc_ctx = NULL;
+}
+
+void hal_idle(void)
+{
+  _idles++;
+  hal_sim_advance_us(HAL_TICK_US - _time_us % HAL_TICK_US);
+}
+
+void hal_idle_until(uint32_t deadline_us)
+{
+  const uint32_t wait_us = deadline_us - (uint32_t) _time_us;
+  uint64_t wake_us = _time_us + wait_us;
+
+  // Past or wrapped deadlines, as a plain idle sleep
+  if (!_idle_skip || (int32_t) wait_us <= 0)
+  {
+    hal_idle();
+    return;
+  }
+
+  // The TX interrupt wakes up to refill the buffer
+  _serial_drain();
+  if (_serial_tx_level > 0)
+  {
+    const uint64_t drained_us = (_serial_tx_ns + _serial_tx_level * _serial_byte_ns() + 999) / 1000;
+
+    if (drained_us < wake_us)
+      wake_us = drained_us;
+  }
+
+  _idles++;
+  hal_sim_advance_us(wake_us - _time_us);
+}
+
+void hal_watchdog_reset(void)
+{
+  _watchdog_resets++;
+}
+
+uint8_t hal_reset_cause(void)
+{
+  return _reset_cause;
+}
+
+size_t hal_serial_write(const uint8_t *data, size_t len)
+{
+  for (size_t i = 0; i < len; i++)
+  {
+    _serial_drain();
+    if (_serial_tx_level == HAL_SERIAL_TX_BUFFER)
+    {
+      // Blocks until the next byte leaves the buffer
+      const uint64_t wait_us = (_serial_tx_ns + _serial_byte_ns() + 999) / 1000 - _time_us;
+
+      _serial_blocked_us += wait_us;
+      hal_sim_advance_us(wait_us);
+      _serial_drain();
+    }
+    _serial_tx_level++;
+  }
+  _serial_bytes += len;
+
+  if (_serial_sink != NULL)
+    _serial_sink(data, len);
+
+  return len;
+}
+
+int hal_serial_writable(void)
+{
+  _serial_drain();
+
+  return HAL_SERIAL_TX_BUFFER - _serial_tx_level;
+}
+
+int hal_serial_read(void)
+{
+  uint8_t c;
+
+  if (_serial_rx_level == 0)
+    return -1;
+
+  c = _serial_rx[_serial_rx_head];
+  _serial_rx_head = (_serial_rx_head + 1) % HAL_SERIAL_RX_BUFFER;
+  _serial_rx_level--;
+
+  return c;
+}
+
+void hal_delay_us(uint32_t us)
+{
+  hal_sim_advance_us(us);
+}
+
+void hal_i2c_begin(uint32_t clock_hz)
+{
+  _i2c_clock_hz = clock_hz > 0 ? clock_hz : 100000;
+}
+
+bool hal_i2c_write(uint8_t address, const uint8_t *data, uint8_t len)
+{
+  // Start, address and data bytes of 9 bits with the ACK, stop
+  const uint32_t bits = 1 + 9 * (1 + (uint32_t) len) + 1;
+
+  if (len > HAL_I2C_BUFFER)
+    return false;
+
+  _i2c_transactions++;
+  _i2c_bytes += len;
+  hal_sim_advance_us(((uint64_t) bits * 1000000 + _i2c_clock_hz - 1) / _i2c_clock_hz);
+
+  if (_i2c_sink != NULL)
+    _i2c_sink(address, data, len);
+
+  return true;
+}
+
+static void _eeprom_wait(void)
+{
+  if (_eeprom_busy)
+    hal_sim_advance_us(_eeprom_ready_us - _time_us);
+}
+
+uint8_t hal_eeprom_read(uint16_t addr)
+{
+  _eeprom_wait();
+  _eeprom_reads++;
+
+  return addr < HAL_EEPROM_SIZE ? _eeprom[addr] : 0xFF;
+}
+
+void hal_eeprom_update(uint16_t addr, uint8_t value)
+{
+  _eeprom_wait();
+  if (addr >= HAL_EEPROM_SIZE || _eeprom[addr] == value)
+    return;
+
+  _eeprom[addr] = value;
+  _eeprom_writes[addr]++;
+  hal_sim_advance_us(HAL_EEPROM_WRITE_US);
+}
+
+void hal_eeprom_write_start(uint16_t addr, uint8_t value)
+{
+  // Ignored while busy, like EEPE
+  if (_eeprom_busy)
+    return;
+
+  _eeprom_busy = true;
+  _eeprom_addr = addr;
+  _eeprom_value = value;
+  _eeprom_ready_us = _time_us + HAL_EEPROM_WRITE_US;
+}
+
+bool hal_eeprom_is_ready(void)
+{
+  return !_eeprom_busy;
+}
+
+bool hal_eeprom_start_ready_isr(hal_eeprom_isr_fp isr, void *ctx)
+{
+  if (isr == NULL || _eeprom_isr != NULL)
+    return false;
+
+  _eeprom_ctx = ctx;
+  _eeprom_isr = isr;
+  // Fires at once if the EEPROM is ready
+  if (!_eeprom_busy)
+    _eeprom_isr(_eeprom_ctx);
+
+  return true;
+}
+
+void hal_eeprom_stop_ready_isr(void)
+{
+  _eeprom_isr = NULL;
+  _eeprom_ctx = NULL;
+}
+
+void hal_sim_reset(void)
+{
+  for (uint8_t i = 0; i < HAL_PIN_MAX; i++)
+    _adc_values[i] = 0;
+  _adc_source = NULL;
+  _adc_conversion_us = 112;
+  _adc_reads = 0;
+  _time_us = 0;
+  _adc_isr = NULL;
+  _adc_ctx = NULL;
+  _adc_free_running = true;
+  _idles = 0;
+  _idle_skip = false;
+  _watchdog_resets = 0;
+  _reset_cause = HAL_RESET_POWER_ON;
+  _serial_baud = 9600;
+  _serial_sink = NULL;
+  _serial_bytes = 0;
+  _serial_blocked_us = 0;
+  _serial_tx_level = 0;
+  _serial_tx_ns = 0;
+  _serial_rx_head = 0;
+  _serial_rx_level = 0;
+  _i2c_clock_hz = 100000;
+  _i2c_sink = NULL;
+  _i2c_transactions = 0;
+  _i2c_bytes = 0;
+  memset(_eeprom, 0xFF, sizeof(_eeprom));
+  memset(_eeprom_writes, 0, sizeof(_eeprom_writes));
+  _eeprom_reads = 0;
+  _eeprom_isr = NULL;
+  _eeprom_ctx = NULL;
+  _eeprom_busy = false;
+}
+
+void hal_sim_set_adc_value(uint8_t pin, uint16_t value)
+{
+  if (pin < HAL_PIN_MAX)
+    _adc_values[pin] = value;
+}
+
+void hal_sim_set_adc_source(hal_adc_source_fp source)
+{
+  _adc_source = source;
+}
+
+void hal_sim_set_adc_conversion_us(uint32_t us)
+{
+  _adc_conversion_us = us;
+}
+
+void hal_sim_set_adc_free_running(bool available)
+{
+  _adc_free_running = available;
+}
+
+uint32_t hal_sim_get_adc_reads(void)
+{
+  return _adc_reads;
+}
+
+void hal_sim_advance_us(uint64_t us)
+{
+  const uint64_t end = _time_us + us;
+
+  // Deliver the free-running conversions and the EEPROM writes that complete
+  // within the interval, in time order
+  for (;;)
+  {
+    const bool adc = _adc_isr != NULL && _adc_next_sample_us <= end;
+    const bool eeprom = _eeprom_busy && _eeprom_ready_us <= end;
+
+    if (eeprom && (!adc || _eeprom_ready_us <= _adc_next_sample_us))
+    {
+      _time_us = _eeprom_ready_us;
+      _eeprom_busy = false;
+      // Erase and write, wears the cell even with the same value
+      if (_eeprom_addr < HAL_EEPROM_SIZE)
+      {
+        _eeprom[_eeprom_addr] = _eeprom_value;
+        _eeprom_writes[_eeprom_addr]++;
+      }
+      if (_eeprom_isr != NULL)
+        _eeprom_isr(_eeprom_ctx);
+    }
+    else if (adc)
+    {
+      _time_us = _adc_next_sample_us;
+      _adc_next_sample_us += HAL_ADC_FREE_RUNNING_US;
+      _adc_isr(_adc_ctx, _adc_sample(_adc_pin));
+    }
+    else
+    {
+      break;
+    }
+  }
+  _time_us = end;
+}
+
+uint64_t hal_sim_get_time_us(void)
+{
+  return _time_us;
+}
+
+void hal_sim_set_idle_skip(bool skip)
+{
+  _idle_skip = skip;
+}
+
+uint32_t hal_sim_get_idles(void)
+{
+  return _idles;
+}
+
+uint32_t hal_sim_get_watchdog_resets(void)
+{
+  return _watchdog_resets;
+}
+
+void hal_sim_set_reset_cause(uint8_t cause)
+{
+  _reset_cause = cause;
+}
+
+void hal_sim_set_serial_baud(uint32_t baud)
+{
+  _serial_drain();
+  _serial_baud = baud > 0 ? baud : 9600;
+}
+
+void hal_sim_set_serial_sink(hal_serial_sink_fp sink)
+{
+  _serial_sink = sink;
+}
+
+uint32_t hal_sim_get_serial_bytes(void)
+{
+  return _serial_bytes;
+}
+
+uint32_t hal_sim_get_serial_blocked_us(void)
+{
+  return _serial_blocked_us;
+}
+
+size_t hal_sim_serial_receive(const uint8_t *data, size_t len)
+{
+  size_t n = 0;
+
+  for (; n < len && _serial_rx_level < HAL_SERIAL_RX_BUFFER; n++)
+  {
+    _serial_rx[(_serial_rx_head + _serial_rx_level) % HAL_SERIAL_RX_BUFFER] = data[n];
+    _serial_rx_level++;
+  }
+
+  return n;
+}
+
+void hal_sim_set_i2c_sink(hal_i2c_sink_fp sink)
+{
+  _i2c_sink = sink;
+}
+
+uint32_t hal_sim_get_i2c_transactions(void)
+{
+  return _i2c_transactions;
+}
+
+uint32_t hal_sim_get_i2c_bytes(void)
+{
+  return _i2c_bytes;
+}
+
+uint8_t *hal_sim_get_eeprom(void)
+{
+  return _eeprom;
+}
+
+uint32_t hal_sim_get_eeprom_writes(uint16_t addr)
+{
+  return addr < HAL_EEPROM_SIZE ? _eeprom_writes[addr] : 0;
+}
+
+uint32_t hal_sim_get_eeprom_reads(void)
+{
+  return _eeprom_reads;
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+  size_t n = 0;
+
+  while (size--)
+    n += this->write(*buffer++);
+
+  return n;
+}
+
+size_t Print::write(const char *str)
+{
+  return str == NULL ? 0 : this->write((const uint8_t *) str, strlen(str));
+}
+
+size_t Print::print(const char *str)
+{
+  return this->write(str);
+}
+
+size_t Print::print(char c)
+{
+  return this->write((uint8_t) c);
+}
+
+size_t Print::print(unsigned long n, int base)
+{
+  char buf[8 * sizeof(long) + 1];
+
+  snprintf(buf, sizeof(buf), base == HEX ? "%lX" : "%lu", n);
+
+  return this->write(buf);
+}
+
+size_t Print::print(long n, int base)
+{
+  char buf[8 * sizeof(long) + 2];
+
+  if (base != DEC)
+    return this->print((unsigned long) n, base);
+  snprintf(buf, sizeof(buf), "%ld", n);
+
+  return this->write(buf);
+}
+
+size_t Print::print(unsigned int n, int base)
+{
+  return this->print((unsigned long) n, base);
+}
+
+size_t Print::print(int n, int base)
+{
+  return this->print((long) n, base);
+}
+
+size_t Print::print(unsigned char n, int base)
+{
+  return this->print((unsigned long) n, base);
+}
+
+size_t Print::print(double n, int digits)
+{
+  char buf[48];
+
+  snprintf(buf, sizeof(buf), "%.*f", digits, n);
+
+  return this->write(buf);
+}
+
+size_t Print::println(void)
+{
+  return this->write("\r\n");
+}
+
+#endif
@@ -0,0 +1,230 @@
+/*******************************************************************************
+ * @file    Hal.h
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Thin hardware abstraction layer for the MQ3 and TFSM libraries.
+ *          On an Arduino target the functions forward to the Arduino core
+ *          (analogRead, pinMode, millis, micros). On the host ("native"
+ *          PlatformIO env) they run against a simulated ADC and a virtual
+ *          clock, so that the libraries can be unit tested and profiled
+ *          without flashing a board.
+ *
+ *          Host simulation:
+ *            - ADC: every pin returns a fixed value set with
+ *                   hal_sim_set_adc_value(), unless a source callback is
+ *                   installed with hal_sim_set_adc_source().
+ *            - Clock: virtual time in us. It only moves when advanced with
+ *                     hal_sim_advance_us() or by an ADC conversion, which
+ *                     costs hal_sim_set_adc_conversion_us() (112us by
+ *                     default, the analogRead() time of an ATmega2560).
+ *            - Free-running ADC: while started, advancing the virtual clock
+ *                     calls the sample callback once every
+ *                     HAL_ADC_FREE_RUNNING_US, like the ADC interrupt does.
+ *                     hal_sim_set_adc_free_running(false) makes
+ *                     hal_adc_start_free_running() fail, as on a target
+ *                     without it.
+ *            - Idle sleep: hal_idle() advances the virtual clock to the next
+ *                     Timer0 overflow (every HAL_TICK_US), the interrupt that
+ *                     wakes the MCU up on target. With
+ *                     hal_sim_set_idle_skip() hal_idle_until() skips the
+ *                     ticks with nothing to do and advances straight to its
+ *                     deadline, or to the time the serial TX buffer drains
+ *                     if earlier, for replays of hours in virtual time.
+ *            - Serial: a HAL_SERIAL_TX_BUFFER bytes TX buffer drained at the
+ *                     baud rate of hal_sim_set_serial_baud() (9600 by
+ *                     default) in virtual time. Writing to a full buffer
+ *                     blocks, i.e. advances the virtual clock, as on target.
+ *                     The sent bytes are passed to hal_sim_set_serial_sink().
+ *                     hal_sim_serial_receive() puts bytes in the
+ *                     HAL_SERIAL_RX_BUFFER bytes RX buffer at once, the bytes
+ *                     that do not fit are lost, as on target.
+ *            - I2C: hal_i2c_write() advances the virtual clock by the bus time
+ *                     of the transaction (start, address, data, stop) at the
+ *                     clock of hal_i2c_begin(), counts the transactions and
+ *                     bytes, and passes the data to hal_sim_set_i2c_sink().
+ *            - Delays: hal_delay_us() advances the virtual clock.
+ *            - EEPROM: HAL_EEPROM_SIZE bytes, erased (0xFF) by
+ *                     hal_sim_reset(). Every byte written takes
+ *                     HAL_EEPROM_WRITE_US of virtual time and counts as a
+ *                     write of its cell, for wear measurements.
+ *                     hal_eeprom_update() advances the virtual clock, a
+ *                     byte of hal_eeprom_write_start() is stored when its
+ *                     time has passed, then the ready interrupt is called.
+ *                     Accessing the EEPROM meanwhile waits for it, as on
+ *                     target.
+ *            - Reset cause: HAL_RESET_POWER_ON unless set with
+ *                     hal_sim_set_reset_cause().
+ *            - Print: a minimal version of the Arduino Print class, so that
+ *                     Print based classes build on the host.
+ *
+ *          Free-running ADC: hal_adc_start_free_running() puts the ADC in
+ *          free-running mode on one pin and calls the callback from the ADC
+ *          conversion complete interrupt with every sample. Only one pin can
+ *          be sampled this way and analogRead() must not be used meanwhile.
+ *
+ *          I2C: hal_i2c_write() is one Wire write transaction of at most
+ *          HAL_I2C_BUFFER bytes, the buffer size of the Arduino core Wire.
+ *
+ *          EEPROM: hal_eeprom_update() only writes a byte that differs, like
+ *          EEPROM.update(), since every write wears the cell. It waits for
+ *          the previous write, so consecutive bytes block for
+ *          HAL_EEPROM_WRITE_US each. hal_eeprom_write_start() only starts
+ *          the write of a byte and returns. With
+ *          hal_eeprom_start_ready_isr() the callback is called from the
+ *          EEPROM ready interrupt while the EEPROM is ready. The interrupt
+ *          is level triggered, so the callback must either start a write
+ *          or stop the interrupt.
+ *
+ *          Reset cause: the HAL_RESET_* flags of MCUSR, saved and cleared
+ *          before main() (the watchdog can only be disabled with WDRF
+ *          cleared). 0 if unknown, e.g. cleared by a bootloader.
+ *
+ *          Idle sleep: hal_idle() puts the MCU in idle sleep mode until the
+ *          next interrupt. The Arduino core Timer0 overflow interrupt (millis)
+ *          guarantees a wake up at least every HAL_TICK_US.
+ *          hal_idle_until() is the same for a caller with nothing to do
+ *          before a deadline (hal_micros() time), it may wake up earlier and
+ *          must be called again until the deadline.
+*******************************************************************************/
+
+#ifndef _HAL_H
+#define _HAL_H
+
+#include <stdint.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#ifndef INPUT
+#define INPUT 0x0
+#endif
+#ifndef OUTPUT
+#define OUTPUT 0x1
+#endif
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *) (addr))
+#define pgm_read_word(addr) (*(const uint16_t *) (addr))
+#define pgm_read_dword(addr) (*(const uint32_t *) (addr))
+#define pgm_read_ptr(addr) (*(void * const *) (addr))
+#define F(str) (str)
+#ifndef A0
+// Arduino Mega analog pin numbering
+#define A0 54
+#define A1 55
+#define A2 56
+#define A3 57
+#define A4 58
+#define A5 59
+#define A6 60
+#define A7 61
+#endif
+
+#include <stddef.h>
+
+#define DEC 10
+#define HEX 16
+
+class Print
+{
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    size_t write(const char *str);
+    size_t print(const char *str);
+    size_t print(char c);
+    size_t print(unsigned long n, int base=DEC);
+    size_t print(long n, int base=DEC);
+    size_t print(unsigned int n, int base=DEC);
+    size_t print(int n, int base=DEC);
+    size_t print(unsigned char n, int base=DEC);
+    size_t print(double n, int digits=2);
+    size_t println(void);
+    template <typename T>
+    size_t println(T value) { const size_t n = print(value); return n + println(); }
+    template <typename T>
+    size_t println(T value, int format) { const size_t n = print(value, format); return n + println(); }
+};
+#endif
+
+#define HAL_ADC_MAX 1023U
+#define HAL_PIN_MAX 70U
+// 16MHz / 128 prescaler / 13 ADC clocks per conversion = ~9615 samples/s
+#define HAL_ADC_FREE_RUNNING_US 104U
+// Timer0 overflow period of the Arduino core at 16MHz
+#define HAL_TICK_US 1024U
+// TX buffer of the Arduino core HardwareSerial
+#define HAL_SERIAL_TX_BUFFER 64U
+// RX buffer of the Arduino core HardwareSerial
+#define HAL_SERIAL_RX_BUFFER 64U
+// Buffer of the Arduino core Wire, the largest transaction
+#define HAL_I2C_BUFFER 32U
+// EEPROM of the ATmega2560 and its erase and write time per byte
+#define HAL_EEPROM_SIZE 4096U
+#define HAL_EEPROM_WRITE_US 3400U
+// Reset causes, the MCUSR flags
+#define HAL_RESET_POWER_ON 0x01U
+#define HAL_RESET_EXTERNAL 0x02U
+#define HAL_RESET_BROWN_OUT 0x04U
+#define HAL_RESET_WATCHDOG 0x08U
+
+typedef void (*hal_adc_isr_fp)(void *ctx, uint16_t sample);
+typedef void (*hal_eeprom_isr_fp)(void *ctx);
+
+uint16_t hal_analog_read(uint8_t pin);
+void hal_pin_mode(uint8_t pin, uint8_t mode);
+uint32_t hal_millis(void);
+uint32_t hal_micros(void);
+bool hal_adc_start_free_running(uint8_t pin, hal_adc_isr_fp isr, void *ctx);
+void hal_adc_stop_free_running(void);
+void hal_idle(void);
+void hal_idle_until(uint32_t deadline_us);
+void hal_watchdog_reset(void);
+uint8_t hal_reset_cause(void);
+size_t hal_serial_write(const uint8_t *data, size_t len);
+int hal_serial_writable(void);
+// Next received byte, -1 if none
+int hal_serial_read(void);
+void hal_delay_us(uint32_t us);
+void hal_i2c_begin(uint32_t clock_hz);
+bool hal_i2c_write(uint8_t address, const uint8_t *data, uint8_t len);
+// Waits for the write in progress, safe while the ready interrupt writes
+uint8_t hal_eeprom_read(uint16_t addr);
+void hal_eeprom_update(uint16_t addr, uint8_t value);
+void hal_eeprom_write_start(uint16_t addr, uint8_t value);
+bool hal_eeprom_is_ready(void);
+bool hal_eeprom_start_ready_isr(hal_eeprom_isr_fp isr, void *ctx);
+void hal_eeprom_stop_ready_isr(void);
+
+#ifndef ARDUINO
+typedef uint16_t (*hal_adc_source_fp)(uint8_t pin);
+typedef void (*hal_serial_sink_fp)(const uint8_t *data, size_t len);
+typedef void (*hal_i2c_sink_fp)(uint8_t address, const uint8_t *data, uint8_t len);
+
+void hal_sim_reset(void);
+void hal_sim_set_adc_value(uint8_t pin, uint16_t value);
+void hal_sim_set_adc_source(hal_adc_source_fp source);
+void hal_sim_set_adc_conversion_us(uint32_t us);
+void hal_sim_set_adc_free_running(bool available);
+uint32_t hal_sim_get_adc_reads(void);
+void hal_sim_advance_us(uint64_t us);
+uint64_t hal_sim_get_time_us(void);
+void hal_sim_set_idle_skip(bool skip);
+uint32_t hal_sim_get_idles(void);
+uint32_t hal_sim_get_watchdog_resets(void);
+void hal_sim_set_reset_cause(uint8_t cause);
+void hal_sim_set_serial_baud(uint32_t baud);
+void hal_sim_set_serial_sink(hal_serial_sink_fp sink);
+uint32_t hal_sim_get_serial_bytes(void);
+uint32_t hal_sim_get_serial_blocked_us(void);
+// Returns the number of bytes that fit in the RX buffer
+size_t hal_sim_serial_receive(const uint8_t *data, size_t len);
+void hal_sim_set_i2c_sink(hal_i2c_sink_fp sink);
+uint32_t hal_sim_get_i2c_transactions(void);
+uint32_t hal_sim_get_i2c_bytes(void);
+uint8_t *hal_sim_get_eeprom(void);
+uint32_t hal_sim_get_eeprom_writes(uint16_t addr);
+uint32_t hal_sim_get_eeprom_reads(void);
+#endif
+
+#endif // _HAL_H
@@ -0,0 +1,267 @@
+/*******************************************************************************
+ * @file    History.cpp
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ *******************************************************************************/
+
+#include <string.h>
+#include "History.h"
+
+static const ST_HISTORY_RECORD zero = { 0, 0, 0, 0 };
+
+uint32_t history_zigzag(int32_t value)
+{
+  return ((uint32_t) value << 1) ^ (uint32_t) (value < 0 ? -1 : 0);
+}
+
+int32_t history_unzigzag(uint32_t value)
+{
+  return (int32_t) ((value >> 1) ^ (0U - (value & 1)));
+}
+
+uint8_t history_varint_encode(uint32_t value, uint8_t *out)
+{
+  uint8_t len = 0;
+
+  while (value >= 0x80)
+  {
+    out[len++] = (uint8_t) value | 0x80;
+    value >>= 7;
+  }
+  out[len++] = (uint8_t) value;
+
+  return len;
+}
+
+uint8_t history_varint_decode(const uint8_t *data, uint32_t &value)
+{
+  uint8_t len = 0;
+
+  value = 0;
+  do
+  {
+    value |= (uint32_t) (data[len] & 0x7F) << (7 * len);
+  }
+  while ((data[len++] & 0x80) && len < HISTORY_VARINT_MAX);
+
+  return len;
+}
+
+int16_t history_decode_block(const uint8_t *block, uint8_t len, ST_HISTORY_RECORD *records, uint8_t max)
+{
+  // Zeros past the end, a truncated varint stops there
+  uint8_t data[HISTORY_BLOCK_SIZE + HISTORY_RECORD_MAX];
+  ST_HISTORY_RECORD prev = zero;
+  uint8_t pos = 1;
+
+  if (len == 0 || len > HISTORY_BLOCK_SIZE || block[0] > max)
+    return -1;
+  memset(data, 0, sizeof(data));
+  memcpy(data, block, len);
+
+  for (uint8_t i = 0; i < data[0]; i++)
+  {
+    if (pos >= len)
+      return -1;
+    pos += HISTORY::_decode(&data[pos], prev, records[i]);
+    prev = records[i];
+  }
+
+  return pos == len ? data[0] : -1;
+}
+
+HISTORY::HISTORY(uint8_t *buf, uint16_t size)
+{
+  this->_buf = buf;
+  this->_blocks = buf != NULL ? size / HISTORY_BLOCK_SIZE : 0;
+}
+
+void HISTORY::append(const ST_HISTORY_RECORD &record)
+{
+  uint8_t data[HISTORY_RECORD_MAX];
+  uint8_t len = 0;
+
+  if (this->_blocks == 0)
+    return;
+
+  if (this->_end != this->_first)
+    len = _encode(record, this->_prev, data);
+  if (this->_end == this->_first || this->_pos + len > HISTORY_BLOCK_SIZE)
+  {
+    this->_start_block();
+    len = _encode(record, zero, data);
+  }
+
+  uint8_t *block = this->_block(this->_end - 1);
+
+  memcpy(&block[this->_pos], data, len);
+  block[0]++;
+  this->_pos += len;
+  this->_prev = record;
+  this->_count++;
+  this->_stats.records++;
+  this->_stats.bytes += len;
+}
+
+void HISTORY::clear(void)
+{
+  this->_stats.dropped += this->_count;
+  this->_count = 0;
+  this->_first = this->_end;
+  this->_first_index = 0;
+  this->_pos = 0;
+}
+
+uint16_t HISTORY::get_count(void)
+{
+  return this->_count;
+}
+
+const ST_HISTORY_STATS &HISTORY::get_stats(void)
+{
+  return this->_stats;
+}
+
+void HISTORY::begin(ST_HISTORY_CURSOR &cursor)
+{
+  cursor.block = this->_first;
+  cursor.pos = 1;
+  cursor.read = 0;
+  cursor.index = this->_stats.dropped;
+  cursor.lost = 0;
+  cursor.prev = zero;
+}
+
+bool HISTORY::next(ST_HISTORY_CURSOR &cursor, ST_HISTORY_RECORD &record)
+{
+  // Its block was dropped, from the oldest one
+  if ((int16_t) (cursor.block - this->_first) < 0)
+  {
+    const uint32_t lost = cursor.lost + (this->_stats.dropped - cursor.index);
+
+    this->begin(cursor);
+    cursor.lost = lost;
+  }
+
+  while (true)
+  {
+    if (cursor.block == this->_end)
+      return false;
+    if (cursor.read < this->_block(cursor.block)[0])
+      break;
+    // The newest block, more may follow
+    if ((uint16_t) (cursor.block + 1) == this->_end)
+      return false;
+    cursor.block++;
+    cursor.pos = 1;
+    cursor.read = 0;
+    cursor.prev = zero;
+  }
+
+  cursor.pos += _decode(&this->_block(cursor.block)[cursor.pos], cursor.prev, record);
+  cursor.read++;
+  cursor.index++;
+  cursor.prev = record;
+
+  return true;
+}
+
+uint8_t HISTORY::next_block(ST_HISTORY_CURSOR &cursor, uint8_t out[HISTORY_BLOCK_SIZE])
+{
+  ST_HISTORY_RECORD record = zero;
+  uint8_t len = 1;
+
+  // Its block was dropped, from the oldest one
+  if ((int16_t) (cursor.block - this->_first) < 0)
+  {
+    const uint32_t lost = cursor.lost + (this->_stats.dropped - cursor.index);
+
+    this->begin(cursor);
+    cursor.lost = lost;
+  }
+  if (cursor.block == this->_end)
+    return 0;
+
+  const uint8_t *block = this->_block(cursor.block);
+
+  if ((uint16_t) (cursor.block + 1) == this->_end)
+  {
+    len = this->_pos;
+  }
+  else
+  {
+    for (uint8_t i = 0; i < block[0]; i++)
+      len += _decode(&block[len], record, record);
+  }
+  memcpy(out, block, len);
+
+  cursor.index += block[0] - cursor.read;
+  cursor.block++;
+  cursor.pos = 1;
+  cursor.read = 0;
+  cursor.prev = zero;
+
+  return len;
+}
+
+/***************************/
+/* Private methods         */
+/***************************/
+
+uint8_t *HISTORY::_block(uint16_t seq)
+{
+  const uint16_t index = (this->_first_index + (uint16_t) (seq - this->_first)) % this->_blocks;
+
+  return &this->_buf[index * HISTORY_BLOCK_SIZE];
+}
+
+void HISTORY::_start_block(void)
+{
+  // The rest of the newest block stays unused
+  if (this->_end != this->_first)
+    this->_stats.bytes += HISTORY_BLOCK_SIZE - this->_pos;
+
+  if ((uint16_t) (this->_end - this->_first) == this->_blocks)
+  {
+    const uint8_t records = this->_block(this->_first)[0];
+
+    this->_count -= records;
+    this->_stats.dropped += records;
+    this->_first++;
+    this->_first_index = (this->_first_index + 1) % this->_blocks;
+  }
+
+  this->_end++;
+  this->_block(this->_end - 1)[0] = 0;
+  this->_pos = 1;
+  this->_stats.bytes++;
+}
+
+uint8_t HISTORY::_encode(const ST_HISTORY_RECORD &record, const ST_HISTORY_RECORD &prev, uint8_t *out)
+{
+  uint8_t len = 0;
+
+  len += history_varint_encode(history_zigzag((int32_t) (record.time_s - prev.time_s)), &out[len]);
+  len += history_varint_encode(history_zigzag((int32_t) (record.mgL_milli - prev.mgL_milli)), &out[len]);
+  len += history_varint_encode(history_zigzag((int32_t) (record.rs - prev.rs)), &out[len]);
+  len += history_varint_encode(history_zigzag((int32_t) record.temperature - prev.temperature), &out[len]);
+
+  return len;
+}
+
+uint8_t HISTORY::_decode(const uint8_t *data, const ST_HISTORY_RECORD &prev, ST_HISTORY_RECORD &record)
+{
+  uint8_t len = 0;
+  uint32_t delta;
+
+  len += history_varint_decode(&data[len], delta);
+  record.time_s = prev.time_s + (uint32_t) history_unzigzag(delta);
+  len += history_varint_decode(&data[len], delta);
+  record.mgL_milli = prev.mgL_milli + (uint32_t) history_unzigzag(delta);
+  len += history_varint_decode(&data[len], delta);
+  record.rs = prev.rs + (uint32_t) history_unzigzag(delta);
+  len += history_varint_decode(&data[len], delta);
+  record.temperature = (int16_t) (prev.temperature + history_unzigzag(delta));
+
+  return len;
+}
@@ -0,0 +1,136 @@
+/*******************************************************************************
+ * @file    History.h
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Compressed history of the readings in a caller provided RAM ring.
+ *          A record is a timestamp in s, mg/L in thousandths, Rs in Ohm
+ *          and the temperature in 0.01 degC (HISTORY_NO_TEMP if none), 14
+ *          bytes as fixed size fields (HISTORY_RAW_SIZE).
+ *
+ *          The ring is split in blocks of HISTORY_BLOCK_SIZE bytes:
+ *
+ *            offset  size  field
+ *            0       1     number of records in the block
+ *            1       ...   records, up to HISTORY_RECORD_MAX bytes each
+ *
+ *          Every field of a record is stored as the difference to the same
+ *          field of the previous record of the block, zig-zag mapped
+ *          (0, -1, 1, -2, ... to 0, 1, 2, 3, ...) and as an LEB128 varint,
+ *          7 bits per byte, the low ones first, the top bit set on all but
+ *          the last byte. The first record of a block is the difference to
+ *          0, so a block decodes on its own. Readings a second apart change
+ *          little, a record is 4 to 6 bytes instead of 14.
+ *
+ *          When the ring is full the oldest block is dropped whole, so the
+ *          history keeps between size - HISTORY_BLOCK_SIZE and size bytes of
+ *          the newest records. The bytes left at the end of a block when the
+ *          next record does not fit are unused.
+ *
+ *          Reading: an ST_HISTORY_CURSOR walks the records from the oldest
+ *          one, one at a time, while more are appended. A cursor that falls
+ *          behind the oldest block skips to it and counts the records it
+ *          lost.
+ *
+ *          Dump: next_block() copies the blocks as they are, compressed,
+ *          e.g. to send them. history_decode_block() decodes such a copy.
+ *
+ *          Statistics: records appended and dropped and the bytes of the ring
+ *          they took, with the block headers and the unused bytes, the
+ *          compression ratio is records * HISTORY_RAW_SIZE / bytes.
+*******************************************************************************/
+
+#ifndef _HISTORY_H
+#define _HISTORY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define HISTORY_NO_TEMP INT16_MIN
+#define HISTORY_BLOCK_SIZE 128U
+#define HISTORY_FIELDS 4U
+// A 32-bit varint is at most 5 bytes
+#define HISTORY_VARINT_MAX 5U
+#define HISTORY_RECORD_MAX (HISTORY_FIELDS * HISTORY_VARINT_MAX)
+// Timestamp, mg/L and Rs of 4 bytes, temperature of 2
+#define HISTORY_RAW_SIZE 14U
+// A record is at least a byte per field
+#define HISTORY_BLOCK_RECORDS_MAX ((HISTORY_BLOCK_SIZE - 1U) / HISTORY_FIELDS)
+
+typedef struct {
+  uint32_t time_s;
+  uint32_t mgL_milli;
+  uint32_t rs;
+  int16_t temperature;
+} ST_HISTORY_RECORD;
+
+typedef struct {
+  uint32_t records;
+  uint32_t bytes;
+  uint32_t dropped;
+} ST_HISTORY_STATS;
+
+typedef struct {
+  // Sequence number of the block, the position in it and its records read
+  uint16_t block;
+  uint8_t pos;
+  uint8_t read;
+  // Number of the next record since the first one appended
+  uint32_t index;
+  uint32_t lost;
+  ST_HISTORY_RECORD prev;
+} ST_HISTORY_CURSOR;
+
+uint32_t history_zigzag(int32_t value);
+int32_t history_unzigzag(uint32_t value);
+// Return the number of bytes written or read
+uint8_t history_varint_encode(uint32_t value, uint8_t *out);
+uint8_t history_varint_decode(const uint8_t *data, uint32_t &value);
+// Decodes a block copied by HISTORY::next_block(), returns the number of
+// records or -1 if the block is malformed or holds more than max
+int16_t history_decode_block(const uint8_t *block, uint8_t len, ST_HISTORY_RECORD *records, uint8_t max);
+
+class HISTORY
+{
+  public:
+    // Ring of size / HISTORY_BLOCK_SIZE blocks, keeps nothing if none
+    HISTORY(uint8_t *buf, uint16_t size);
+    void append(const ST_HISTORY_RECORD &record);
+    // Drops every record, the cursors count them as lost
+    void clear(void);
+    // Records held
+    uint16_t get_count(void);
+    const ST_HISTORY_STATS &get_stats(void);
+    // At the oldest record
+    void begin(ST_HISTORY_CURSOR &cursor);
+    // Returns false when past the newest record
+    bool next(ST_HISTORY_CURSOR &cursor, ST_HISTORY_RECORD &record);
+    // Copies the block of the cursor from its record count to its last
+    // record and moves to the next block, returns the number of bytes, 0
+    // when past the newest block. The newest block is copied as it is, the
+    // records appended to it afterwards are not returned. A cursor within a
+    // block copies it whole.
+    uint8_t next_block(ST_HISTORY_CURSOR &cursor, uint8_t out[HISTORY_BLOCK_SIZE]);
+
+  private:
+    friend int16_t history_decode_block(const uint8_t *block, uint8_t len, ST_HISTORY_RECORD *records, uint8_t max);
+
+    uint8_t *_block(uint16_t seq);
+    void _start_block(void);
+    static uint8_t _encode(const ST_HISTORY_RECORD &record, const ST_HISTORY_RECORD &prev, uint8_t *out);
+    static uint8_t _decode(const uint8_t *data, const ST_HISTORY_RECORD &prev, ST_HISTORY_RECORD &record);
+
+    uint8_t *_buf;
+    uint16_t _blocks;
+    // Sequence numbers of the oldest block and of the next one, the ring
+    // holds the blocks in between, the oldest one at _first_index
+    uint16_t _first = 0;
+    uint16_t _first_index = 0;
+    uint16_t _end = 0;
+    // Write position in the newest block
+    uint8_t _pos = 0;
+    uint16_t _count = 0;
+    ST_HISTORY_RECORD _prev = { 0, 0, 0, 0 };
+    ST_HISTORY_STATS _stats = { 0, 0, 0 };
+};
+
+#endif // _HISTORY_H
@@ -0,0 +1,178 @@
+/*******************************************************************************
+ * @file    LcdI2c.cpp
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ *******************************************************************************/
+
+#include "LcdI2c.h"
+
+// PCF8574 pins
+#define _RS 0x01
+#define _EN 0x04
+#define _BACKLIGHT 0x08
+
+// HD44780 commands
+#define _CLEAR 0x01
+#define _HOME 0x02
+#define _ENTRY_LEFT 0x06
+#define _DISPLAY_ON 0x0C
+#define _FUNCTION_4BIT_2LINES 0x28
+#define _SET_DDRAM 0x80
+// Execution time of clear and home
+#define _CLEAR_US 2000
+
+static const uint8_t _row_offsets[] = { 0x00, 0x40, 0x14, 0x54 };
+
+LCD_I2C::LCD_I2C(uint8_t address, uint8_t cols, uint8_t rows)
+{
+  this->_address = address;
+  this->_cols = cols;
+  this->_rows = rows < 1 ? 1 : rows > sizeof(_row_offsets) ? sizeof(_row_offsets) : rows;
+  this->_backlight = 0;
+}
+
+void LCD_I2C::init(void)
+{
+  hal_i2c_begin(LCD_I2C_CLOCK);
+  this->_tx_len = 0;
+
+  // Power on, then the 8-bit to 4-bit mode sequence of the HD44780 datasheet
+  hal_delay_us(50000);
+  this->_queue(this->_backlight);
+  this->flush();
+  this->_nibble(0x30, 0);
+  this->flush();
+  hal_delay_us(4500);
+  this->_nibble(0x30, 0);
+  this->flush();
+  hal_delay_us(4500);
+  this->_nibble(0x30, 0);
+  this->flush();
+  hal_delay_us(150);
+  this->_nibble(0x20, 0);
+  this->flush();
+  hal_delay_us(150);
+
+  this->_command(_FUNCTION_4BIT_2LINES);
+  this->_command(_DISPLAY_ON);
+  this->clear();
+  this->_command(_ENTRY_LEFT);
+  this->flush();
+}
+
+void LCD_I2C::backlight(void)
+{
+  this->_backlight = _BACKLIGHT;
+  this->_queue(this->_last | _BACKLIGHT);
+  this->flush();
+}
+
+void LCD_I2C::noBacklight(void)
+{
+  this->_backlight = 0;
+  this->_queue(this->_last & ~_BACKLIGHT);
+  this->flush();
+}
+
+void LCD_I2C::clear(void)
+{
+  this->_command(_CLEAR);
+  this->flush();
+  hal_delay_us(_CLEAR_US);
+}
+
+void LCD_I2C::home(void)
+{
+  this->_command(_HOME);
+  this->flush();
+  hal_delay_us(_CLEAR_US);
+}
+
+void LCD_I2C::setCursor(uint8_t col, uint8_t row)
+{
+  if (row >= this->_rows)
+    row = this->_rows - 1;
+
+  this->_command(_SET_DDRAM | (col + _row_offsets[row]));
+}
+
+size_t LCD_I2C::write(uint8_t c)
+{
+  this->_send(c, _RS);
+  this->_stats.chars++;
+  this->flush();
+
+  return 1;
+}
+
+size_t LCD_I2C::write(const uint8_t *buffer, size_t size)
+{
+  for (size_t i = 0; i < size; i++)
+    this->_send(buffer[i], _RS);
+  this->_stats.chars += size;
+  this->flush();
+
+  return size;
+}
+
+void LCD_I2C::flush(void)
+{
+  if (this->_tx_len == 0)
+    return;
+
+  hal_i2c_write(this->_address, this->_tx, this->_tx_len);
+
+  this->_stats.transactions++;
+  this->_stats.bytes += this->_tx_len;
+  this->_tx_len = 0;
+}
+
+const ST_LCD_I2C_STATS &LCD_I2C::get_stats(void)
+{
+  return this->_stats;
+}
+
+void LCD_I2C::reset_stats(void)
+{
+  this->_stats = { 0, 0, 0, 0 };
+}
+
+/***************************/
+/* Private methods         */
+/***************************/
+
+void LCD_I2C::_command(uint8_t cmd)
+{
+  this->_send(cmd, 0);
+  this->_stats.commands++;
+}
+
+void LCD_I2C::_send(uint8_t value, uint8_t mode)
+{
+  this->_nibble(value & 0xF0, mode);
+  this->_nibble((uint8_t) (value << 4), mode);
+
+  // E stays low while the LCD executes
+  for (uint8_t i = 0; i < LCD_I2C_SETTLE_BYTES; i++)
+    this->_queue(this->_last);
+}
+
+void LCD_I2C::_nibble(uint8_t nibble, uint8_t mode)
+{
+  const uint8_t bits = (nibble & 0xF0) | mode | this->_backlight;
+
+  // RS must be set up before E rises
+  if ((this->_last ^ bits) & _RS)
+    this->_queue(bits);
+  this->_queue(bits | _EN);
+  this->_queue(bits);
+}
+
+void LCD_I2C::_queue(uint8_t value)
+{
+  if (this->_tx_len == sizeof(this->_tx))
+    this->flush();
+
+  this->_tx[this->_tx_len++] = value;
+  this->_last = value;
+}
@@ -0,0 +1,90 @@
+/*******************************************************************************
+ * @file    LcdI2c.h
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   HD44780 character LCD behind a PCF8574 I2C expander (the common
+ *          "LCD 1602/2004 I2C" modules), with the API of LiquidCrystal_I2C
+ *          used by this project.
+ *
+ *          LiquidCrystal_I2C does one Wire transaction per expander write,
+ *          3 per nibble, 6 per character, followed by a 50us delay each. Here
+ *          the expander writes of a character are queued (E high and E low
+ *          per nibble, plus settle bytes so that the LCD has the 37us it
+ *          needs between characters) and a cursor command and the characters
+ *          written after it go out in as few transactions as fit in the
+ *          HAL_I2C_BUFFER bytes of Wire, on a LCD_I2C_CLOCK bus. The I2C bus
+ *          time paces the LCD, no delays are needed but for init, clear()
+ *          and home().
+ *
+ *          setCursor() and the other commands stay queued until the next
+ *          write(), flush() or a command that needs a delay.
+ *
+ *          PCF8574 pins: P0 RS, P1 RW, P2 E, P3 backlight, P4..P7 D4..D7.
+ *
+ *          Statistics: I2C transactions and bytes, LCD characters and
+ *          commands.
+*******************************************************************************/
+
+#ifndef _LCD_I2C_H
+#define _LCD_I2C_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <Hal.h>
+
+// The PCF8574 is specified up to 100kHz, the LCD modules run fine at 400kHz
+#ifndef LCD_I2C_CLOCK
+#define LCD_I2C_CLOCK 400000UL
+#endif
+// 37us execution time of a character or command, in 9-bit I2C bytes on top of
+// the byte ending the E pulse
+#define LCD_I2C_SETTLE_BYTES ((37UL * LCD_I2C_CLOCK + 8999999UL) / 9000000UL - 1)
+// Expander writes of a character: setup, 2 per nibble, settle
+#define LCD_I2C_BYTES_MAX (1 + 4 + LCD_I2C_SETTLE_BYTES)
+
+typedef struct {
+  uint32_t transactions;
+  uint32_t bytes;
+  uint32_t chars;
+  uint32_t commands;
+} ST_LCD_I2C_STATS;
+
+class LCD_I2C : public Print
+{
+  public:
+    LCD_I2C(uint8_t address, uint8_t cols, uint8_t rows);
+
+    void init(void);
+    void backlight(void);
+    void noBacklight(void);
+    void clear(void);
+    void home(void);
+    void setCursor(uint8_t col, uint8_t row);
+
+    using Print::write;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    // Sends the queued expander writes
+    void flush(void);
+
+    const ST_LCD_I2C_STATS &get_stats(void);
+    void reset_stats(void);
+
+  private:
+    void _command(uint8_t cmd);
+    void _send(uint8_t value, uint8_t mode);
+    void _nibble(uint8_t nibble, uint8_t mode);
+    void _queue(uint8_t value);
+
+    uint8_t _address;
+    uint8_t _cols;
+    uint8_t _rows;
+    uint8_t _backlight;
+    // Last value queued on the expander
+    uint8_t _last = 0;
+    uint8_t _tx[HAL_I2C_BUFFER];
+    uint8_t _tx_len = 0;
+    ST_LCD_I2C_STATS _stats = { 0, 0, 0, 0 };
+};
+
+#endif // _LCD_I2C_H
@@ -0,0 +1,147 @@
+/*******************************************************************************
+ * @file    Logger.cpp
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ *******************************************************************************/
+
+#include "Logger.h"
+
+LOGGER::LOGGER(uint8_t *buf, uint16_t size, E_LOGGER_POLICY policy, uint8_t delimiter, write_fp write, writable_fp writable)
+{
+  this->_buf = buf;
+  this->_size = buf != NULL ? size : 0;
+  this->_policy = policy;
+  this->_delimiter = delimiter;
+  this->_write = write;
+  this->_writable = writable;
+}
+
+size_t LOGGER::write(uint8_t c)
+{
+  const bool delimiter = c == this->_delimiter;
+  bool stored = false;
+
+  this->_stats.bytes++;
+
+  // A truncated message still gets its delimiter if there is room
+  if (this->_dropping && (!delimiter || this->_policy == LOGGER_DROP_MESSAGE))
+  {
+    this->_stats.dropped_bytes++;
+  }
+  else if (this->_put(c))
+  {
+    stored = true;
+  }
+  else if (this->_policy == LOGGER_DROP_MESSAGE)
+  {
+    // Rewind the part of the message already buffered
+    this->_stats.dropped_bytes += this->_staged + 1;
+    this->_stats.dropped_messages++;
+    this->_staged = 0;
+    this->_dropping = true;
+  }
+  else
+  {
+    // Truncated up to the delimiter
+    this->_stats.dropped_bytes++;
+    if (!this->_dropping)
+      this->_stats.dropped_messages++;
+    this->_dropping = true;
+  }
+
+  if (delimiter)
+  {
+    this->_commit();
+    this->_dropping = false;
+  }
+  else if (this->_policy == LOGGER_DROP_BYTES)
+  {
+    this->_commit();
+  }
+
+  return stored ? 1 : 0;
+}
+
+size_t LOGGER::write(const uint8_t *buffer, size_t size)
+{
+  size_t n = 0;
+
+  for (size_t i = 0; i < size; i++)
+    n += this->write(buffer[i]);
+
+  return n;
+}
+
+uint16_t LOGGER::pump(void)
+{
+  uint16_t sent = 0;
+
+  while (this->_committed > 0)
+  {
+    const int writable = this->_writable();
+    // Contiguous part up to the end of the buffer
+    uint16_t len = this->_size - this->_head;
+
+    if (writable <= 0)
+      break;
+    if (len > this->_committed)
+      len = this->_committed;
+    if (len > (uint16_t) writable)
+      len = (uint16_t) writable;
+
+    this->_write(&this->_buf[this->_head], len);
+
+    this->_head += len;
+    if (this->_head == this->_size)
+      this->_head = 0;
+    this->_committed -= len;
+    sent += len;
+  }
+
+  return sent;
+}
+
+uint16_t LOGGER::get_pending(void)
+{
+  return this->_committed + this->_staged;
+}
+
+const ST_LOGGER_STATS &LOGGER::get_stats(void)
+{
+  return this->_stats;
+}
+
+void LOGGER::reset_stats(void)
+{
+  this->_stats = { 0, 0, 0, this->get_pending() };
+}
+
+/***************************/
+/* Private methods         */
+/***************************/
+
+bool LOGGER::_put(uint8_t c)
+{
+  const uint16_t used = this->_committed + this->_staged;
+  uint16_t tail;
+
+  if (used >= this->_size)
+    return false;
+
+  tail = this->_head + used;
+  if (tail >= this->_size)
+    tail -= this->_size;
+  this->_buf[tail] = c;
+  this->_staged++;
+
+  if (used + 1 > this->_stats.high_watermark)
+    this->_stats.high_watermark = used + 1;
+
+  return true;
+}
+
+void LOGGER::_commit(void)
+{
+  this->_committed += this->_staged;
+  this->_staged = 0;
+}
@@ -0,0 +1,87 @@
+/*******************************************************************************
+ * @file    Logger.h
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Non-blocking buffered serial logger.
+ *          LOGGER is a Print, so it replaces Serial at the log call sites.
+ *          Printed bytes are copied into a caller provided ring buffer and
+ *          never wait for the UART: pump() moves them to the serial port
+ *          only as far as its TX buffer has room (hal_serial_writable()),
+ *          typically from the idle time of the scheduler.
+ *
+ *          Messages end with a delimiter byte ('\n' for the text log, 0x00
+ *          for COBS frames). A message only becomes visible to pump() when
+ *          its delimiter is written, so a message is sent whole or not at
+ *          all. When the buffer is full:
+ *            - LOGGER_DROP_MESSAGE: the message being written is discarded,
+ *                     including its bytes already buffered, up to its
+ *                     delimiter.
+ *            - LOGGER_DROP_BYTES: the message is truncated, its remaining
+ *                     bytes are discarded up to its delimiter, which is kept
+ *                     if there is room again by then. Bytes are
+ *                     sent as soon as they are written, without waiting for
+ *                     the delimiter.
+ *
+ *          Statistics: bytes accepted, bytes and messages dropped and the
+ *          buffer high watermark.
+*******************************************************************************/
+
+#ifndef _LOGGER_H
+#define _LOGGER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <Hal.h>
+
+typedef enum {
+  LOGGER_DROP_MESSAGE = 0,
+  LOGGER_DROP_BYTES,
+} E_LOGGER_POLICY;
+
+typedef struct {
+  uint32_t bytes;
+  uint32_t dropped_bytes;
+  uint16_t dropped_messages;
+  uint16_t high_watermark;
+} ST_LOGGER_STATS;
+
+class LOGGER : public Print
+{
+  public:
+    typedef size_t (*write_fp)(const uint8_t *data, size_t len);
+    typedef int (*writable_fp)(void);
+
+    LOGGER(uint8_t *buf, uint16_t size, E_LOGGER_POLICY policy=LOGGER_DROP_MESSAGE, uint8_t delimiter='\n',
+      write_fp write=hal_serial_write, writable_fp writable=hal_serial_writable);
+
+    using Print::write;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+
+    // Sends the buffered messages the serial port can take without blocking,
+    // returns the number of bytes sent
+    uint16_t pump(void);
+    // Buffered bytes, sent or not yet complete
+    uint16_t get_pending(void);
+    const ST_LOGGER_STATS &get_stats(void);
+    void reset_stats(void);
+
+  private:
+    bool _put(uint8_t c);
+    void _commit(void);
+
+    uint8_t *_buf;
+    uint16_t _size;
+    E_LOGGER_POLICY _policy;
+    uint8_t _delimiter;
+    write_fp _write;
+    writable_fp _writable;
+    // Read position, complete bytes after it and bytes of the current message
+    uint16_t _head = 0;
+    uint16_t _committed = 0;
+    uint16_t _staged = 0;
+    bool _dropping = false;
+    ST_LOGGER_STATS _stats = { 0, 0, 0, 0 };
+};
+
+#endif // _LOGGER_H
@@ -6,16 +6,89 @@
  * TODO:    - Add comments to constructor and methods
  *******************************************************************************/
 
-#include <Arduino.h>
+#include <math.h>
+#include <stddef.h>
 #include "Mq3.h"
 
-MQ3::MQ3(uint8_t ain_pin)
+// mg/L lookup table: 32 segments per octave of Rs/R0 over [2^-2 ... 2^10)
+#define MGL_OCTAVE_MIN (-2)
+#define MGL_OCTAVES 12
+#define MGL_SEGMENTS_BITS 5
+#define MGL_TABLE_SIZE ((MGL_OCTAVES << MGL_SEGMENTS_BITS) + 1)
+#define MGL_FRAC_BITS 8
+#define MGL_NORM_MSB (MGL_SEGMENTS_BITS + MGL_FRAC_BITS)
+
+static constexpr double _ce_ln2 = 0.69314718055994531;
+
+// Compile time natural logarithm, x > 0
+static constexpr double _ce_ln(double x)
+{
+  int16_t k = 0;
+
+  while (x >= 2.0) { x /= 2.0; k++; }
+  while (x < 1.0) { x *= 2.0; k--; }
+
+  // ln(x) = 2 * atanh((x - 1) / (x + 1)), converges fast for x in [1, 2)
+  const double z = (x - 1.0) / (x + 1.0);
+  double term = z, sum = .0;
+
+  for (uint8_t n = 1; n < 40; n += 2)
+  {
+    sum += term / n;
+    term *= z * z;
+  }
+
+  return 2.0 * sum + k * _ce_ln2;
+}
+
+// Compile time exponential
+static constexpr double _ce_exp(double x)
+{
+  const int16_t k = (int16_t) (x / _ce_ln2 + (x < 0 ? -.5 : .5));
+  const double r = x - k * _ce_ln2;
+  double term = 1.0, sum = 1.0;
+
+  for (uint8_t n = 1; n < 20; n++)
+  {
+    term *= r / n;
+    sum += term;
+  }
+
+  for (int16_t i = 0; i < k; i++) sum *= 2.0;
+  for (int16_t i = 0; i > k; i--) sum /= 2.0;
+
+  return sum;
+}
+
+typedef struct _ST_MGL_TABLE {
+  uint32_t q16[MGL_TABLE_SIZE];
+
+  constexpr _ST_MGL_TABLE() : q16()
+  {
+    for (uint16_t i = 0; i < MGL_TABLE_SIZE; i++)
+    {
+      const int16_t octave = MGL_OCTAVE_MIN + (i >> MGL_SEGMENTS_BITS);
+      const double segment = 1.0 + (double) (i & ((1 << MGL_SEGMENTS_BITS) - 1)) / (1 << MGL_SEGMENTS_BITS);
+      const double ratio = segment * _ce_exp(octave * _ce_ln2);
+
+      q16[i] = (uint32_t) (_ce_exp(-1.431 * _ce_ln(0.4 * ratio)) * MQ3_MGL_ONE + .5);
+    }
+  }
+} ST_MGL_TABLE;
+
+static constexpr ST_MGL_TABLE _mgL_table PROGMEM = ST_MGL_TABLE();
+
+MQ3::MQ3(uint8_t ain_pin, adc_read_fp adc_read /*=hal_analog_read*/, clock_fp clock /*=hal_millis*/)
 {
   this->_ain_pin = ain_pin;
+  this->_adc_read = adc_read != NULL ? adc_read : hal_analog_read;
+  this->_clock = clock != NULL ? clock : hal_millis;
 }
 
 MQ3::~MQ3()
 {
+  this->stop_sampling();
+
   this->_ain_pin = -1;
 
   this->_meas = { 0 };
@@ -29,7 +102,7 @@ MQ3::~MQ3()
 
 void MQ3::init(void)
 {
-  pinMode(this->_ain_pin, INPUT);
+  hal_pin_mode(this->_ain_pin, INPUT);
 }
 
 bool MQ3::measure(void)
@@ -41,16 +114,37 @@ bool MQ3::measure(void)
 
   uint32_t sum = 0;
 
-  for (uint16_t x = 0; x < 1000; x++)
-    sum += analogRead(this->_ain_pin);
+  if (this->_sampling)
+  {
+    this->poll();
+    if (!this->_fresh)
+      return false;
+    sum = this->_block;
+    this->_fresh = false;
+  }
+  else
+  {
+    while (!this->_filter.add(this->_adc_read(this->_ain_pin), sum))
+      ;
+  }
+
+  return this->_set_measurement(sum, this->_filter.get_block_samples());
+}
 
-  if (0 == sum)
+bool MQ3::_set_measurement(const uint32_t sum, const uint16_t samples)
+{
+  if (0 == sum || 0 == samples)
   {
     return false;
   }
 
-  this->_meas.avalue = sum / 1000;
-  this->_meas.volts = this->_meas.avalue / 1024.0 * 5.0;
+  const uint32_t average_q16 = this->_filter.smooth(sum, samples);
+
+  this->_meas.timestamp = this->_clock();
+  this->_meas.avalue = average_q16 >> 16;
+  this->_meas.value = this->_filter.decimate(average_q16);
+  this->_meas.bits = this->_filter.get_bits();
+  this->_meas.volts = this->_meas.value * 5.0 / (1UL << this->_meas.bits);
   this->_meas.RS = ((5.0 * R) / this->_meas.volts) - R;
 
   return true;
@@ -70,6 +164,115 @@ bool MQ3::measure(uint32_t &val, double &volts, double &rs)
   return false;
 }
 
+uint16_t MQ3::get_value(void)
+{
+  return this->_meas.value;
+}
+
+uint8_t MQ3::get_bits(void)
+{
+  return this->_meas.bits;
+}
+
+uint32_t MQ3::get_timestamp(void)
+{
+  return this->_meas.timestamp;
+}
+
+void MQ3::_on_sample(void *ctx, uint16_t sample)
+{
+  MQ3 *self = (MQ3 *) ctx;
+  uint32_t block;
+
+  if (self->_filter.add(sample, block) && !self->_blocks.push(block))
+    self->_overruns++;
+}
+
+bool MQ3::start_sampling(void)
+{
+  if (this->_sampling || this->_ain_pin == (uint8_t) -1)
+    return false;
+
+  this->_filter.reset();
+  this->_fresh = false;
+  this->_block_ms = this->_clock();
+  this->_overruns = 0;
+  this->_blocks.clear();
+
+  this->_sampling = hal_adc_start_free_running(this->_ain_pin, _on_sample, this);
+
+  return this->_sampling;
+}
+
+void MQ3::stop_sampling(void)
+{
+  if (this->_sampling)
+  {
+    hal_adc_stop_free_running();
+    this->_sampling = false;
+    // The blocking mode starts a block of its own
+    this->_filter.reset();
+  }
+}
+
+bool MQ3::is_sampling(void)
+{
+  return this->_sampling;
+}
+
+uint16_t MQ3::get_overruns(void)
+{
+  uint16_t overruns;
+
+  // 16-bit reads are not atomic on AVR, re-read if the ISR interfered
+  do
+  {
+    overruns = this->_overruns;
+  } while (overruns != this->_overruns);
+
+  return overruns;
+}
+
+void MQ3::poll(void)
+{
+  uint32_t block;
+
+  // Only the most recent block is of interest
+  while (this->_blocks.pop(block))
+  {
+    this->_block = block;
+    this->_fresh = true;
+    this->_block_ms = this->_clock();
+  }
+}
+
+bool MQ3::is_pending(void)
+{
+  const uint32_t block_ms = (uint32_t) this->_filter.get_block_samples() * HAL_ADC_FREE_RUNNING_US / 1000UL + 1;
+
+  return this->_sampling && !this->_fresh && this->_clock() - this->_block_ms <= MQ3_SAMPLING_BLOCKS * block_ms;
+}
+
+bool MQ3::set_filter(const ST_MQ3_FILTER &filter)
+{
+  const bool sampling = this->_sampling;
+
+  // The interrupt must not see a half changed filter
+  this->stop_sampling();
+
+  const bool result = this->_filter.set_config(filter);
+
+  if (sampling)
+    this->start_sampling();
+
+  return result;
+}
+
+const ST_MQ3_FILTER &MQ3::get_filter(void)
+{
+  return this->_filter.get_config();
+}
+
 bool MQ3::is_valid(const double r0)
 {
   // corresponds to ~[1.0V ... 0.1V]
@@ -85,14 +288,7 @@ bool MQ3::calibrate(void)
 {
   if (this->measure())
   {
-    const double R0 = this->_meas.RS / 60.0;
-
-    this->_calib.n++;
-    if (this->_calib.pAvalues == NULL)
-      this->_calib.pAvalues = (double *) malloc(sizeof(double) * this->_calib.n);
-    else
-      this->_calib.pAvalues = (double *) realloc(this->_calib.pAvalues, sizeof(double) * this->_calib.n);
-    this->_calib.pAvalues[this->_calib.n - 1] = R0;
+    this->_calibration_step();
 
     return true;
   }
@@ -100,13 +296,25 @@ bool MQ3::calibrate(void)
   return false;
 }
 
+void MQ3::_calibration_step(void)
+{
+  const double R0 = this->_meas.RS / 60.0;
+  const double delta = R0 - this->_calib.mean;
+
+  // Welford's online mean/variance, no sample history is kept
+  this->_calib.n++;
+  this->_calib.mean += delta / this->_calib.n;
+  this->_calib.m2 += delta * (R0 - this->_calib.mean);
+  this->_calib.last = R0;
+}
+
 bool MQ3::calibrate(uint32_t &val, double &volts, double &r0)
 {
   if (this->calibrate())
   {
     val = this->_meas.avalue;
     volts = this->_meas.volts;
-    r0 = this->_calib.pAvalues[this->_calib.n - 1];
+    r0 = this->_calib.last;
 
     return true;
   }
@@ -116,21 +324,15 @@ bool MQ3::calibrate(uint32_t &val, double &volts, double &r0)
 
 bool MQ3::check_calibration(const double threshold)
 {
-  if (this->_calib.n == 0 || this->_calib.pAvalues == NULL)
+  if (this->_calib.n == 0)
     return false;
 
-  double mean = .0, sd = .0;
-
-  for (uint16_t i = 0; i < this->_calib.n; i++)
-    mean += this->_calib.pAvalues[i];
-  mean /= this->_calib.n;
+  const double mean = this->_calib.mean;
 
   if (!this->is_valid(mean))
     return false;
 
-  for (uint16_t i = 0; i < this->_calib.n; i++)
-    sd += pow(this->_calib.pAvalues[i] - mean, 2);
-  sd = sqrt(sd / this->_calib.n);
+  const double sd = sqrt(this->_calib.m2 / this->_calib.n);
 
   // "Gauss" curve, 99.7% of data falls within 3 standard deviations.
   // So calculate the error of 99.7% of the data.
@@ -153,12 +355,95 @@ bool MQ3::check_calibration(const double threshold, double &precision)
   return result;
 }
 
+E_MQ3_CALIB MQ3::check_calibration_sequential(const double threshold)
+{
+  const uint32_t n = this->_calib.n;
+
+  if (n < MQ3_CALIB_MIN_STEPS)
+    return MQ3_CALIB_RUNNING;
+
+  const double mean = this->_calib.mean;
+  const double sd = sqrt(this->_calib.m2 / (n - 1));
+  const double mean_err = MQ3_CALIB_Z * sd / sqrt(n);
+  // Normal approximation of the relative standard error of a deviation
+  const double sd_err = MQ3_CALIB_Z / sqrt(2.0 * (n - 1));
+
+  // R0 surely out of range
+  if (!this->is_valid(mean) && !this->is_valid(mean - mean_err) && !this->is_valid(mean + mean_err))
+    return MQ3_CALIB_FAILED;
+  if (mean <= .0)
+    return MQ3_CALIB_FAILED;
+
+  // Bounds of the precision of check_calibration()
+  const double precision_lo = ((3 * sd * (sd_err < 1.0 ? 1.0 - sd_err : .0)) / mean) * 100;
+  const double precision_hi = ((3 * sd * (1.0 + sd_err)) / mean) * 100;
+
+  if (precision_lo > threshold)
+    return MQ3_CALIB_FAILED;
+  if (precision_hi <= threshold && this->is_valid(mean - mean_err) && this->is_valid(mean + mean_err))
+    return MQ3_CALIB_PASSED;
+
+  return MQ3_CALIB_RUNNING;
+}
+
+uint32_t MQ3::mgL_q16(const uint32_t ratio_q12)
+{
+  // Leading bit positions of the table range [0.25 ... 1024) in Q20.12
+  const uint8_t msb_min = MQ3_RATIO_Q + MGL_OCTAVE_MIN;
+  const uint8_t msb_max = msb_min + MGL_OCTAVES - 1;
+
+  if (ratio_q12 < (1UL << msb_min))
+    return pgm_read_dword(&_mgL_table.q16[0]);
+
+  if (ratio_q12 >= (1UL << (msb_max + 1)))
+    return 0;
+
+  uint8_t msb = msb_max;
+
+  while (!(ratio_q12 & (1UL << msb)))
+    msb--;
+
+  // Normalize to 1.ssss.ffffffff: leading bit, segment and 8-bit fraction
+  const uint16_t m = msb >= MGL_NORM_MSB ? ratio_q12 >> (msb - MGL_NORM_MSB) : ratio_q12 << (MGL_NORM_MSB - msb);
+  const uint16_t i = ((msb - msb_min) << MGL_SEGMENTS_BITS) | ((m >> MGL_FRAC_BITS) & ((1 << MGL_SEGMENTS_BITS) - 1));
+  const uint8_t frac = m & ((1 << MGL_FRAC_BITS) - 1);
+  const uint32_t y0 = pgm_read_dword(&_mgL_table.q16[i]);
+  const uint32_t y1 = pgm_read_dword(&_mgL_table.q16[i + 1]);
+
+  // mg/L is decreasing with Rs/R0
+  return y0 - (((y0 - y1) * frac) >> MGL_FRAC_BITS);
+}
+
+uint32_t MQ3::get_mgL_q16(void)
+{
+  const uint32_t a = this->_meas.value;
+  const uint32_t full = 1UL << this->_meas.bits;
+  const uint32_t r0 = (uint32_t) (this->R0 + .5);
+
+  if (a == 0 || r0 == 0 || r0 > 8191)
+    return 0;
+
+  if (a >= full)
+    return mgL_q16(0);
+
+  // Rs = R * (full - a) / a in Q.4, fits 32 bits up to 14-bit values
+  const uint32_t rs_q4 = (((uint32_t) R * (full - a)) << 4) / a;
+
+  // Rs/R0 >= 1024 is past the table
+  if (rs_q4 >= (r0 << (10 + 4)))
+    return 0;
+
+  // Keep the shifted Rs within 32 bits, large ratios need less precision
+  if (rs_q4 < (1UL << (32 - (MQ3_RATIO_Q - 4))))
+    return mgL_q16((rs_q4 << (MQ3_RATIO_Q - 4)) / r0);
+
+  return mgL_q16(((rs_q4 << 4) / r0) << (MQ3_RATIO_Q - 8));
+}
+
 void MQ3::clear_calibration(void)
 {
-  if (this->_calib.pAvalues != NULL)
-  {
-    memset(this->_calib.pAvalues, 0, sizeof(double) * this->_calib.n);
-    free(this->_calib.pAvalues);
-  }
   this->_calib.n = 0;
+  this->_calib.mean = .0;
+  this->_calib.m2 = .0;
+  this->_calib.last = .0;
 }
@@ -17,6 +17,60 @@
  *          check_calibration() returns "true" for a valid calibration and the
  *          calibrated R0. In case the calibration failed, then it must be
  *          cleared with clear_calibration() first before retrying calibration.
+ *          The calibration statistics are accumulated online (mean and
+ *          variance with Welford's method), so calibrate() does not allocate
+ *          and check_calibration() is constant time for any number of steps.
+ *          check_calibration_sequential() can be called after every step to
+ *          stop early: from MQ3_CALIB_MIN_STEPS steps on it returns
+ *          MQ3_CALIB_PASSED once the confidence interval of the precision is
+ *          below the threshold and the one of R0 within the valid range,
+ *          MQ3_CALIB_FAILED once either is entirely outside, and
+ *          MQ3_CALIB_RUNNING otherwise. The intervals are MQ3_CALIB_Z
+ *          standard errors wide, wider than usual since they are tested
+ *          after every step. check_calibration() makes the final decision.
+ *
+ *          The ADC and the clock are injectable (see Hal.h). By default they
+ *          are hal_analog_read() and hal_millis(), which are the Arduino core
+ *          functions on target and a simulated ADC/virtual clock on the host.
+ *
+ *          Sampling: By default measure() blocks for a block of samples,
+ *          MQ3_SAMPLES analogRead() calls (~110ms on an ATmega2560). After
+ *          start_sampling() the ADC runs free and its interrupt accumulates
+ *          the blocks into a lock-free ring buffer of MQ3_SAMPLING_BLOCKS
+ *          blocks. measure() then only takes the most recent completed block
+ *          and returns false if no new block completed since the last call.
+ *          is_pending() tells that apart from a fault: it is true while the
+ *          newest block is at most MQ3_SAMPLING_BLOCKS block periods old,
+ *          e.g. when missed cycles are caught up back to back.
+ *          measure() must be called at least every MQ3_SAMPLING_BLOCKS block
+ *          periods (~1.6s), otherwise the newest blocks are dropped and
+ *          counted by get_overruns(). With shorter blocks, poll() from the
+ *          idle time keeps the newest block for the next measure().
+ *          stop_sampling() falls back to the blocking mode.
+ *
+ *          Filter: the samples of a block go through the filter chain of
+ *          Mq3Filter.h, by default a plain average of MQ3_SAMPLES samples.
+ *          set_filter() changes the samples per block, the median of
+ *          sub-blocks and the EMA across measurements. While sampling it
+ *          restarts the sampling, so measure() has no block until a new one
+ *          completed. MQ3Array only applies the EMA and the resolution of
+ *          each sensor.
+ *
+ *          Resolution: with extra_bits in the filter, the measurement is
+ *          oversampled and decimated to 11 to 14 bits (get_bits()). The 10-bit
+ *          value of measure() and calibrate() stays as analogRead() would
+ *          give it, get_value() is the full one. Volts, Rs, R0 and the mg/L
+ *          of get_mgL_q16() are computed from the full one, which matters at
+ *          low concentrations, where Rs is large and the ADC value small.
+ *
+ *          BAC: get_mgL_q16() evaluates mg/L = (0.4 * Rs/R0)^-1.431 of the
+ *          last measurement without floating point. Rs/R0 is computed in
+ *          Q20.12 fixed-point and looked up in a table in flash, generated at
+ *          compile time, of 32 linearly interpolated segments per octave of
+ *          Rs/R0 over [0.25 ... 1024). The result is Q16.16 mg/L
+ *          (MQ3_MGL_ONE = 1 mg/L). The error against pow() is below 0.2% plus
+ *          2 LSB (3e-5 mg/L) over the table range. Below the range the result
+ *          saturates at ~27 mg/L and above it (< 0.0002 mg/L) it is 0.
 *******************************************************************************/
 
 #ifndef _MQ3_H
@@ -24,39 +78,96 @@
 
 #include <stdint.h>
 #include <float.h>
+#include <Hal.h>
+#include <Spsc.h>
+#include "Mq3Filter.h"
+
+#define MQ3_SAMPLES 1000U
+#define MQ3_SAMPLING_BLOCKS 16U
+#define MQ3_RATIO_Q 12
+#define MQ3_MGL_ONE 65536UL
+#define MQ3_CALIB_MIN_STEPS 10U
+#define MQ3_CALIB_Z 3.0
+
+typedef enum {
+  MQ3_CALIB_RUNNING = 0,
+  MQ3_CALIB_PASSED,
+  MQ3_CALIB_FAILED,
+} E_MQ3_CALIB;
 
 class MQ3
 {
   public:
-    MQ3(uint8_t ain_pin);
+    typedef uint16_t (*adc_read_fp)(uint8_t pin);
+    typedef uint32_t (*clock_fp)(void);
+    MQ3(uint8_t ain_pin, adc_read_fp adc_read=hal_analog_read, clock_fp clock=hal_millis);
     ~MQ3();
     static const uint16_t R = 4700U;
     void init(void);
     bool measure(void);
     bool measure(uint32_t &val, double &volts, double &rs);
+    uint32_t get_timestamp(void);
+    bool start_sampling(void);
+    void stop_sampling(void);
+    bool is_sampling(void);
+    uint16_t get_overruns(void);
+    void poll(void);
+    // measure() returned false only for want of a new block
+    bool is_pending(void);
+    bool set_filter(const ST_MQ3_FILTER &filter);
+    const ST_MQ3_FILTER &get_filter(void);
+    // Last measurement at get_bits() of resolution
+    uint16_t get_value(void);
+    uint8_t get_bits(void);
     bool is_valid(void);
     bool is_valid(const double r0);
     bool calibrate(void);
     bool calibrate(uint32_t &val, double &volts, double &r0);
     bool check_calibration(const double threshold);
     bool check_calibration(const double threshold, double &precision);
+    E_MQ3_CALIB check_calibration_sequential(const double threshold);
     void clear_calibration(void);
+    static uint32_t mgL_q16(const uint32_t ratio_q12);
+    uint32_t get_mgL_q16(void);
     double R0 = .0;
 
   private:
+    friend class MQ3Array;
     typedef struct {
+      uint32_t timestamp;
+      // 10-bit, as analogRead()
       uint32_t avalue;
+      // At bits of resolution
+      uint16_t value;
+      uint8_t bits;
       double volts;
       double RS;
     } ST_MEAS;
     typedef struct {
       uint32_t n;
-      double * pAvalues;
+      double mean;
+      double m2;
+      double last;
       double precision;
     } ST_CALIB;
+    static void _on_sample(void *ctx, uint16_t sample);
+    bool _set_measurement(const uint32_t sum, const uint16_t samples);
+    void _calibration_step(void);
     uint8_t _ain_pin = -1;
-    ST_MEAS _meas = { .avalue = 0, .volts = .0, .RS = .0, };
-    ST_CALIB _calib = { .n = 0, .pAvalues = NULL, .precision = DBL_MAX };
+    adc_read_fp _adc_read = hal_analog_read;
+    clock_fp _clock = hal_millis;
+    ST_MEAS _meas = { .timestamp = 0, .avalue = 0, .value = 0, .bits = MQ3_ADC_BITS, .volts = .0, .RS = .0, };
+    ST_CALIB _calib = { .n = 0, .mean = .0, .m2 = .0, .last = .0, .precision = DBL_MAX };
+    bool _sampling = false;
+    // Also run by the ADC interrupt while sampling
+    MQ3Filter _filter;
+    // Newest block taken from the ring buffer, not measured yet if fresh
+    uint32_t _block = 0;
+    bool _fresh = false;
+    // Time of the newest block, or of the start of the sampling
+    uint32_t _block_ms = 0;
+    volatile uint16_t _overruns = 0;
+    SPSC<uint32_t, MQ3_SAMPLING_BLOCKS> _blocks;
 };
 
 #endif // _MQ3_H_
\ No newline at end of file
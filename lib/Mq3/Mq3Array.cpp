@@ -0,0 +1,92 @@
+/*******************************************************************************
+ * @file    Mq3Array.cpp
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ *******************************************************************************/
+
+#include "Mq3Array.h"
+
+MQ3Array::MQ3Array(MQ3 *sensors[], uint8_t n, uint16_t samples /*=MQ3_SAMPLES*/)
+{
+  this->_sensors = sensors;
+  this->_n = n > MQ3_ARRAY_MAX ? MQ3_ARRAY_MAX : n;
+  this->_samples = this->_n > 0 ? samples / this->_n : 0;
+}
+
+void MQ3Array::init(void)
+{
+  for (uint8_t i = 0; i < this->_n; i++)
+    this->_sensors[i]->init();
+}
+
+uint8_t MQ3Array::get_size(void)
+{
+  return this->_n;
+}
+
+uint16_t MQ3Array::get_samples_per_sensor(void)
+{
+  return this->_samples;
+}
+
+MQ3 &MQ3Array::get(uint8_t i)
+{
+  return *this->_sensors[i < this->_n ? i : 0];
+}
+
+uint8_t MQ3Array::measure(void)
+{
+  uint32_t sums[MQ3_ARRAY_MAX] = {0};
+  uint8_t result = 0;
+
+  // Interleaved: one conversion per channel and round
+  for (uint16_t x = 0; x < this->_samples; x++)
+  {
+    for (uint8_t i = 0; i < this->_n; i++)
+    {
+      const MQ3 *pSensor = this->_sensors[i];
+
+      sums[i] += pSensor->_adc_read(pSensor->_ain_pin);
+    }
+  }
+
+  for (uint8_t i = 0; i < this->_n; i++)
+  {
+    if (this->_sensors[i]->_set_measurement(sums[i], this->_samples))
+      result |= 1 << i;
+  }
+
+  return result;
+}
+
+uint8_t MQ3Array::calibrate(void)
+{
+  const uint8_t result = this->measure();
+
+  for (uint8_t i = 0; i < this->_n; i++)
+  {
+    if (result & (1 << i))
+      this->_sensors[i]->_calibration_step();
+  }
+
+  return result;
+}
+
+uint8_t MQ3Array::check_calibration(const double threshold)
+{
+  uint8_t result = 0;
+
+  for (uint8_t i = 0; i < this->_n; i++)
+  {
+    if (this->_sensors[i]->check_calibration(threshold))
+      result |= 1 << i;
+  }
+
+  return result;
+}
+
+void MQ3Array::clear_calibration(void)
+{
+  for (uint8_t i = 0; i < this->_n; i++)
+    this->_sensors[i]->clear_calibration();
+}
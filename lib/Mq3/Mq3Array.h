@@ -0,0 +1,48 @@
+/*******************************************************************************
+ * @file    Mq3Array.h
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Defines a class scanning several MQ3 sensors in the same cycle.
+ *          The sensors are MQ3 objects of their own, so each keeps its pin,
+ *          R0 and calibration state and all the MQ3 methods can be used per
+ *          sensor (e.g. get_mgL_q16()).
+ *
+ *          A scan round-robins the ADC mux across the channels, one conversion
+ *          per channel at a time, and accumulates a sum per channel. The
+ *          samples per scan are shared by all the channels (by default
+ *          MQ3_SAMPLES, i.e. MQ3_SAMPLES / n per sensor), so a scan takes as
+ *          long as a single MQ3::measure() no matter the number of sensors,
+ *          and all the sensors are sampled over the same time window.
+ *
+ *          measure(), calibrate() and check_calibration() return a bitmask of
+ *          the sensors that succeeded (bit i for sensor i).
+*******************************************************************************/
+
+#ifndef _MQ3_ARRAY_H
+#define _MQ3_ARRAY_H
+
+#include <stdint.h>
+#include "Mq3.h"
+
+#define MQ3_ARRAY_MAX 8U
+
+class MQ3Array
+{
+  public:
+    MQ3Array(MQ3 *sensors[], uint8_t n, uint16_t samples=MQ3_SAMPLES);
+    void init(void);
+    uint8_t get_size(void);
+    uint16_t get_samples_per_sensor(void);
+    MQ3 &get(uint8_t i);
+    uint8_t measure(void);
+    uint8_t calibrate(void);
+    uint8_t check_calibration(const double threshold);
+    void clear_calibration(void);
+
+  private:
+    MQ3 **_sensors;
+    uint8_t _n;
+    uint16_t _samples;
+};
+
+#endif // _MQ3_ARRAY_H
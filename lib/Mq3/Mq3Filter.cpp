@@ -0,0 +1,129 @@
+/*******************************************************************************
+ * @file    Mq3Filter.cpp
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ *******************************************************************************/
+
+#include "Mq3Filter.h"
+#include "Mq3.h"
+
+MQ3Filter::MQ3Filter(void)
+{
+  this->_config = { MQ3_SAMPLES, 1, 0, 0 };
+  this->_sub_samples = MQ3_SAMPLES;
+  this->reset();
+}
+
+bool MQ3Filter::set_config(const ST_MQ3_FILTER &config)
+{
+  if (config.median == 0 || config.median > MQ3_FILTER_MEDIAN_MAX || !(config.median & 1))
+    return false;
+  if (config.samples < config.median || config.ema_shift > MQ3_FILTER_EMA_SHIFT_MAX)
+    return false;
+  // 4^n samples per sub-block for n extra bits, the median passes on one
+  if (config.extra_bits > MQ3_FILTER_EXTRA_BITS_MAX)
+    return false;
+  if (config.samples / config.median < (1U << (2 * config.extra_bits)))
+    return false;
+
+  this->_config = config;
+  this->_sub_samples = config.samples / config.median;
+  this->reset();
+
+  return true;
+}
+
+const ST_MQ3_FILTER &MQ3Filter::get_config(void)
+{
+  return this->_config;
+}
+
+uint16_t MQ3Filter::get_block_samples(void)
+{
+  return this->_sub_samples * this->_config.median;
+}
+
+uint8_t MQ3Filter::get_bits(void)
+{
+  return MQ3_ADC_BITS + this->_config.extra_bits;
+}
+
+void MQ3Filter::reset(void)
+{
+  this->_count = 0;
+  this->_sum = 0;
+  this->_subs = 0;
+  this->_ema_q16 = 0;
+  this->_ema_valid = false;
+}
+
+bool MQ3Filter::add(uint16_t sample, uint32_t &block)
+{
+  this->_sum += sample;
+  if (++this->_count < this->_sub_samples)
+    return false;
+
+  // Insertion of the completed sub-block
+  uint8_t i = this->_subs++;
+
+  while (i > 0 && this->_sorted[i - 1] > this->_sum)
+  {
+    this->_sorted[i] = this->_sorted[i - 1];
+    i--;
+  }
+  this->_sorted[i] = this->_sum;
+  this->_sum = 0;
+  this->_count = 0;
+
+  if (this->_subs < this->_config.median)
+    return false;
+
+  block = this->_sorted[this->_subs / 2] * this->_subs;
+  this->_subs = 0;
+
+  return true;
+}
+
+uint32_t MQ3Filter::smooth(uint32_t sum, uint16_t samples)
+{
+  const uint32_t x = average_q16(sum, samples);
+  const uint8_t shift = this->_config.ema_shift;
+
+  if (shift == 0 || !this->_ema_valid)
+  {
+    this->_ema_q16 = x;
+    this->_ema_valid = true;
+
+    return x;
+  }
+
+  // Rounded away from zero, so a constant input is reached exactly and
+  // the steps up and down are symmetric
+  const int32_t delta = (int32_t) (x - this->_ema_q16);
+  const int32_t carry = (1L << shift) - 1;
+
+  if (delta >= 0)
+    this->_ema_q16 += (delta + carry) >> shift;
+  else
+    this->_ema_q16 -= (-delta + carry) >> shift;
+
+  return this->_ema_q16;
+}
+
+uint16_t MQ3Filter::decimate(uint32_t average_q16)
+{
+  // (sum << n) / samples, sum >> n for 4^n samples
+  return average_q16 >> (16 - this->_config.extra_bits);
+}
+
+uint32_t MQ3Filter::average_q16(uint32_t sum, uint16_t samples)
+{
+  if (samples == 0)
+    return 0;
+
+  // Integer and fractional part apart, sum << 16 does not fit 32 bits
+  const uint32_t avg = sum / samples;
+  const uint32_t rem = sum % samples;
+
+  return (avg << 16) | ((rem << 16) / samples);
+}
@@ -0,0 +1,92 @@
+/*******************************************************************************
+ * @file    Mq3Filter.h
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Defines the filter chain conditioning the ADC samples of a MQ3
+ *          into a measurement. Three stages, each configurable or off:
+ *            - decimation: an integrate and dump average (first order CIC)
+ *                     of samples / median samples per sub-block.
+ *            - median: the median of median sub-blocks (odd, 1 is off)
+ *                     rejects spikes of the ADC or the heater supply that
+ *                     hit fewer than half of them. The block sum is the
+ *                     median sub-block times median, so a block counts
+ *                     get_block_samples() samples.
+ *            - EMA: an exponential moving average across measurements, of
+ *                     weight 2^-ema_shift for the new one (0 is off). It
+ *                     starts at the first measurement after reset().
+ *
+ *          Resolution: extra_bits n (up to MQ3_FILTER_EXTRA_BITS_MAX) makes
+ *          a measurement a value of MQ3_ADC_BITS + n bits, by oversampling
+ *          and decimation: a block of 4^n samples is summed and shifted
+ *          right by n, i.e. 2^n times the average. It needs a sub-block of
+ *          at least 4^n samples, since the median passes on the average of
+ *          a single one, and noise of at least ~1 LSB, which the MQ3 and
+ *          the ADC have, so that the samples are dithered across the
+ *          10-bit steps. With more than 4^n samples the sum is scaled the
+ *          same, (sum << n) / samples.
+ *
+ *          add() runs the first two stages a sample at a time. It is cheap
+ *          enough for the ADC interrupt: a sub-block is inserted into the
+ *          sorted ones when it completes, so the median is only an index at
+ *          the end of a block. smooth() runs the EMA on the average of a
+ *          block, in Q16.16 ADC LSB, so the noise below 1 LSB that the
+ *          averaging buys is kept.
+ *
+ *          Use cases differ, e.g. more samples and spike rejection when
+ *          calibrating, where the steps must stay independent for the
+ *          precision, and fewer samples for a fast response when measuring.
+ *          See MQ3::set_filter().
+*******************************************************************************/
+
+#ifndef _MQ3_FILTER_H
+#define _MQ3_FILTER_H
+
+#include <stdint.h>
+
+#define MQ3_ADC_BITS 10U
+#define MQ3_FILTER_MEDIAN_MAX 7U
+#define MQ3_FILTER_EMA_SHIFT_MAX 8U
+#define MQ3_FILTER_EXTRA_BITS_MAX 4U
+#define MQ3_FILTER_ONE 65536UL
+
+typedef struct {
+  uint16_t samples;
+  uint8_t median;
+  uint8_t ema_shift;
+  uint8_t extra_bits;
+} ST_MQ3_FILTER;
+
+class MQ3Filter
+{
+  public:
+    MQ3Filter(void);
+    // Returns false and keeps the current one if invalid
+    bool set_config(const ST_MQ3_FILTER &config);
+    const ST_MQ3_FILTER &get_config(void);
+    // Samples counted by a block sum
+    uint16_t get_block_samples(void);
+    // Bits of a measurement, MQ3_ADC_BITS + extra_bits
+    uint8_t get_bits(void);
+    // Drops the partial block and restarts the EMA
+    void reset(void);
+    // Returns true when the sample completed a block, its sum in block
+    bool add(uint16_t sample, uint32_t &block);
+    // EMA of the average of sum over samples, Q16.16
+    uint32_t smooth(uint32_t sum, uint16_t samples);
+    static uint32_t average_q16(uint32_t sum, uint16_t samples);
+    // Measurement of get_bits() from an average in Q16.16
+    uint16_t decimate(uint32_t average_q16);
+
+  private:
+    ST_MQ3_FILTER _config;
+    uint16_t _sub_samples;
+    uint16_t _count;
+    uint32_t _sum;
+    // Completed sub-blocks of the current block, sorted
+    uint32_t _sorted[MQ3_FILTER_MEDIAN_MAX];
+    uint8_t _subs;
+    uint32_t _ema_q16;
+    bool _ema_valid;
+};
+
+#endif // _MQ3_FILTER_H
@@ -0,0 +1,197 @@
+/*******************************************************************************
+ * @file    Mq3Warmup.cpp
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ *******************************************************************************/
+
+#include <math.h>
+#include "Mq3Warmup.h"
+
+MQ3Warmup::MQ3Warmup(uint16_t period_s, float max_drift, uint32_t min_s /*=0*/, uint32_t max_s /*=0*/)
+{
+  this->_period_s = period_s > 0 ? period_s : 1;
+  this->_max_drift = max_drift;
+  this->_min_s = min_s;
+  this->_max_s = max_s;
+  this->reset();
+}
+
+void MQ3Warmup::reset(void)
+{
+  this->_head = 0;
+  this->_n = 0;
+  this->_first = .0;
+  this->_sum = .0;
+  this->_sum_sq = .0;
+  this->_block_n = 0;
+  this->_samples = 0;
+  this->_resumed_s = 0;
+  this->_ready = false;
+  this->_drift = .0;
+  this->_drift_err = .0;
+  this->_noise = .0;
+  this->_remaining = 1.0;
+  this->_estimate = .0;
+  this->_tau_s = .0;
+}
+
+void MQ3Warmup::resume(uint32_t elapsed_s, bool ready /*=false*/)
+{
+  this->_resumed_s = elapsed_s;
+  this->_ready = ready;
+}
+
+bool MQ3Warmup::add(const double rs)
+{
+  if (rs <= .0)
+    return this->_ready;
+
+  this->_samples++;
+  // Differences to the first value keep the float sums precise
+  if (this->_block_n == 0)
+    this->_first = rs;
+
+  const float d = rs - this->_first;
+
+  this->_sum += d;
+  this->_sum_sq += d * d;
+  if (++this->_block_n < MQ3_WARMUP_BLOCK)
+    return this->_ready;
+
+  const float mean = this->_sum / MQ3_WARMUP_BLOCK;
+  const float variance = this->_sum_sq / MQ3_WARMUP_BLOCK - mean * mean;
+
+  this->_blocks[this->_head] = this->_first + mean;
+  this->_noise = variance > 0 ? sqrt(variance) / this->_blocks[this->_head] : .0;
+  this->_head = (this->_head + 1) % MQ3_WARMUP_BLOCKS;
+  if (this->_n < MQ3_WARMUP_BLOCKS)
+    this->_n++;
+  this->_sum = .0;
+  this->_sum_sq = .0;
+  this->_block_n = 0;
+
+  if (this->_n < 3)
+    return this->_ready;
+
+  this->_check();
+  if (this->_settled() && this->get_elapsed() >= this->_min_s)
+    this->_ready = true;
+
+  return this->_ready;
+}
+
+bool MQ3Warmup::is_ready(void)
+{
+  return this->_ready;
+}
+
+bool MQ3Warmup::is_done(void)
+{
+  return this->_ready || (this->_max_s > 0 && this->get_elapsed() >= this->_max_s);
+}
+
+float MQ3Warmup::get_drift(void)
+{
+  return this->_drift;
+}
+
+float MQ3Warmup::get_noise(void)
+{
+  return this->_noise;
+}
+
+float MQ3Warmup::get_remaining(void)
+{
+  return this->_remaining;
+}
+
+uint32_t MQ3Warmup::get_time_to_ready(void)
+{
+  const uint32_t elapsed = this->get_elapsed();
+  const uint32_t min_left = elapsed < this->_min_s ? this->_min_s - elapsed : 0;
+  uint32_t left;
+
+  if (this->_ready)
+    return 0;
+  if (this->_n < 3)
+    return MQ3_WARMUP_UNKNOWN;
+
+  // Ready at the end of a block
+  if (this->_settled())
+    left = 0;
+  else if (this->_tau_s > .0 && this->_estimate > .0)
+    left = this->_estimate > MQ3_WARMUP_SETTLED ?
+      (uint32_t) (this->_tau_s * log(this->_estimate / MQ3_WARMUP_SETTLED)) : 0;
+  else
+    return MQ3_WARMUP_UNKNOWN;
+
+  left = left > min_left ? left : min_left;
+  // Rounded up to a block
+  const uint32_t block_s = (uint32_t) MQ3_WARMUP_BLOCK * this->_period_s;
+  const uint32_t done_s = (uint32_t) this->_block_n * this->_period_s;
+
+  left += done_s;
+  left = (left + block_s - 1) / block_s * block_s;
+
+  return left > done_s ? left - done_s : block_s - done_s;
+}
+
+uint32_t MQ3Warmup::get_elapsed(void)
+{
+  return this->_resumed_s + this->_samples * this->_period_s;
+}
+
+/***************************/
+/* Private methods         */
+/***************************/
+
+void MQ3Warmup::_check(void)
+{
+  // The newest 3k blocks in three parts of k, oldest first
+  const uint8_t k = this->_n / 3;
+  float m[3] = { .0, .0, .0 };
+
+  for (uint8_t i = 0; i < 3 * k; i++)
+    m[i / k] += this->_blocks[(this->_head + MQ3_WARMUP_BLOCKS - 3 * k + i) % MQ3_WARMUP_BLOCKS];
+  for (uint8_t j = 0; j < 3; j++)
+    m[j] /= k;
+
+  const float delta_s = (float) k * MQ3_WARMUP_BLOCK * this->_period_s;
+  // Relative steps, signed the way Rs settles
+  const float d1 = (m[1] - m[0]) / m[2];
+  const float d2 = (m[2] - m[1]) / m[2];
+  // Standard error of a step, from the noise of the values
+  const float err = sqrt(2.0 / ((float) k * MQ3_WARMUP_BLOCK)) * this->_noise;
+  const float step = fabs(d2) + 2 * err;
+  const float r_max = exp(-delta_s / MQ3_WARMUP_TAU_MAX_S);
+  float remaining = step * r_max / (1 - r_max);
+
+  this->_drift = d2 * 3600 / delta_s;
+  this->_estimate = .0;
+  this->_tau_s = .0;
+  if (d1 * d2 > 0 && fabs(d1) > fabs(d2))
+  {
+    const float r = fabs(d2 / d1);
+
+    this->_estimate = fabs(d2) * r / (1 - r);
+    this->_tau_s = -delta_s / log(r);
+
+    // Decaying beyond the noise, the steps widened against each other
+    if (fabs(d1) - 2 * err > step)
+    {
+      const float r_up = step / (fabs(d1) - 2 * err);
+      const float bound = step * r_up / (1 - r_up);
+
+      if (bound < remaining)
+        remaining = bound;
+    }
+  }
+
+  this->_drift_err = err * 3600 / delta_s;
+  this->_remaining = remaining;
+}
+
+bool MQ3Warmup::_settled(void)
+{
+  return fabs(this->_drift) + 2 * this->_drift_err < this->_max_drift && this->_remaining < MQ3_WARMUP_SETTLED;
+}
@@ -0,0 +1,115 @@
+/*******************************************************************************
+ * @file    Mq3Warmup.h
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Defines a class detecting the end of the MQ3 warm-up from the
+ *          drift of its Rs, instead of a fixed preheat time.
+ *
+ *          add() takes an Rs every period_s seconds. The values are averaged
+ *          in blocks of MQ3_WARMUP_BLOCK (~21 min at 10 s), the last
+ *          MQ3_WARMUP_BLOCKS block means (~4 h) are the baseline. A single
+ *          window of minutes cannot resolve a drift of a few %/h. The
+ *          noise (standard deviation relative to the mean) is that of the
+ *          values in the last block.
+ *
+ *          After every block, from 3 blocks on, the baseline is split in
+ *          three equal parts. Their means m0, m1, m2 are Delta apart, the
+ *          drift is (m2 - m1) / Delta relative to m2, per hour. Rs settles
+ *          exponentially, so the steps shrink by r = (m2 - m1) / (m1 - m0)
+ *          per Delta and the settled Rs is m2 + (m2 - m1) * r / (1 - r).
+ *          Both steps are widened by 2 standard errors, and r is at most
+ *          that of MQ3_WARMUP_TAU_MAX_S, so a slow decay that does not show
+ *          in the baseline is not taken as settled.
+ *
+ *          The sensor is ready when the drift is below max_drift, m2 is
+ *          within MQ3_WARMUP_SETTLED of the settled Rs, both with ~95%
+ *          confidence, and at least min_s seconds passed. Ready is kept
+ *          until reset().
+ *
+ *          Time to ready: the time constant of the drift is -Delta / ln(r),
+ *          the time left is that for m2 to get within MQ3_WARMUP_SETTLED of
+ *          the settled Rs. MQ3_WARMUP_UNKNOWN while the drift does not decay
+ *          measurably yet.
+ *
+ *          max_s, if not 0, bounds the warm-up: once max_s seconds passed
+ *          it is done, ready or not, e.g. to go on with a sensor that
+ *          settles too slowly.
+ *
+ *          resume() continues a warm-up interrupted by a reset that kept the
+ *          sensor heated: its elapsed time counts towards min_s and max_s
+ *          and a ready warm-up stays ready. Otherwise the baseline fills up
+ *          again, so Rs is checked anew after 3 blocks.
+*******************************************************************************/
+
+#ifndef _MQ3_WARMUP_H
+#define _MQ3_WARMUP_H
+
+#include <stdint.h>
+
+#define MQ3_WARMUP_BLOCK 128U
+// A multiple of 3
+#define MQ3_WARMUP_BLOCKS 12U
+// Relative distance of m2 to the settled Rs
+#ifndef MQ3_WARMUP_SETTLED
+#define MQ3_WARMUP_SETTLED 0.02
+#endif
+// Slowest time constant assumed, the preheat time of the datasheet
+#ifndef MQ3_WARMUP_TAU_MAX_S
+#define MQ3_WARMUP_TAU_MAX_S (24 * 3600.0)
+#endif
+#define MQ3_WARMUP_UNKNOWN UINT32_MAX
+
+class MQ3Warmup
+{
+  public:
+    MQ3Warmup(uint16_t period_s, float max_drift, uint32_t min_s=0, uint32_t max_s=0);
+    void reset(void);
+    // After reset(), elapsed seconds of an interrupted warm-up
+    void resume(uint32_t elapsed_s, bool ready=false);
+    // Returns true once ready
+    bool add(const double rs);
+    bool is_ready(void);
+    // Ready or max_s passed
+    bool is_done(void);
+    // Relative Rs drift per hour, 0 until 3 blocks
+    float get_drift(void);
+    float get_noise(void);
+    // Relative distance of m2 to the settled Rs, ~95% upper bound, 1 until
+    // 3 blocks
+    float get_remaining(void);
+    // Estimated seconds to ready, MQ3_WARMUP_UNKNOWN if not known yet
+    uint32_t get_time_to_ready(void);
+    uint32_t get_elapsed(void);
+
+  private:
+    void _check(void);
+    bool _settled(void);
+
+    uint16_t _period_s;
+    float _max_drift;
+    uint32_t _min_s;
+    uint32_t _max_s;
+    // Ring of the block means
+    float _blocks[MQ3_WARMUP_BLOCKS];
+    uint8_t _head;
+    uint8_t _n;
+    // Current block: first value, sums of the differences to it and of
+    // their squares
+    float _first;
+    float _sum;
+    float _sum_sq;
+    uint16_t _block_n;
+    uint32_t _samples;
+    uint32_t _resumed_s;
+    bool _ready;
+    float _drift;
+    float _drift_err;
+    float _noise;
+    float _remaining;
+    // Estimated remaining distance and time constant of the drift in s, 0 if
+    // unknown
+    float _estimate;
+    float _tau_s;
+};
+
+#endif // _MQ3_WARMUP_H
@@ -0,0 +1,347 @@
+/********************************************************************************
+ * @file    Scheduler.h
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Cooperative scheduler of up to N independent state machines (TFSM,
+ *          TFSM_P or anything with run() and get_current_cycle()), each with
+ *          its own cycle times. The next run deadline of every machine is kept
+ *          in a binary min-heap, so tick() only looks at the earliest one:
+ *          if it is due, that machine runs and is re-inserted with its new
+ *          deadline, otherwise the MCU idle sleeps until the next interrupt
+ *          (see hal_idle_until()).
+ *
+ *          Deadlines: the next deadline is the previous deadline + the current
+ *          cycle (after the run, so the cycle of a new state counts), not the
+ *          run time + cycle. Neither the lateness nor the duration of a run
+ *          add to the period, N runs of a 1000ms cycle take N seconds. The
+ *          first deadline is start() + the cycle.
+ *
+ *          Overruns: a run so late that its next deadline has passed too
+ *          (lateness >= cycle) is an overrun. What happens to the periods it
+ *          missed is the policy of the machine, set with add() or
+ *          set_policy():
+ *            - SCHEDULER_CATCH_UP: (default) they run back to back until the
+ *                     machine is on its deadlines again, no step is lost,
+ *                     e.g. a countdown of steps keeps the wall clock.
+ *            - SCHEDULER_SKIP: they are dropped, the next deadline is the
+ *                     first one after now on the original grid, so the phase
+ *                     is kept but the steps fall behind the wall clock.
+ *          An overrun callback (set_overrun_cb()) is called with the machine
+ *          id and the lateness in us, before the run.
+ *
+ *          Machines are added with add() before start(). A machine whose
+ *          current cycle is SCHEDULER_CYCLE_NEVER ms or longer is parked: it
+ *          never runs again, e.g. a reset state waiting for the watchdog. The
+ *          watchdog is reset after every run and before every idle sleep, but
+ *          only while no machine is parked, so such a state still gets its
+ *          watchdog reset. An idle sleep lasts at most SCHEDULER_IDLE_MAX_MS,
+ *          so a cycle longer than the watchdog period does not expire it.
+ *
+ *          An idle callback (set_idle_cb()) runs before every idle sleep, for
+ *          background work that must not delay the machines, e.g. flushing a
+ *          LOGGER. Its time counts as busy time.
+ *
+ *          Statistics: per machine the runs, the lateness (how late it ran
+ *          after its deadline) in us, the overruns and the skipped periods,
+ *          and for the scheduler the busy (running the machines) and idle
+ *          (sleeping) time in us.
+ ********************************************************************************/
+
+#ifndef _SCHEDULER_H
+#define _SCHEDULER_H
+
+#include <stdint.h>
+#include <Hal.h>
+
+// Deadlines are compared wrap-safe within half the 32-bit us range
+#define SCHEDULER_CYCLE_NEVER (INT32_MAX / 1000L)
+// Well below the shortest watchdog period used, WDTO_8S
+#ifndef SCHEDULER_IDLE_MAX_MS
+#define SCHEDULER_IDLE_MAX_MS 1000UL
+#endif
+
+typedef enum {
+  SCHEDULER_CATCH_UP = 0,
+  SCHEDULER_SKIP,
+} E_SCHEDULER_POLICY;
+
+typedef struct {
+  uint32_t runs;
+  uint32_t lateness_max_us;
+  uint32_t lateness_sum_us;
+  uint32_t overruns;
+  uint32_t skipped;
+} ST_SCHEDULER_TASK_STATS;
+
+typedef struct {
+  uint32_t runs;
+  uint32_t wakeups;
+  uint32_t busy_us;
+  uint32_t idle_us;
+} ST_SCHEDULER_STATS;
+
+template <uint8_t N>
+class SCHEDULER
+{
+  public:
+    // Returns the machine id or -1 if full or already started
+    template <class FSM>
+    int8_t add(FSM &fsm, E_SCHEDULER_POLICY policy=SCHEDULER_CATCH_UP)
+    {
+      if (this->_n >= N || this->_started)
+        return -1;
+
+      _ST_TASK &task = this->_tasks[this->_n];
+
+      task.fsm = (void *) &fsm;
+      task.run = _run<FSM>;
+      task.cycle = _cycle<FSM>;
+      task.policy = policy;
+      task.stats = { 0, 0, 0, 0, 0 };
+
+      return this->_n++;
+    }
+
+    void start(void)
+    {
+      const uint32_t now = hal_micros();
+
+      this->_started = true;
+      this->_heap_n = 0;
+      this->_parked = 0;
+      for (uint8_t i = 0; i < this->_n; i++)
+      {
+        this->_tasks[i].deadline_us = now;
+        this->_schedule(i, now);
+      }
+    }
+
+    // Returns true if a machine ran, false if the MCU slept
+    bool tick(void)
+    {
+      const uint32_t now = hal_micros();
+
+      if (this->_heap_n > 0 && !_before(now, this->_tasks[this->_heap[0]].deadline_us))
+      {
+        const uint8_t id = this->_pop();
+        _ST_TASK &task = this->_tasks[id];
+        const uint32_t lateness = now - task.deadline_us;
+
+        if (lateness >= task.cycle_us && task.cycle_us > 0)
+        {
+          task.stats.overruns++;
+          if (this->_overrun_cb != NULL)
+            this->_overrun_cb(id, lateness);
+        }
+        task.run(task.fsm);
+        this->_schedule(id, hal_micros());
+        if (this->_parked == 0)
+          hal_watchdog_reset();
+
+        task.stats.runs++;
+        task.stats.lateness_sum_us += lateness;
+        if (lateness > task.stats.lateness_max_us)
+          task.stats.lateness_max_us = lateness;
+        this->_stats.runs++;
+        this->_stats.busy_us += hal_micros() - now;
+
+        return true;
+      }
+
+      if (this->_idle_cb != NULL)
+      {
+        this->_idle_cb();
+        this->_stats.busy_us += hal_micros() - now;
+      }
+
+      if (this->_parked == 0)
+        hal_watchdog_reset();
+
+      const uint32_t idle_start = hal_micros();
+
+      if (this->_heap_n > 0)
+      {
+        const uint32_t deadline = this->_tasks[this->_heap[0]].deadline_us;
+        const uint32_t limit = idle_start + SCHEDULER_IDLE_MAX_MS * 1000UL;
+
+        hal_idle_until(_before(limit, deadline) ? limit : deadline);
+      }
+      else
+      {
+        hal_idle();
+      }
+
+      this->_stats.wakeups++;
+      this->_stats.idle_us += hal_micros() - idle_start;
+
+      return false;
+    }
+
+    void set_idle_cb(void (*idle_cb)(void))
+    {
+      this->_idle_cb = idle_cb;
+    }
+
+    void set_overrun_cb(void (*overrun_cb)(uint8_t id, uint32_t lateness_us))
+    {
+      this->_overrun_cb = overrun_cb;
+    }
+
+    void set_policy(uint8_t id, E_SCHEDULER_POLICY policy)
+    {
+      if (id < this->_n)
+        this->_tasks[id].policy = policy;
+    }
+
+    uint8_t get_size(void)
+    {
+      return this->_n;
+    }
+
+    bool is_parked(uint8_t id)
+    {
+      return id < this->_n && this->_tasks[id].parked;
+    }
+
+    const ST_SCHEDULER_TASK_STATS &get_task_stats(uint8_t id)
+    {
+      return this->_tasks[id < this->_n ? id : 0].stats;
+    }
+
+    const ST_SCHEDULER_STATS &get_stats(void)
+    {
+      return this->_stats;
+    }
+
+    // Busy time in permille of the measured time
+    uint16_t get_duty_cycle(void)
+    {
+      const uint32_t total = this->_stats.busy_us + this->_stats.idle_us;
+
+      return total == 0 ? 0 : (uint16_t) ((uint64_t) this->_stats.busy_us * 1000 / total);
+    }
+
+    void reset_stats(void)
+    {
+      this->_stats = { 0, 0, 0, 0 };
+      for (uint8_t i = 0; i < this->_n; i++)
+        this->_tasks[i].stats = { 0, 0, 0, 0, 0 };
+    }
+
+  private:
+    typedef void (*_run_fp)(void *fsm);
+    typedef uint32_t (*_cycle_fp)(void *fsm);
+    typedef struct {
+      void *fsm;
+      _run_fp run;
+      _cycle_fp cycle;
+      uint32_t deadline_us;
+      // Cycle of the current deadline
+      uint32_t cycle_us;
+      E_SCHEDULER_POLICY policy;
+      bool parked;
+      ST_SCHEDULER_TASK_STATS stats;
+    } _ST_TASK;
+
+    template <class FSM>
+    static void _run(void *fsm)
+    {
+      ((FSM *) fsm)->run();
+    }
+
+    template <class FSM>
+    static uint32_t _cycle(void *fsm)
+    {
+      return ((FSM *) fsm)->get_current_cycle();
+    }
+
+    static bool _before(uint32_t a, uint32_t b)
+    {
+      return (int32_t) (a - b) < 0;
+    }
+
+    bool _earlier(uint8_t a, uint8_t b)
+    {
+      return _before(this->_tasks[this->_heap[a]].deadline_us, this->_tasks[this->_heap[b]].deadline_us);
+    }
+
+    void _swap(uint8_t a, uint8_t b)
+    {
+      const uint8_t tmp = this->_heap[a];
+
+      this->_heap[a] = this->_heap[b];
+      this->_heap[b] = tmp;
+    }
+
+    void _schedule(uint8_t id, uint32_t now)
+    {
+      _ST_TASK &task = this->_tasks[id];
+      const uint32_t cycle = task.cycle(task.fsm);
+
+      task.parked = cycle >= (uint32_t) SCHEDULER_CYCLE_NEVER;
+      if (task.parked)
+      {
+        this->_parked++;
+        return;
+      }
+      task.cycle_us = cycle * 1000UL;
+      task.deadline_us += task.cycle_us;
+      if (task.policy == SCHEDULER_SKIP && task.cycle_us > 0 && !_before(now, task.deadline_us))
+      {
+        // The first deadline of the grid after now
+        const uint32_t missed = (now - task.deadline_us) / task.cycle_us + 1;
+
+        task.deadline_us += missed * task.cycle_us;
+        task.stats.skipped += missed;
+      }
+
+      // Sift up
+      uint8_t i = this->_heap_n++;
+
+      this->_heap[i] = id;
+      while (i > 0 && this->_earlier(i, (i - 1) / 2))
+      {
+        this->_swap(i, (i - 1) / 2);
+        i = (i - 1) / 2;
+      }
+    }
+
+    uint8_t _pop(void)
+    {
+      const uint8_t id = this->_heap[0];
+      uint8_t i = 0;
+
+      this->_heap[0] = this->_heap[--this->_heap_n];
+
+      // Sift down
+      for (;;)
+      {
+        const uint8_t l = 2 * i + 1;
+        const uint8_t r = l + 1;
+        uint8_t min = i;
+
+        if (l < this->_heap_n && this->_earlier(l, min))
+          min = l;
+        if (r < this->_heap_n && this->_earlier(r, min))
+          min = r;
+        if (min == i)
+          break;
+        this->_swap(i, min);
+        i = min;
+      }
+
+      return id;
+    }
+
+    _ST_TASK _tasks[N];
+    uint8_t _heap[N];
+    uint8_t _n = 0;
+    uint8_t _heap_n = 0;
+    uint8_t _parked = 0;
+    bool _started = false;
+    void (*_idle_cb)(void) = NULL;
+    void (*_overrun_cb)(uint8_t id, uint32_t lateness_us) = NULL;
+    ST_SCHEDULER_STATS _stats = { 0, 0, 0, 0 };
+};
+
+#endif // _SCHEDULER_H
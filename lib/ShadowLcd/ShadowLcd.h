@@ -0,0 +1,163 @@
+/********************************************************************************
+ * @file    ShadowLcd.h
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Shadow framebuffer in front of a character LCD (LCD_I2C,
+ *          LiquidCrystal_I2C or anything with setCursor() and
+ *          write(buffer, size)), COLS x ROWS characters.
+ *          setCursor(), print() and clear() only change the RAM shadow.
+ *          render() compares the shadow with what the LCD shows and sends
+ *          the changed runs only, one cursor command and the characters of
+ *          each run, so the bus time of a frame is proportional to what
+ *          changed. clear() no longer clears the LCD (~2ms and a visible
+ *          flicker), the next render() overwrites the changed characters
+ *          with spaces instead.
+ *
+ *          Characters past the end of a row are discarded, so are '\r' and
+ *          '\n' (printed by println(), the LCD shows them as CGRAM glyphs).
+ *
+ *          Statistics: frames rendered and LCD bytes sent, split in cursor
+ *          commands and characters.
+ ********************************************************************************/
+
+#ifndef _SHADOW_LCD_H
+#define _SHADOW_LCD_H
+
+#include <stdint.h>
+#include <string.h>
+#include <Hal.h>
+
+typedef struct {
+  uint32_t frames;
+  uint32_t commands;
+  uint32_t chars;
+} ST_SHADOW_LCD_STATS;
+
+template <class LCD, uint8_t COLS, uint8_t ROWS>
+class SHADOW_LCD : public Print
+{
+  public:
+    SHADOW_LCD(LCD &lcd) : _lcd(lcd)
+    {
+      memset(this->_shadow, ' ', sizeof(this->_shadow));
+      memset(this->_front, ' ', sizeof(this->_front));
+    }
+
+    // Initializes the LCD, blank after init
+    void init(void)
+    {
+      this->_lcd.init();
+      memset(this->_front, ' ', sizeof(this->_front));
+      this->_dirty = true;
+    }
+
+    void backlight(void)
+    {
+      this->_lcd.backlight();
+    }
+
+    void clear(void)
+    {
+      memset(this->_shadow, ' ', sizeof(this->_shadow));
+      this->_col = 0;
+      this->_row = 0;
+      this->_dirty = true;
+    }
+
+    void setCursor(uint8_t col, uint8_t row)
+    {
+      this->_col = col;
+      this->_row = row;
+    }
+
+    using Print::write;
+    size_t write(uint8_t c) override
+    {
+      if (c == '\r' || c == '\n')
+        return 1;
+      if (this->_col >= COLS || this->_row >= ROWS)
+        return 0;
+
+      char &cell = this->_shadow[this->_row][this->_col++];
+
+      if (cell != (char) c)
+      {
+        cell = (char) c;
+        this->_dirty = true;
+      }
+
+      return 1;
+    }
+
+    // Sends the changed runs, returns the number of LCD bytes sent
+    uint16_t render(void)
+    {
+      uint16_t sent = 0;
+
+      if (!this->_dirty)
+        return 0;
+
+      for (uint8_t row = 0; row < ROWS; row++)
+      {
+        uint8_t col = 0;
+
+        while (col < COLS)
+        {
+          if (this->_shadow[row][col] == this->_front[row][col])
+          {
+            col++;
+            continue;
+          }
+
+          // A single unchanged character costs as much as a cursor command,
+          // so runs separated by one are merged
+          uint8_t end = col + 1;
+
+          while (end < COLS && (this->_shadow[row][end] != this->_front[row][end] ||
+            (end + 1 < COLS && this->_shadow[row][end + 1] != this->_front[row][end + 1])))
+            end++;
+
+          // One write per run, LCD_I2C sends it batched
+          this->_lcd.setCursor(col, row);
+          this->_lcd.write((const uint8_t *) &this->_shadow[row][col], end - col);
+          memcpy(&this->_front[row][col], &this->_shadow[row][col], end - col);
+          this->_stats.commands++;
+          this->_stats.chars += end - col;
+          sent += 1 + end - col;
+          col = end;
+        }
+      }
+      this->_dirty = false;
+      this->_stats.frames++;
+
+      return sent;
+    }
+
+    // Character at a position of the shadow
+    char get_char(uint8_t col, uint8_t row)
+    {
+      return col < COLS && row < ROWS ? this->_shadow[row][col] : '\0';
+    }
+
+    const ST_SHADOW_LCD_STATS &get_stats(void)
+    {
+      return this->_stats;
+    }
+
+    void reset_stats(void)
+    {
+      this->_stats = { 0, 0, 0 };
+    }
+
+  private:
+    LCD &_lcd;
+    char _shadow[ROWS][COLS];
+    // Content of the LCD
+    char _front[ROWS][COLS];
+    uint8_t _col = 0;
+    uint8_t _row = 0;
+    bool _dirty = true;
+    ST_SHADOW_LCD_STATS _stats = { 0, 0, 0 };
+};
+
+#endif // _SHADOW_LCD_H
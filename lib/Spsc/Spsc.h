@@ -0,0 +1,106 @@
+/*******************************************************************************
+ * @file    Spsc.h
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Lock-free single-producer/single-consumer ring buffer.
+ *          Meant for passing data from an ISR (producer) to the main loop
+ *          (consumer) without disabling interrupts. The head is only written
+ *          by the producer and the tail only by the consumer. The indices are
+ *          free running 8-bit counters, so every access is atomic on AVR and
+ *          the capacity N must be a power of two no larger than 128.
+ *
+ *          push() fails when the buffer is full; the producer decides what a
+ *          drop means (usually counting it).
+*******************************************************************************/
+
+#ifndef _SPSC_H
+#define _SPSC_H
+
+#include <stdint.h>
+
+#define SPSC_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+template <typename T, uint8_t N>
+class SPSC
+{
+  static_assert(N > 0 && N <= 128 && (N & (N - 1)) == 0, "SPSC capacity must be a power of two <= 128");
+
+  public:
+    bool push(const T &item)
+    {
+      const uint8_t head = this->_head;
+
+      if ((uint8_t) (head - this->_tail) == N)
+        return false;
+
+      this->_buf[head & (N - 1)] = item;
+      SPSC_BARRIER();
+      this->_head = head + 1;
+
+      return true;
+    }
+
+    bool pop(T &item)
+    {
+      const uint8_t tail = this->_tail;
+
+      if (tail == this->_head)
+        return false;
+
+      SPSC_BARRIER();
+      item = this->_buf[tail & (N - 1)];
+      SPSC_BARRIER();
+      this->_tail = tail + 1;
+
+      return true;
+    }
+
+    // Oldest item without removing it, consumer side
+    bool peek(T &item) const
+    {
+      const uint8_t tail = this->_tail;
+
+      if (tail == this->_head)
+        return false;
+
+      SPSC_BARRIER();
+      item = this->_buf[tail & (N - 1)];
+
+      return true;
+    }
+
+    // Producer side, age 0 is the newest item and must be below size(). The
+    // items popped meanwhile stay readable until the next push().
+    const T &newest(uint8_t age) const
+    {
+      return this->_buf[(uint8_t) (this->_head - 1 - age) & (N - 1)];
+    }
+
+    uint8_t size(void) const
+    {
+      return (uint8_t) (this->_head - this->_tail);
+    }
+
+    bool empty(void) const
+    {
+      return this->_head == this->_tail;
+    }
+
+    // Must only be called while the producer is stopped.
+    void clear(void)
+    {
+      this->_tail = this->_head;
+    }
+
+    static uint8_t capacity(void)
+    {
+      return N;
+    }
+
+  private:
+    T _buf[N];
+    volatile uint8_t _head = 0;
+    volatile uint8_t _tail = 0;
+};
+
+#endif // _SPSC_H
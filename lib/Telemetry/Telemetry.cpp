@@ -0,0 +1,221 @@
+/*******************************************************************************
+ * @file    Telemetry.cpp
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ *******************************************************************************/
+
+#include "Telemetry.h"
+
+static void _put_le(uint8_t *p, uint32_t value, uint8_t size)
+{
+  for (uint8_t i = 0; i < size; i++)
+  {
+    p[i] = value & 0xFF;
+    value >>= 8;
+  }
+}
+
+static uint32_t _get_le(const uint8_t *p, uint8_t size)
+{
+  uint32_t value = 0;
+
+  for (uint8_t i = size; i > 0; i--)
+    value = (value << 8) | p[i - 1];
+
+  return value;
+}
+
+uint8_t telemetry_crc8(const uint8_t *data, size_t len)
+{
+  uint8_t crc = 0;
+
+  for (size_t i = 0; i < len; i++)
+  {
+    crc ^= data[i];
+    for (uint8_t b = 0; b < 8; b++)
+      crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+  }
+
+  return crc;
+}
+
+size_t telemetry_cobs_encode(const uint8_t *data, size_t len, uint8_t *out)
+{
+  size_t code_i = 0;
+  size_t o = 1;
+  uint8_t code = 1;
+
+  for (size_t i = 0; i < len; i++)
+  {
+    if (data[i] == 0)
+    {
+      out[code_i] = code;
+      code_i = o++;
+      code = 1;
+    }
+    else
+    {
+      out[o++] = data[i];
+      if (++code == 0xFF)
+      {
+        out[code_i] = code;
+        code_i = o++;
+        code = 1;
+      }
+    }
+  }
+  out[code_i] = code;
+
+  return o;
+}
+
+size_t telemetry_cobs_decode(const uint8_t *data, size_t len, uint8_t *out)
+{
+  size_t i = 0;
+  size_t o = 0;
+
+  while (i < len)
+  {
+    const uint8_t code = data[i++];
+
+    if (code == 0 || i + code - 1 > len)
+      return 0;
+
+    for (uint8_t j = 1; j < code; j++)
+      out[o++] = data[i++];
+
+    if (code != 0xFF && i < len)
+      out[o++] = 0;
+  }
+
+  return o;
+}
+
+size_t telemetry_encode(const ST_TELEMETRY_READING &reading, uint8_t frame[TELEMETRY_FRAME_MAX])
+{
+  uint8_t record[TELEMETRY_RECORD_SIZE];
+
+  record[0] = TELEMETRY_TYPE_READING;
+  _put_le(&record[1], reading.timestamp, 4);
+  record[5] = reading.state;
+  _put_le(&record[6], reading.avalue, 2);
+  _put_le(&record[8], reading.millivolts, 2);
+  _put_le(&record[10], reading.rs, 4);
+  _put_le(&record[14], reading.mgL_q16, 4);
+  _put_le(&record[18], (uint16_t) reading.temperature, 2);
+  record[20] = telemetry_crc8(record, TELEMETRY_RECORD_SIZE - 1);
+
+  const size_t len = telemetry_cobs_encode(record, TELEMETRY_RECORD_SIZE, frame);
+
+  frame[len] = 0x00;
+
+  return len + 1;
+}
+
+size_t telemetry_encode_payload(uint8_t type, const uint8_t *data, size_t len,
+  uint8_t frame[TELEMETRY_PAYLOAD_FRAME_MAX])
+{
+  uint8_t record[TELEMETRY_PAYLOAD_MAX + 2];
+
+  if (len > TELEMETRY_PAYLOAD_MAX)
+    len = TELEMETRY_PAYLOAD_MAX;
+  record[0] = type;
+  for (size_t i = 0; i < len; i++)
+    record[1 + i] = data[i];
+  record[1 + len] = telemetry_crc8(record, 1 + len);
+
+  const size_t frame_len = telemetry_cobs_encode(record, len + 2, frame);
+
+  frame[frame_len] = 0x00;
+
+  return frame_len + 1;
+}
+
+bool TELEMETRY_DECODER::feed(uint8_t byte)
+{
+  if (byte != 0x00)
+  {
+    if (this->_len < sizeof(this->_buf))
+      this->_buf[this->_len++] = byte;
+    else
+      this->_overflow = true;
+
+    return false;
+  }
+
+  // End of frame
+  uint8_t record[TELEMETRY_PAYLOAD_FRAME_MAX];
+  const size_t len = this->_overflow ? 0 : telemetry_cobs_decode(this->_buf, this->_len, record);
+  const bool empty = this->_len == 0 && !this->_overflow;
+
+  this->_len = 0;
+  this->_overflow = false;
+
+  if (empty)
+    return false;
+
+  if (len < 2 || record[len - 1] != telemetry_crc8(record, len - 1))
+  {
+    this->_errors++;
+    return false;
+  }
+
+  if ((record[0] == TELEMETRY_TYPE_TEXT || record[0] == TELEMETRY_TYPE_HISTORY) && len - 2 <= TELEMETRY_PAYLOAD_MAX)
+  {
+    this->_type = record[0];
+    this->_payload_len = len - 2;
+    for (uint8_t i = 0; i < this->_payload_len; i++)
+      this->_payload[i] = record[1 + i];
+    this->_frames++;
+
+    return true;
+  }
+
+  if (len != TELEMETRY_RECORD_SIZE || record[0] != TELEMETRY_TYPE_READING)
+  {
+    this->_errors++;
+    return false;
+  }
+
+  this->_type = record[0];
+  this->_reading.timestamp = _get_le(&record[1], 4);
+  this->_reading.state = record[5];
+  this->_reading.avalue = _get_le(&record[6], 2);
+  this->_reading.millivolts = _get_le(&record[8], 2);
+  this->_reading.rs = _get_le(&record[10], 4);
+  this->_reading.mgL_q16 = _get_le(&record[14], 4);
+  this->_reading.temperature = (int16_t) _get_le(&record[18], 2);
+  this->_frames++;
+
+  return true;
+}
+
+uint8_t TELEMETRY_DECODER::get_type(void)
+{
+  return this->_type;
+}
+
+const ST_TELEMETRY_READING &TELEMETRY_DECODER::get_reading(void)
+{
+  return this->_reading;
+}
+
+const uint8_t *TELEMETRY_DECODER::get_payload(void)
+{
+  return this->_payload;
+}
+
+uint8_t TELEMETRY_DECODER::get_payload_len(void)
+{
+  return this->_payload_len;
+}
+
+uint32_t TELEMETRY_DECODER::get_frames(void)
+{
+  return this->_frames;
+}
+
+uint32_t TELEMETRY_DECODER::get_errors(void)
+{
+  return this->_errors;
+}
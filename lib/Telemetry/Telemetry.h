@@ -0,0 +1,100 @@
+/*******************************************************************************
+ * @file    Telemetry.h
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Compact binary telemetry of MQ3 readings.
+ *          A reading is a fixed layout record, serialized little endian:
+ *
+ *            offset  size  field
+ *            0       1     type (TELEMETRY_TYPE_READING)
+ *            1       4     timestamp in ms
+ *            5       1     state of the state machine
+ *            6       2     ADC value
+ *            8       2     sensor voltage in mV
+ *            10      4     Rs in Ohm
+ *            14      4     mg/L in Q16.16 (see MQ3::get_mgL_q16())
+ *            18      2     temperature in 0.01 degC, TELEMETRY_NO_TEMP if none
+ *            20      1     CRC-8 (poly 0x07) of bytes 0..19
+ *
+ *          The other records carry a payload of up to TELEMETRY_PAYLOAD_MAX
+ *          bytes:
+ *
+ *            offset  size  field
+ *            0       1     type
+ *            1       n     payload
+ *            1 + n   1     CRC-8 (poly 0x07) of bytes 0..n
+ *
+ *            - TELEMETRY_TYPE_TEXT: a line of text without its line ending,
+ *                     e.g. the replies to the serial commands.
+ *            - TELEMETRY_TYPE_HISTORY: a compressed block of the history of
+ *                     the readings, see HISTORY::next_block().
+ *
+ *          Records are COBS encoded and terminated by a 0x00 byte, so a frame
+ *          is at most TELEMETRY_FRAME_MAX bytes for a reading and
+ *          TELEMETRY_PAYLOAD_FRAME_MAX for a payload, and a receiver can
+ *          always resynchronize on the next 0x00. TELEMETRY_DECODER is the
+ *          receiving side, it takes the serial stream byte by byte.
+*******************************************************************************/
+
+#ifndef _TELEMETRY_H
+#define _TELEMETRY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define TELEMETRY_TYPE_READING 0x01
+#define TELEMETRY_TYPE_TEXT 0x02
+#define TELEMETRY_TYPE_HISTORY 0x03
+#define TELEMETRY_NO_TEMP INT16_MIN
+#define TELEMETRY_RECORD_SIZE 21U
+// COBS overhead byte and the delimiter
+#define TELEMETRY_FRAME_MAX (TELEMETRY_RECORD_SIZE + 2U)
+#define TELEMETRY_PAYLOAD_MAX 128U
+// Type and CRC, less than 254 bytes, so a single COBS overhead byte
+#define TELEMETRY_PAYLOAD_FRAME_MAX (TELEMETRY_PAYLOAD_MAX + 4U)
+
+typedef struct {
+  uint32_t timestamp;
+  uint8_t state;
+  uint16_t avalue;
+  uint16_t millivolts;
+  uint32_t rs;
+  uint32_t mgL_q16;
+  int16_t temperature;
+} ST_TELEMETRY_READING;
+
+uint8_t telemetry_crc8(const uint8_t *data, size_t len);
+size_t telemetry_cobs_encode(const uint8_t *data, size_t len, uint8_t *out);
+size_t telemetry_cobs_decode(const uint8_t *data, size_t len, uint8_t *out);
+// Encodes a full frame, including the delimiter, returns its length
+size_t telemetry_encode(const ST_TELEMETRY_READING &reading, uint8_t frame[TELEMETRY_FRAME_MAX]);
+// A payload longer than TELEMETRY_PAYLOAD_MAX is truncated
+size_t telemetry_encode_payload(uint8_t type, const uint8_t *data, size_t len,
+  uint8_t frame[TELEMETRY_PAYLOAD_FRAME_MAX]);
+
+class TELEMETRY_DECODER
+{
+  public:
+    // Returns true when a valid record was completed
+    bool feed(uint8_t byte);
+    // Type of the last record, the reading or the payload valid
+    uint8_t get_type(void);
+    const ST_TELEMETRY_READING &get_reading(void);
+    const uint8_t *get_payload(void);
+    uint8_t get_payload_len(void);
+    uint32_t get_frames(void);
+    uint32_t get_errors(void);
+
+  private:
+    uint8_t _buf[TELEMETRY_PAYLOAD_FRAME_MAX];
+    uint8_t _len = 0;
+    bool _overflow = false;
+    uint8_t _type = 0;
+    ST_TELEMETRY_READING _reading = { 0, 0, 0, 0, 0, 0, 0 };
+    uint8_t _payload[TELEMETRY_PAYLOAD_MAX];
+    uint8_t _payload_len = 0;
+    uint32_t _frames = 0;
+    uint32_t _errors = 0;
+};
+
+#endif // _TELEMETRY_H
@@ -8,7 +8,12 @@
 
 #include "Tfsm.h"
 
+#if TFSM_PROFILE
+TFSM::TFSM(ST_STATE pStates[], size_t n) :
+  _profile_states((ST_TFSM_PROFILE *) malloc(n * sizeof(ST_TFSM_PROFILE))), _profile(_profile_states, n)
+#else
 TFSM::TFSM(ST_STATE pStates[], size_t n)
+#endif
 {
   if (this->_pStates != NULL)
     free(this->_pStates);
@@ -27,6 +32,9 @@ TFSM::~TFSM()
 {
   if (this->_pStates != NULL)
     free(this->_pStates);
+#if TFSM_PROFILE
+  free(this->_profile_states);
+#endif
   this->_n = 0;
   this->_size = 0;
   this->_state = {0};
@@ -38,13 +46,16 @@ TFSM::~TFSM()
 void TFSM::_init(void)
 {
   this->_state = this->_pStates[0];
+  this->_current = 0;
   this->_alt_transition = false;
+  this->_next = UINT8_MAX;
 }
 
 void TFSM::_init(ST_STATE state)
 {
   this->_state = state;
   this->_alt_transition = false;
+  this->_next = UINT8_MAX;
   if (NULL == this->_state.action_arg)
   {
     switch (this->_action_arg_type)
@@ -60,13 +71,49 @@ void TFSM::_init(ST_STATE state)
   }
 }
 
+void TFSM::_action(void)
+{
+#if TFSM_PROFILE
+  const uint32_t start = hal_micros();
+#endif
+
+  if (this->_state.action != NULL)
+    this->_state.action(this->_state.action_arg);
+  --this->_state.steps;
+
+#if TFSM_PROFILE
+  this->_profile.action(this->_current, start);
+#endif
+}
+
+void TFSM::_delay_cb(void)
+{
+#if TFSM_PROFILE
+  const uint32_t start = hal_micros();
+
+  this->_state.delay_cb();
+  this->_profile.delay_cb(this->_current, start);
+#else
+  this->_state.delay_cb();
+#endif
+}
+
 void TFSM::run(void)
+{
+#if TFSM_PROFILE
+  this->_profile.dispatch(this->_current);
+  this->_run();
+  this->_profile.done(this->get_current_cycle());
+#else
+  this->_run();
+#endif
+}
+
+void TFSM::_run(void)
 {
   if (this->_state.steps > 0)
   {
-    if (this->_state.action != NULL)
-      this->_state.action(this->_state.action_arg);
-    --this->_state.steps;
+    this->_action();
 
     return;
   }
@@ -75,22 +122,25 @@ void TFSM::run(void)
   {
     if (--this->_state.delay == 0 && this->_state.delay_cb != NULL)
     {
-      this->_state.delay_cb();
+      this->_delay_cb();
       this->_state.delay_cb = NULL;
     }
   }
   else
   {
-    const uint8_t s = this->_alt_transition ? this->_state.alternate_transition : this->_state.primary_transition;
+    uint8_t s = this->_alt_transition ? this->_state.alternate_transition : this->_state.primary_transition;
 
+    if (this->_next < this->_n)
+      s = this->_next;
     if (this->_state.delay_cb != NULL)
-      this->_state.delay_cb();
+      this->_delay_cb();
 
+#if TFSM_PROFILE
+    this->_profile.transition(this->_current, s, this->_alt_transition);
+#endif
     this->_init(this->_pStates[s]);
-
-    if (this->_state.action != NULL)
-      this->_state.action(this->_state.action_arg);
-    --this->_state.steps;
+    this->_current = s;
+    this->_action();
   }
 }
 
@@ -104,6 +154,18 @@ int32_t TFSM::get_current_steps(void)
   return this->_state.steps;
 }
 
+uint8_t TFSM::get_current_state(void)
+{
+  return this->_current;
+}
+
+#if TFSM_PROFILE
+TFSM_PROFILER &TFSM::get_profile(void)
+{
+  return this->_profile;
+}
+#endif
+
 void TFSM::force_transition(void)
 {
   this->_state.steps = 0;
@@ -114,6 +176,22 @@ void TFSM::set_alt_transition(void)
   this->_alt_transition = true;
 }
 
+void TFSM::set_transition(uint8_t state)
+{
+  if (state < this->_n)
+    this->_next = state;
+}
+
+void TFSM::set_cycle(uint8_t state, uint32_t cycle)
+{
+  if (state >= this->_n)
+    return;
+
+  this->_pStates[state].cycle = cycle;
+  if (state == this->_current)
+    this->_state.cycle = cycle;
+}
+
 void TFSM::set_delay(int16_t delay)
 {
   if (delay > 0)
@@ -21,7 +21,8 @@
  *          abstraction model for real life, mainly embedded, apps.
  *
  *          States: The state table is an input to the object and is copied to
- *          a private dynamic array "_pStates"
+ *          a private dynamic array "_pStates". See TfsmP.h for a variant that
+ *          keeps a compile time validated state table in flash instead.
  *          Time Inputs:
  *            - cycle: The cycle time of the state in ms. Its periodicity. The
  *                     action of the state is executed every cycle. Currently
@@ -42,7 +43,9 @@
  *                       an alternate one. The primary one is by default used
  *                       for state transitioning. The alternate one must be 
  *                       manually set with the set_alt_transition() method, for
- *                       example in the action callback.
+ *                       example in the action callback. set_transition()
+ *                       overrides both for the next transition, to any state
+ *                       of the table, e.g. on an external request.
  *                       The "primary" transition is by default triggered at the
  *          State action: "action" is a callback, where the logic/action
  *                        of the state is assigned to. It is run at every cycle.
@@ -54,10 +57,16 @@
  *                        pointer) that shall be casted in the state action
  *                        callback. Currently, only char array arguments are
  *                        implemented.
+ *          Run time cycles: set_cycle() changes the cycle time of a state,
+ *                        from its next cycle on, e.g. to tune a deployed
+ *                        unit.
  *          Delay action: It is a special callback of the transition delay and
  *                        serves a practical purpose, for instance clearing a
  *                        LCD display during a state transition. It is run at
  *                        the end of the delayed transition.
+ *          Profiling: Built with TFSM_PROFILE=1 the action and delay_cb
+ *                     durations, the lateness of run() and the transitions
+ *                     of every state are recorded, see TfsmProfile.h.
  ********************************************************************************/
 
 
@@ -68,6 +77,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <string.h>
+#include "TfsmProfile.h"
 
 class TFSM
 {
@@ -84,13 +94,33 @@ class TFSM
       void * action_arg;
       state_delay_fp delay_cb;
     } ST_STATE;
+    template <size_t N>
+    static constexpr bool is_valid_table(const ST_STATE (&states)[N])
+    {
+      if (N == 0 || N > UINT8_MAX)
+        return false;
+
+      for (size_t i = 0; i < N; i++)
+      {
+        if (states[i].primary_transition >= N || states[i].alternate_transition >= N)
+          return false;
+        if (states[i].steps < 0 || states[i].delay < 0)
+          return false;
+      }
+
+      return true;
+    }
     TFSM(ST_STATE pStates[], size_t size);
     ~TFSM();
     void run(void);
     uint32_t get_current_cycle(void);
     int32_t get_current_steps(void);
+    uint8_t get_current_state(void);
     void force_transition(void);
     void set_alt_transition(void);
+    // Ignored for a state out of the table
+    void set_transition(uint8_t state);
+    void set_cycle(uint8_t state, uint32_t cycle);
     void set_delay(int16_t delay);
     void set_action_arg(const char str_action_arg[33]);
     void set_all(
@@ -99,6 +129,9 @@ class TFSM
       bool force_transition=false,
       const char *str_action_arg=NULL
     );
+#if TFSM_PROFILE
+    TFSM_PROFILER &get_profile(void);
+#endif
 
   private:
     typedef enum {
@@ -107,13 +140,23 @@ class TFSM
     } _E_ARG_TYPE;
     void _init(void);
     void _init(ST_STATE state);
-    ST_STATE *_pStates;
+    void _run(void);
+    void _action(void);
+    void _delay_cb(void);
+    ST_STATE *_pStates = NULL;
     size_t _n;
     size_t _size;
     ST_STATE _state;
+    uint8_t _current;
     _E_ARG_TYPE _action_arg_type;
     char _str_action_arg[33];
     bool _alt_transition;
+    // None while out of the table
+    uint8_t _next = UINT8_MAX;
+#if TFSM_PROFILE
+    ST_TFSM_PROFILE *_profile_states;
+    TFSM_PROFILER _profile;
+#endif
 };
 
 #endif // _TFSM_H
\ No newline at end of file
@@ -0,0 +1,208 @@
+/*******************************************************************************
+ * @file    TfsmP.cpp
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ *******************************************************************************/
+
+#include "TfsmP.h"
+
+#if TFSM_PROFILE
+TFSM_P::TFSM_P(const TFSM::ST_STATE *pStates_P, size_t n, ST_TFSM_PROFILE *profile /*=NULL*/) : _profile(profile, n)
+#else
+TFSM_P::TFSM_P(const TFSM::ST_STATE *pStates_P, size_t n)
+#endif
+{
+  this->_pStates_P = pStates_P;
+  this->_n = n;
+  this->_pending_action_arg = NULL;
+  this->_init(0);
+}
+
+void TFSM_P::_init(uint8_t state)
+{
+  const TFSM::ST_STATE *pState = &this->_pStates_P[state];
+
+  this->_current = state;
+  this->_steps = (int32_t) pgm_read_dword(&pState->steps);
+  this->_delay = (int16_t) pgm_read_word(&pState->delay);
+  this->_action_arg = pgm_read_ptr(&pState->action_arg);
+  this->_delay_cb_done = false;
+  this->_alt_transition = false;
+  this->_next = UINT8_MAX;
+
+  if (NULL == this->_action_arg && this->_pending_action_arg != NULL)
+  {
+    this->_action_arg = (void *) this->_pending_action_arg;
+    this->_pending_action_arg = NULL;
+  }
+}
+
+void TFSM_P::_action(void)
+{
+  const TFSM::state_action_fp action = (TFSM::state_action_fp) pgm_read_ptr(&this->_pStates_P[this->_current].action);
+
+#if TFSM_PROFILE
+  const uint32_t start = hal_micros();
+#endif
+
+  if (action != NULL)
+    action(this->_action_arg);
+  --this->_steps;
+
+#if TFSM_PROFILE
+  this->_profile.action(this->_current, start);
+#endif
+}
+
+void TFSM_P::run(void)
+{
+#if TFSM_PROFILE
+  this->_profile.dispatch(this->_current);
+  this->_run();
+  this->_profile.done(this->get_current_cycle());
+#else
+  this->_run();
+#endif
+}
+
+void TFSM_P::_run(void)
+{
+  if (this->_steps > 0)
+  {
+    this->_action();
+
+    return;
+  }
+
+  const TFSM::ST_STATE *pState = &this->_pStates_P[this->_current];
+  const TFSM::state_delay_fp delay_cb = this->_delay_cb_done ? NULL : (TFSM::state_delay_fp) pgm_read_ptr(&pState->delay_cb);
+
+  if (this->_delay > 0)
+  {
+    if (--this->_delay == 0 && delay_cb != NULL)
+    {
+#if TFSM_PROFILE
+      const uint32_t start = hal_micros();
+
+      delay_cb();
+      this->_profile.delay_cb(this->_current, start);
+#else
+      delay_cb();
+#endif
+      this->_delay_cb_done = true;
+    }
+  }
+  else
+  {
+    uint8_t s = this->_alt_transition ? pgm_read_byte(&pState->alternate_transition) : pgm_read_byte(&pState->primary_transition);
+
+    if (this->_next < this->_n)
+      s = this->_next;
+
+    if (delay_cb != NULL)
+    {
+#if TFSM_PROFILE
+      const uint32_t start = hal_micros();
+
+      delay_cb();
+      this->_profile.delay_cb(this->_current, start);
+#else
+      delay_cb();
+#endif
+    }
+
+#if TFSM_PROFILE
+    this->_profile.transition(this->_current, s, this->_alt_transition);
+#endif
+    this->_init(s);
+    this->_action();
+  }
+}
+
+uint32_t TFSM_P::get_current_cycle(void)
+{
+  if (this->_current == this->_cycle_state)
+    return this->_cycle;
+
+  return pgm_read_dword(&this->_pStates_P[this->_current].cycle);
+}
+
+int32_t TFSM_P::get_current_steps(void)
+{
+  return this->_steps;
+}
+
+uint8_t TFSM_P::get_current_state(void)
+{
+  return this->_current;
+}
+
+#if TFSM_PROFILE
+TFSM_PROFILER &TFSM_P::get_profile(void)
+{
+  return this->_profile;
+}
+#endif
+
+void TFSM_P::force_transition(void)
+{
+  this->_steps = 0;
+}
+
+void TFSM_P::set_alt_transition(void)
+{
+  this->_alt_transition = true;
+}
+
+void TFSM_P::set_transition(uint8_t state)
+{
+  if (state < this->_n)
+    this->_next = state;
+}
+
+void TFSM_P::set_cycle(uint8_t state, uint32_t cycle)
+{
+  if (state < this->_n)
+  {
+    this->_cycle_state = state;
+    this->_cycle = cycle;
+  }
+}
+
+void TFSM_P::set_delay(int16_t delay)
+{
+  if (delay > 0)
+  {
+    this->_delay = delay;
+  }
+}
+
+void TFSM_P::set_action_arg(const char *str_action_arg)
+{
+  if (str_action_arg != NULL && str_action_arg[0] != '\0')
+  {
+    this->_pending_action_arg = str_action_arg;
+  }
+}
+
+void TFSM_P::set_all(
+  bool alt_transition /*=false*/,
+  int16_t delay /*=-1*/,
+  bool force_transition /*=false*/,
+  const char *str_action_arg /*=NULL*/
+)
+{
+  this->set_action_arg(str_action_arg);
+
+  if (alt_transition)
+  {
+    this->set_alt_transition();
+  }
+
+  this->set_delay(delay);
+
+  if (force_transition)
+  {
+    this->force_transition();
+  }
+}
@@ -0,0 +1,105 @@
+/********************************************************************************
+ * @file    TfsmP.h
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Timed Finite State Machine with its state table in flash (PROGMEM).
+ *          Same model and API as TFSM (see Tfsm.h), but the state table is not
+ *          copied to RAM. Only the mutable part of the current state lives in
+ *          RAM: its index, the remaining steps and delay and the transition
+ *          flags. A transition reads the next state fields from flash instead
+ *          of copying a whole ST_STATE.
+ *
+ *          TFSM_STATIC is the preferred way to declare one. It takes the
+ *          state table as a template argument and validates it at compile
+ *          time with TFSM::is_valid_table(), e.g.:
+ *
+ *            constexpr TFSM::ST_STATE state_table[] PROGMEM = { ... };
+ *            TFSM_STATIC<state_table> Fsm;
+ *
+ *          Unlike TFSM, set_action_arg() does not copy the string. It must
+ *          outlive the transition, e.g. a string literal or a global.
+ *          set_cycle() overrides the cycle of one state at a time, the table
+ *          stays in flash: a call for another state drops the previous
+ *          override.
+ *
+ *          Built with TFSM_PROFILE=1, TFSM_STATIC profiles every state of
+ *          its table (see TfsmProfile.h). A TFSM_P constructed directly has
+ *          no profile storage unless given one.
+ ********************************************************************************/
+
+#ifndef _TFSM_P_H
+#define _TFSM_P_H
+
+#include <Hal.h>
+#include "Tfsm.h"
+#include "TfsmProfile.h"
+
+class TFSM_P
+{
+  public:
+#if TFSM_PROFILE
+    TFSM_P(const TFSM::ST_STATE *pStates_P, size_t n, ST_TFSM_PROFILE *profile=NULL);
+#else
+    TFSM_P(const TFSM::ST_STATE *pStates_P, size_t n);
+#endif
+    void run(void);
+    uint32_t get_current_cycle(void);
+    int32_t get_current_steps(void);
+    uint8_t get_current_state(void);
+    void force_transition(void);
+    void set_alt_transition(void);
+    // Ignored for a state out of the table
+    void set_transition(uint8_t state);
+    void set_cycle(uint8_t state, uint32_t cycle);
+    void set_delay(int16_t delay);
+    void set_action_arg(const char *str_action_arg);
+    void set_all(
+      bool alt_transition=false,
+      int16_t delay=-1,
+      bool force_transition=false,
+      const char *str_action_arg=NULL
+    );
+#if TFSM_PROFILE
+    TFSM_PROFILER &get_profile(void);
+#endif
+
+  private:
+    void _init(uint8_t state);
+    void _run(void);
+    void _action(void);
+    const TFSM::ST_STATE *_pStates_P;
+    uint8_t _n;
+    uint8_t _current;
+    int32_t _steps;
+    int16_t _delay;
+    void *_action_arg;
+    const char *_pending_action_arg;
+    bool _delay_cb_done;
+    bool _alt_transition;
+    // None while out of the table
+    uint8_t _next = UINT8_MAX;
+    uint8_t _cycle_state = UINT8_MAX;
+    uint32_t _cycle = 0;
+#if TFSM_PROFILE
+    TFSM_PROFILER _profile;
+#endif
+};
+
+template <const auto &STATES>
+class TFSM_STATIC : public TFSM_P
+{
+  static_assert(TFSM::is_valid_table(STATES), "Invalid TFSM state table");
+
+  public:
+#if TFSM_PROFILE
+    // Zeroed by the TFSM_PROFILER of the base, not initialized again here
+    TFSM_STATIC() : TFSM_P(STATES, sizeof(STATES) / sizeof(STATES[0]), _profile_states) {}
+
+  private:
+    ST_TFSM_PROFILE _profile_states[sizeof(STATES) / sizeof(STATES[0])];
+#else
+    TFSM_STATIC() : TFSM_P(STATES, sizeof(STATES) / sizeof(STATES[0])) {}
+#endif
+};
+
+#endif // _TFSM_P_H
@@ -0,0 +1,194 @@
+/*******************************************************************************
+ * @file    TfsmProfile.cpp
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ *******************************************************************************/
+
+#include <string.h>
+#include "TfsmProfile.h"
+
+TFSM_PROFILER::TFSM_PROFILER(ST_TFSM_PROFILE *states, uint8_t n)
+{
+  this->_states = states;
+  this->_n = states != NULL ? n : 0;
+  this->reset();
+}
+
+uint32_t TFSM_PROFILER::dispatch(uint8_t state)
+{
+  const uint32_t now = hal_micros();
+
+  if (state < this->_n)
+  {
+    ST_TFSM_PROFILE &s = this->_states[state];
+
+    // Lateness against the deadline the scheduler saw after the previous run
+    if (this->_dispatched && this->_cycle < TFSM_PROFILE_CYCLE_NEVER)
+    {
+      const uint32_t elapsed = now - this->_last_us;
+      const uint32_t cycle_us = this->_cycle * 1000UL;
+
+      _add(s.lateness_us, s.lateness_max_us, elapsed > cycle_us ? elapsed - cycle_us : 0);
+    }
+  }
+  this->_dispatched = true;
+  this->_last_us = now;
+
+  return now;
+}
+
+void TFSM_PROFILER::done(uint32_t cycle)
+{
+  this->_cycle = cycle;
+}
+
+void TFSM_PROFILER::action(uint8_t state, uint32_t start_us)
+{
+  const uint32_t us = hal_micros() - start_us;
+
+  if (state < this->_n)
+  {
+    this->_states[state].runs++;
+    _add(this->_states[state].action_us, this->_states[state].action_max_us, us);
+  }
+}
+
+void TFSM_PROFILER::delay_cb(uint8_t state, uint32_t start_us)
+{
+  const uint32_t us = hal_micros() - start_us;
+
+  if (state < this->_n)
+  {
+    ST_TFSM_PROFILE &s = this->_states[state];
+
+    s.delay_cbs++;
+    if (us > s.delay_cb_max_us)
+      s.delay_cb_max_us = us;
+  }
+}
+
+void TFSM_PROFILER::transition(uint8_t from, uint8_t to, bool alternate)
+{
+  if (from < this->_n && alternate)
+    this->_states[from].alternate++;
+  if (to < this->_n)
+    this->_states[to].entries++;
+}
+
+const ST_TFSM_PROFILE &TFSM_PROFILER::get(uint8_t state)
+{
+  static const ST_TFSM_PROFILE none = {};
+
+  return state < this->_n ? this->_states[state] : none;
+}
+
+uint8_t TFSM_PROFILER::get_size(void)
+{
+  return this->_n;
+}
+
+void TFSM_PROFILER::reset(void)
+{
+  if (this->_states != NULL)
+    memset(this->_states, 0, this->_n * sizeof(ST_TFSM_PROFILE));
+  // The next run has nothing to be late against
+  this->_dispatched = false;
+}
+
+void TFSM_PROFILER::print_header(Print &out)
+{
+  out.print(F("TFSM profile, bucket k counts [2^(k-1), 2^k) us, bucket 0 counts 0 us"));
+  out.println();
+}
+
+void TFSM_PROFILER::print(Print &out, uint8_t state)
+{
+  if (state >= this->_n)
+    return;
+
+  const ST_TFSM_PROFILE &s = this->_states[state];
+
+  out.print('S');
+  out.print(state);
+  out.print(F(" runs "));
+  out.print(s.runs);
+  out.print(F(" in "));
+  out.print(s.entries);
+  out.print(F(" alt "));
+  out.print(s.alternate);
+  out.print(F(" dcb "));
+  out.print(s.delay_cbs);
+  out.print(F(" max_us "));
+  out.print(s.action_max_us);
+  out.print(' ');
+  out.print(s.lateness_max_us);
+  out.print(' ');
+  out.print(s.delay_cb_max_us);
+  out.println();
+
+  _print_histogram(out, state, " act", s.action_us);
+  _print_histogram(out, state, " late", s.lateness_us);
+}
+
+void TFSM_PROFILER::print(Print &out)
+{
+  this->print_header(out);
+  for (uint8_t i = 0; i < this->_n; i++)
+    this->print(out, i);
+}
+
+uint8_t TFSM_PROFILER::bucket(uint32_t us)
+{
+  uint8_t b = 0;
+
+  // Bit length, a byte at a time first, 32-bit shifts are slow on AVR
+  if (us >> 16)
+  {
+    us >>= 16;
+    b = 16;
+  }
+  if (us >> 8)
+  {
+    us >>= 8;
+    b += 8;
+  }
+  while (us != 0)
+  {
+    us >>= 1;
+    b++;
+  }
+
+  return b < TFSM_PROFILE_BUCKETS ? b : TFSM_PROFILE_BUCKETS - 1;
+}
+
+/***************************/
+/* Private methods         */
+/***************************/
+
+void TFSM_PROFILER::_add(uint16_t *histogram, uint32_t &max_us, uint32_t us)
+{
+  uint16_t &count = histogram[bucket(us)];
+
+  if (count < UINT16_MAX)
+    count++;
+  if (us > max_us)
+    max_us = us;
+}
+
+void TFSM_PROFILER::_print_histogram(Print &out, uint8_t state, const char *name, const uint16_t *histogram)
+{
+  uint8_t used = TFSM_PROFILE_BUCKETS;
+
+  while (used > 0 && histogram[used - 1] == 0)
+    used--;
+
+  out.print('S');
+  out.print(state);
+  out.print(name);
+  for (uint8_t i = 0; i < used; i++)
+  {
+    out.print(' ');
+    out.print(histogram[i]);
+  }
+  out.println();
+}
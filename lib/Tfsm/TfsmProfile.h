@@ -0,0 +1,96 @@
+/********************************************************************************
+ * @file    TfsmProfile.h
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Optional instrumentation of TFSM and TFSM_STATIC, per state:
+ *            - action: duration of the state action in us.
+ *            - lateness: how late run() was called after the cycle time of
+ *                     the previous run (get_current_cycle() after it) had
+ *                     elapsed, in us. An early run counts as 0.
+ *            - transitions: entries into the state and exits through the
+ *                     alternate transition. The exits through the primary
+ *                     one are the rest, so with the state table they give
+ *                     every transition count.
+ *            - delay_cb: calls and the longest duration in us.
+ *
+ *          Durations and lateness go into log2 histograms of
+ *          TFSM_PROFILE_BUCKETS 16-bit counters, which saturate: bucket 0 is
+ *          0us, bucket k is [2^(k-1), 2^k) us, the last one includes anything
+ *          longer. The maximum of each is kept exactly.
+ *
+ *          Compile time: built only with TFSM_PROFILE=1, which changes the
+ *          layout of the machines, so it must be set for the whole build
+ *          (build_flags), not in a source file. Without it the machines
+ *          have neither the calls nor the members.
+ *
+ *          Query: get_profile() of the machine returns the TFSM_PROFILER,
+ *          get() the statistics of a state. print() writes them as text,
+ *          three lines per state, so a dump can be spread over several
+ *          calls to keep a buffered log from overflowing:
+ *
+ *            S<state> runs <n> in <n> alt <n> dcb <n> max_us <action> <lateness> <delay_cb>
+ *            S<state> act <bucket 0> <bucket 1> ...
+ *            S<state> late <bucket 0> <bucket 1> ...
+ *
+ *          The trailing empty buckets are left out.
+ ********************************************************************************/
+
+#ifndef _TFSM_PROFILE_H
+#define _TFSM_PROFILE_H
+
+#include <stdint.h>
+#include <Hal.h>
+
+#ifndef TFSM_PROFILE
+#define TFSM_PROFILE 0
+#endif
+
+// The last bucket starts at 2^18 us, ~262ms
+#define TFSM_PROFILE_BUCKETS 20U
+// Cycles that never elapse, e.g. UINT32_MAX waiting for the watchdog
+#define TFSM_PROFILE_CYCLE_NEVER (UINT32_MAX / 1000UL)
+
+typedef struct {
+  uint32_t runs;
+  uint32_t entries;
+  uint32_t alternate;
+  uint32_t delay_cbs;
+  uint32_t action_max_us;
+  uint32_t lateness_max_us;
+  uint32_t delay_cb_max_us;
+  uint16_t action_us[TFSM_PROFILE_BUCKETS];
+  uint16_t lateness_us[TFSM_PROFILE_BUCKETS];
+} ST_TFSM_PROFILE;
+
+class TFSM_PROFILER
+{
+  public:
+    // Statistics of n states in a caller provided array
+    TFSM_PROFILER(ST_TFSM_PROFILE *states, uint8_t n);
+    // At the start of run(), returns the current time
+    uint32_t dispatch(uint8_t state);
+    // At the end of run(), with the cycle time until the next one
+    void done(uint32_t cycle);
+    void action(uint8_t state, uint32_t start_us);
+    void delay_cb(uint8_t state, uint32_t start_us);
+    void transition(uint8_t from, uint8_t to, bool alternate);
+    const ST_TFSM_PROFILE &get(uint8_t state);
+    uint8_t get_size(void);
+    void reset(void);
+    // Describes the columns, once before a dump
+    void print_header(Print &out);
+    void print(Print &out, uint8_t state);
+    void print(Print &out);
+    static uint8_t bucket(uint32_t us);
+
+  private:
+    static void _add(uint16_t *histogram, uint32_t &max_us, uint32_t us);
+    static void _print_histogram(Print &out, uint8_t state, const char *name, const uint16_t *histogram);
+    ST_TFSM_PROFILE *_states;
+    uint8_t _n;
+    bool _dispatched = false;
+    uint32_t _last_us = 0;
+    uint32_t _cycle = 0;
+};
+
+#endif // _TFSM_PROFILE_H
@@ -3,15 +3,36 @@
  * @author  Kostas Markostamos
  * @date    31/03/2022
  * @brief   Main Arduino program file.
- *          Declares MQ3, TFSM and LiquidCrystal_I2C instances.
+ *          Declares MQ3, TFSM and LCD_I2C instances.
  *          Declares the states of the TFSM of the MQ3 sensor.
  *          Defines and declares the state action and delay callbacks of the MQ3
  *          sensor.
  *          Serial print at every state and delayed transition for internal
- *          info.
+ *          info, or binary telemetry records of the readings when built with
+ *          TELEMETRY_BINARY=1 (decoded on the host by tools/telemetry_decode).
+ *          Both go through a buffered logger that never blocks the state
+ *          actions, it is flushed to Serial in the idle time of the scheduler.
  *          LCD display at every state and delayed transition for user info.
- *          Program loop checks if cycle time of the TFSM elapsed and runs its
- *          current state action.
+ *          The states draw into a shadow framebuffer, only its changed
+ *          characters are sent to the LCD in the idle time of the scheduler.
+ *          The MQ3 samples are filtered per state: spike rejection for the
+ *          calibration, fewer samples for the measurements (see Mq3Filter.h).
+ *          Calibrations and warm-up checkpoints are appended to a
+ *          log-structured EEPROM store, written in the background. After a
+ *          reset that kept the sensor heated the warm-up resumes from the
+ *          last checkpoint instead of starting over.
+ *          The readings of STATE_MAIN are kept in a compressed history in
+ *          RAM (see lib/History).
+ *          Command lines received on Serial are parsed in the idle time of
+ *          the scheduler, see runCommand(): statistics, history dump,
+ *          recalibration and the cycle of STATE_MAIN at run time. The
+ *          replies go to the text log, or as text frames between the
+ *          telemetry frames in a binary build.
+ *          Built with TFSM_PROFILE=1 the execution times of the states are
+ *          logged every 10 minutes, see lib/Tfsm/TfsmProfile.h.
+ *          Program loop ticks the scheduler of the state machines: it runs the
+ *          current state action of a TFSM when its cycle time elapsed and idle
+ *          sleeps otherwise.
  *          Information about the project will be written in the README.
  * 
  *          TODO: - Comment state action functions.
@@ -24,21 +45,82 @@
 #include <Arduino.h>
 #include <Wire.h>
 #include <avr/wdt.h>
-#include <LiquidCrystal_I2C.h>
+#include <LcdI2c.h>
+#include <ShadowLcd.h>
 #include <OneWire.h> 
 #include <DallasTemperature.h>
-#include <EEPROM.h>
 #include <Tfsm.h>
+#include <TfsmP.h>
+#include <Scheduler.h>
+#include <Telemetry.h>
+#include <Logger.h>
+#include <ConfigStore.h>
+#include <EepromQueue.h>
+#include <History.h>
+#include <CommandParser.h>
 #include <Mq3.h>
+#include <Mq3Warmup.h>
 
 /**************************************
  * Defines
  **************************************/
 #define WDT_TIME_OFF 5
-#define EEPROM_VALID_CONFIG ((byte)'C')
-// At least 24h pre-heat time required
+// Marker of the configuration at fixed addresses, before CONFIG_STORE
+#define EEPROM_LEGACY_CONFIG ((byte)'C')
+#define CONFIG_CALIBRATION_VERSION 2
+#define CONFIG_CHECKPOINT_VERSION 1
+// Operating time of a calibration older than the checkpoints
+#define CONFIG_TIME_UNKNOWN UINT32_MAX
+// Warm-up progress and operating time saved every 5 minutes. The ring of the
+// store turns every ~21h, ~400 writes per EEPROM cell a year.
+#define CHECKPOINT_SEC (5*60L)
+// Pre-heat until Rs settles, at most 24h
 #define WARMUP_PERIOD_SEC (24*60*60L)
+#define WARMUP_MIN_SEC (20*60L)
+#define WARMUP_SAMPLE_SEC 10
+// Relative Rs drift per hour
+#define WARMUP_MAX_DRIFT 0.02
 #define CALIBRATION_STEPS 200
+// 3 standard deviations of R0 in % of R0
+#define CALIBRATION_PRECISION 1.0
+// 1000 samples decimated to 14 bits, the drift of Rs is small
+#define WARMUP_FILTER { MQ3_SAMPLES, 1, 0, 4 }
+// Median of 7 sub-blocks of 64 samples: rejects the spikes and keeps the
+// calibration steps independent, no EMA. 13 bits, 4^3 samples a sub-block.
+#define CALIBRATION_FILTER { 7 * 64, 7, 0, 3 }
+// Median of 5 sub-blocks of 64 samples, no EMA: the reading follows a
+// breath at the next cycle. 13 bits, 4^3 samples a sub-block.
+#define MAIN_FILTER { 5 * 64, 5, 0, 3 }
+#define TEMP_RESOLUTION 12
+// Number of state machines run by the scheduler
+#define MACHINES 1
+// Binary telemetry records on Serial instead of the text log
+#ifndef TELEMETRY_BINARY
+#define TELEMETRY_BINARY 0
+#endif
+// Serial log buffer, ~5 lines of state_main
+#define LOG_BUFFER_SIZE 512
+// Longer reply lines are split in frames in a binary build
+#define REPLY_LINE_MAX 80
+// Compressed history of the readings, 16 blocks of HISTORY_BLOCK_SIZE. The
+// reading with the highest mg/L of every 5s, ~4.3 bytes each in the replay
+// of the recordings: ~40 minutes.
+#define HISTORY_BUFFER_SIZE 2048
+#define HISTORY_SAMPLE_SEC 5
+// Cycle of STATE_MAIN, the cycle command sets it within the range until the
+// next reset. Below ~200ms the text log outruns 9600 baud and drops lines,
+// a binary reading record of ~24ms keeps up down to 100ms.
+#define MAIN_CYCLE_MS 1000
+#if TELEMETRY_BINARY
+#define MAIN_CYCLE_MIN_MS 100
+#else
+#define MAIN_CYCLE_MIN_MS 200
+#endif
+#define MAIN_CYCLE_MAX_MS 60000
+#if TFSM_PROFILE
+// Per state execution times of Fsm, logged every 10 minutes
+#define PROFILE_DUMP_SEC (10*60L)
+#endif
 
 /**************************************
  * Typedefs
@@ -54,6 +136,35 @@ typedef enum {
   STATE_RESET,
 } E_STATE;
 
+// Record types of the configuration store
+typedef enum {
+  E_CONFIG_CALIBRATION = 0,
+  E_CONFIG_CHECKPOINT,
+} E_CONFIG;
+
+// Packed, the layout of the stored records. Version 1 was
+// { float r0; float precision; }
+typedef struct __attribute__((packed)) {
+  float r0;
+  // Hundredths of %
+  uint16_t precision;
+  // Operating time when calibrated
+  uint32_t time_s;
+} ST_CONFIG_CALIBRATION;
+
+typedef struct __attribute__((packed)) {
+  // Seconds of operation, across resets
+  uint32_t operating_s;
+  uint32_t warmup_s;
+  // Ready, or out of time after WARMUP_PERIOD_SEC
+  bool warmup_ready;
+} ST_CONFIG_CHECKPOINT;
+
+static_assert(sizeof(ST_CONFIG_CALIBRATION) <= CONFIG_STORE_DATA, "Calibration record too large");
+static_assert(sizeof(ST_CONFIG_CHECKPOINT) <= CONFIG_STORE_DATA, "Checkpoint record too large");
+static_assert(HISTORY_BLOCK_SIZE <= TELEMETRY_PAYLOAD_MAX, "History block too large for a frame");
+static_assert(2 * HISTORY_BLOCK_SIZE + 4 < LOG_BUFFER_SIZE, "History block line too large for the log");
+
 typedef enum {
   E_ERROR_MSG_GENERIC = 0,
   E_ERROR_MSG_MQ3,
@@ -73,6 +184,17 @@ void state_verify(void* arg);
 void state_main(void* arg);
 void state_reset(void* arg);
 
+/**************************************
+ * EEPROM access functions prototypes
+ **************************************/
+static uint8_t eepromRead(uint16_t addr);
+static void eepromUpdate(uint16_t addr, uint8_t value);
+
+/**************************************
+ * Serial command functions prototypes
+ **************************************/
+static void pollCommands(void);
+
 /**************************************
  * Constants
  **************************************/
@@ -84,11 +206,11 @@ const char error_msg[E_ERROR_MSG_TOTAL][33] = {
 /**************************************
  * Variables
  **************************************/
-TFSM::ST_STATE state_table[] = { // cycle, steps, delay, primary_transition, alternate_transition, action, action_arg, delay_cb
+constexpr TFSM::ST_STATE state_table[] PROGMEM = { // cycle, steps, delay, primary_transition, alternate_transition, action, action_arg, delay_cb
   // STATE_CHECK_TEMPSENSOR
   {1000, 1, 1, STATE_INIT_WARMUP, STATE_RESET, state_check_tempsensor, NULL, delay_cb},
   // STATE_INIT_WARMUP
-  {0, 1, 0, STATE_RUN_WARMUP, STATE_RESET, state_initWarmUp, NULL, NULL},
+  {0, 1, 0, STATE_RUN_WARMUP, STATE_CONFIG, state_initWarmUp, NULL, NULL},
   // STATE_RUN_WARMUP
   {1000, WARMUP_PERIOD_SEC+1, 1, STATE_CONFIG, STATE_RESET, state_runWarmUp, NULL, delay_cb},
   // STATE_CONFIG
@@ -98,23 +220,113 @@ TFSM::ST_STATE state_table[] = { // cycle, steps, delay, primary_transition, alt
   // STATE_VERIFY
   {1000, 1, 1, STATE_MAIN, STATE_CONFIG, state_verify, NULL, delay_cb},
   // STATE_MAIN
-  {1000, 1, 0, STATE_MAIN, STATE_RESET, state_main, NULL, NULL},
+  {MAIN_CYCLE_MS, 1, 0, STATE_MAIN, STATE_RESET, state_main, NULL, NULL},
   // STATE_RESET
   {UINT32_MAX, 1, 0, STATE_RESET, STATE_RESET, state_reset, (void *) error_msg[E_ERROR_MSG_GENERIC], NULL}
 };
-uint32_t time = 0;
 
 /**************************************
  * Objects
  **************************************/
-LiquidCrystal_I2C display(0x27, 20, 4);
-TFSM Fsm(state_table, sizeof(state_table) / sizeof(TFSM::ST_STATE));
+// Batched I2C writes at 400kHz
+LCD_I2C Lcd(0x27, 20, 4);
+SHADOW_LCD<LCD_I2C, 20, 4> display(Lcd);
+// State table in flash, validated at compile time
+TFSM_STATIC<state_table> Fsm;
+// Runs the state machines on their deadlines, resets the watchdog and idle
+// sleeps in between
+SCHEDULER<MACHINES> Scheduler;
 MQ3 Mq3(A3);
+// Written from the EEPROM ready interrupt, the FSM does not wait ~3.3ms per byte
+EEPROM_QUEUE EepromQueue;
+// Calibrations appended over the whole EEPROM
+CONFIG_STORE Config(0, HAL_EEPROM_SIZE, eepromRead, eepromUpdate);
+MQ3Warmup Warmup(WARMUP_SAMPLE_SEC, WARMUP_MAX_DRIFT, WARMUP_MIN_SEC, WARMUP_PERIOD_SEC);
+uint32_t WarmupEta = MQ3_WARMUP_UNKNOWN;
+uint32_t WarmupEtaTimestamp = 0;
+// Warm-up seconds before the reset, taken off the WARMUP_PERIOD_SEC bound
+uint32_t WarmupResumed = 0;
+// Operating time until the newest checkpoint before the reset
+uint32_t OperatingBase = 0;
+uint32_t CheckpointTimestamp = 0;
+// Warm-up to continue after a reset that kept the sensor heated
+ST_CONFIG_CHECKPOINT Resume;
+bool Resuming = false;
 // OneWire instance
 OneWire oneWire(2);
 DallasTemperature Ds18b20(&oneWire);
 // Holds Dallas Temperature sensors addresses
 DeviceAddress InsideThermometer;
+// Last temperature read, the next conversion runs in the background
+float TempC = DEVICE_DISCONNECTED_C;
+bool TempRequested = false;
+uint32_t TempRequestMs;
+uint16_t TempConversionMs;
+uint8_t LogBuffer[LOG_BUFFER_SIZE];
+uint8_t HistoryBuffer[HISTORY_BUFFER_SIZE];
+HISTORY History(HistoryBuffer, sizeof(HistoryBuffer));
+// Peak of the current HISTORY_SAMPLE_SEC
+ST_HISTORY_RECORD HistoryPeak;
+bool HistoryPending = false;
+uint32_t HistoryTimestamp = 0;
+// Position of the dump in progress
+ST_HISTORY_CURSOR HistoryDump;
+bool HistoryDumping = false;
+// Serial command lines
+COMMAND_PARSER Command;
+uint32_t MainCycle = MAIN_CYCLE_MS;
+// STATE_CONFIG calibrates even with a valid calibration
+bool Recalibrate = false;
+#if TFSM_PROFILE
+uint32_t ProfileTimestamp = 0;
+// State of the dump in progress, none while past the last one
+uint8_t ProfileState = UINT8_MAX;
+#endif
+#if TELEMETRY_BINARY
+// Whole COBS frames or none
+LOGGER Logger(LogBuffer, sizeof(LogBuffer), LOGGER_DROP_MESSAGE, 0x00);
+// The text log is discarded, Serial carries the telemetry frames
+class NullPrint : public Print
+{
+  public:
+    size_t write(uint8_t c) { (void) c; return 1; }
+};
+NullPrint NullLog;
+Print &Log = NullLog;
+// The replies to the commands, a TELEMETRY_TYPE_TEXT frame per line
+class TextFramePrint : public Print
+{
+  public:
+    size_t write(uint8_t c)
+    {
+      uint8_t frame[TELEMETRY_PAYLOAD_FRAME_MAX];
+
+      if (c == '\r')
+        return 1;
+      if (c != '\n')
+      {
+        this->_line[this->_len++] = c;
+        if (this->_len < sizeof(this->_line))
+          return 1;
+      }
+      // End of the line, or split
+      Logger.write(frame, telemetry_encode_payload(TELEMETRY_TYPE_TEXT, this->_line, this->_len, frame));
+      this->_len = 0;
+
+      return 1;
+    }
+
+  private:
+    uint8_t _line[REPLY_LINE_MAX];
+    uint8_t _len = 0;
+};
+TextFramePrint Reply;
+#else
+// Whole lines or none
+LOGGER Logger(LogBuffer, sizeof(LogBuffer), LOGGER_DROP_MESSAGE, '\n');
+Print &Log = Logger;
+Print &Reply = Logger;
+#endif
 
 /***************************/
 /* Static functions        */
@@ -122,15 +334,412 @@ DeviceAddress InsideThermometer;
 
 static void printAll(const char str_msg[2][16], bool newline=false)
 {
-  for (uint8_t i; i < 2; i++)
+  for (uint8_t i = 0; i < 2; i++)
   {
-    Serial.print(str_msg[i]);
+    Log.print(str_msg[i]);
 
     display.setCursor(0, i);
     display.print(str_msg[i]);
   }
   if (newline)
-    Serial.println();
+    Log.println();
+}
+
+static void printTimestamp(Print &out=Log)
+{
+  out.print(millis()/1000);
+  out.print(F("  |  "));
+}
+
+// Reads the conversion requested at a previous call, once complete, and
+// requests the next one. Returns the last temperature read.
+static float updateTemperature(void)
+{
+  if (TempRequested)
+  {
+    // Timed rather than polled, polling would cut the strong pull-up of a
+    // parasite powered sensor
+    if (millis() - TempRequestMs < TempConversionMs)
+      return TempC;
+    TempC = Ds18b20.getTempC(InsideThermometer);
+  }
+
+  Ds18b20.requestTemperatures();
+  TempRequestMs = millis();
+  TempRequested = true;
+
+  return TempC;
+}
+
+static void sendTelemetry(uint32_t val, double rs, uint32_t mgL_q16, float tempC)
+{
+#if TELEMETRY_BINARY
+  uint8_t frame[TELEMETRY_FRAME_MAX];
+  const ST_TELEMETRY_READING reading = {
+    .timestamp = millis(),
+    .state = Fsm.get_current_state(),
+    .avalue = (uint16_t) val,
+    .millivolts = (uint16_t) ((val * 5000UL) >> 10),
+    .rs = (uint32_t) rs,
+    .mgL_q16 = mgL_q16,
+    .temperature = (int16_t) (tempC == DEVICE_DISCONNECTED_C ? TELEMETRY_NO_TEMP : tempC * 100),
+  };
+
+  Logger.write(frame, telemetry_encode(reading, frame));
+#else
+  (void) val;
+  (void) rs;
+  (void) mgL_q16;
+  (void) tempC;
+#endif
+}
+
+// Keeps the reading with the highest mg/L of every HISTORY_SAMPLE_SEC, a
+// breath peaks for a second or two
+static void recordHistory(double rs, uint32_t mgL_q16, float tempC)
+{
+  const ST_HISTORY_RECORD record = {
+    .time_s = (uint32_t) (millis()/1000),
+    // Saturated at ~27 mg/L, fits in 32 bits
+    .mgL_milli = (uint32_t) ((mgL_q16 * 1000UL + MQ3_MGL_ONE / 2) >> 16),
+    .rs = (uint32_t) rs,
+    .temperature = (int16_t) (tempC == DEVICE_DISCONNECTED_C ? HISTORY_NO_TEMP : tempC * 100),
+  };
+
+  if (!HistoryPending || record.mgL_milli > HistoryPeak.mgL_milli)
+    HistoryPeak = record;
+  HistoryPending = true;
+
+  if (record.time_s - HistoryTimestamp < HISTORY_SAMPLE_SEC)
+    return;
+  HistoryTimestamp = record.time_s;
+  History.append(HistoryPeak);
+  HistoryPending = false;
+}
+
+static void startHistoryDump(void)
+{
+  History.begin(HistoryDump);
+  HistoryDumping = true;
+  Reply.print(F("History, "));
+  Reply.print(History.get_count());
+  Reply.println(F(" readings in compressed blocks"));
+}
+
+// A compressed block per call, only once the log is empty, so the dump runs
+// at the speed of the serial port and never drops the lines of the states.
+// ~3.3x fewer bytes than the readings, ~2 KB for the whole history. A
+// TELEMETRY_TYPE_HISTORY frame in a binary build, else a line of hex:
+//   B <block>
+// tools/telemetry_decode decodes both into the readings.
+static void dumpHistory(void)
+{
+  uint8_t block[HISTORY_BLOCK_SIZE];
+  uint8_t len;
+
+  if (!HistoryDumping || Logger.get_pending() > 0)
+    return;
+
+  len = History.next_block(HistoryDump, block);
+  if (len == 0)
+  {
+    printTimestamp(Reply);
+    Reply.print(F("History end, "));
+    Reply.print(HistoryDump.lost);
+    Reply.println(F(" lost"));
+    HistoryDumping = false;
+    return;
+  }
+
+#if TELEMETRY_BINARY
+  uint8_t frame[TELEMETRY_PAYLOAD_FRAME_MAX];
+
+  Logger.write(frame, telemetry_encode_payload(TELEMETRY_TYPE_HISTORY, block, len, frame));
+#else
+  static const char hex[] = "0123456789ABCDEF";
+
+  Logger.print(F("B "));
+  for (uint8_t i = 0; i < len; i++)
+  {
+    Logger.write(hex[block[i] >> 4]);
+    Logger.write(hex[block[i] & 0x0F]);
+  }
+  Logger.println();
+#endif
+}
+
+#if TFSM_PROFILE
+// A state per call, only while the log is at most half full, so the dump
+// never drops the lines of the states
+static void dumpProfile(void)
+{
+  TFSM_PROFILER &profile = Fsm.get_profile();
+
+  if (ProfileState >= profile.get_size())
+  {
+    if (millis()/1000 - ProfileTimestamp < PROFILE_DUMP_SEC)
+      return;
+    ProfileTimestamp = millis()/1000;
+    ProfileState = 0;
+  }
+  if (Logger.get_pending() > LOG_BUFFER_SIZE / 2)
+    return;
+  if (ProfileState == 0)
+    profile.print_header(Log);
+  profile.print(Log, ProfileState++);
+}
+#endif
+
+static void idle_cb(void)
+{
+  // Blocks of the filters complete faster than the 1000ms cycles
+  Mq3.poll();
+  display.render();
+  pollCommands();
+  dumpHistory();
+#if TFSM_PROFILE
+  dumpProfile();
+#endif
+  Logger.pump();
+}
+
+static void overrun_cb(uint8_t id, uint32_t lateness_us)
+{
+  (void) id;
+  printTimestamp();
+  Log.print(F("Overrun by "));
+  Log.print(lateness_us / 1000);
+  Log.println(F("ms, catching up"));
+}
+
+static uint8_t eepromRead(uint16_t addr)
+{
+  return EepromQueue.read(addr);
+}
+
+static void eepromUpdate(uint16_t addr, uint8_t value)
+{
+  EepromQueue.update(addr, value);
+}
+
+// Finds the newest records, a configuration of the fixed addresses layout
+// (marker, R0 and precision) becomes the first record
+static void loadConfig(void)
+{
+  float legacy[2];
+  uint8_t *raw = (uint8_t *) legacy;
+
+  if (Config.begin() || hal_eeprom_read(0) != EEPROM_LEGACY_CONFIG)
+    return;
+
+  // double is a float on AVR, the layout of version 1
+  for (uint8_t i = 0; i < sizeof(legacy); i++)
+    raw[i] = hal_eeprom_read(1 + i);
+  Config.append(E_CONFIG_CALIBRATION, 1, legacy, sizeof(legacy));
+}
+
+static bool loadCalibration(ST_CONFIG_CALIBRATION &calib, uint16_t age=0)
+{
+  ST_CONFIG_RECORD record;
+
+  if (!Config.find(E_CONFIG_CALIBRATION, record, age))
+    return false;
+
+  if (record.version == 1)
+  {
+    float legacy[2];
+
+    memcpy(legacy, record.data, sizeof(legacy));
+    calib.r0 = legacy[0];
+    calib.precision = round(legacy[1] * 100);
+    calib.time_s = CONFIG_TIME_UNKNOWN;
+
+    return true;
+  }
+  if (record.version == CONFIG_CALIBRATION_VERSION)
+  {
+    memcpy(&calib, record.data, sizeof(calib));
+
+    return true;
+  }
+
+  return false;
+}
+
+static uint32_t operatingTime(void)
+{
+  return OperatingBase + millis()/1000;
+}
+
+// The warm-up resumes after a watchdog or an external reset, the sensor
+// stayed heated, or after a brown-out with its Rs checked again. After a
+// power-on it was unpowered for an unknown time and starts over.
+static void loadCheckpoint(void)
+{
+  const uint8_t cause = hal_reset_cause();
+  ST_CONFIG_RECORD record;
+
+  Log.print(F("Reset cause 0x"));
+  Log.println(cause, HEX);
+
+  if (!Config.find(E_CONFIG_CHECKPOINT, record) || record.version != CONFIG_CHECKPOINT_VERSION)
+    return;
+
+  memcpy(&Resume, record.data, sizeof(Resume));
+  OperatingBase = Resume.operating_s;
+  Resuming = cause != 0 && !(cause & HAL_RESET_POWER_ON);
+  if (cause & HAL_RESET_BROWN_OUT)
+    Resume.warmup_ready = false;
+}
+
+// Every CHECKPOINT_SEC, or at once
+static void saveCheckpoint(bool now=false)
+{
+  const uint32_t timestamp = millis()/1000;
+  ST_CONFIG_CHECKPOINT checkpoint;
+
+  if (!now && timestamp - CheckpointTimestamp < CHECKPOINT_SEC)
+    return;
+
+  checkpoint.operating_s = operatingTime();
+  checkpoint.warmup_s = Warmup.get_elapsed();
+  checkpoint.warmup_ready = Warmup.is_done();
+  Config.append(E_CONFIG_CHECKPOINT, CONFIG_CHECKPOINT_VERSION, &checkpoint, sizeof(checkpoint));
+  CheckpointTimestamp = timestamp;
+}
+
+static void printStats(void)
+{
+  const ST_SCHEDULER_TASK_STATS &task = Scheduler.get_task_stats(0);
+  const ST_HISTORY_STATS &history = History.get_stats();
+  ST_CONFIG_CALIBRATION calib;
+
+  Reply.print(F("State "));
+  Reply.print(Fsm.get_current_state());
+  Reply.print(F("  |  cycle "));
+  Reply.print(Fsm.get_current_cycle());
+  Reply.print(F("ms  |  operating "));
+  Reply.print(operatingTime());
+  Reply.println('s');
+
+  printTimestamp(Reply);
+  if (loadCalibration(calib))
+  {
+    Reply.print(F("[R0 = "));
+    Reply.print(Mq3.R0, 2);
+    Reply.print(F("] with precision "));
+    Reply.print(calib.precision / 100.0, 2);
+    Reply.println('%');
+  }
+  else
+  {
+    Reply.println(F("Not calibrated"));
+  }
+
+  printTimestamp(Reply);
+  Reply.print(F("Runs "));
+  Reply.print(task.runs);
+  Reply.print(F("  |  late max "));
+  Reply.print(task.lateness_max_us);
+  Reply.print(F("us  |  overruns "));
+  Reply.print(task.overruns);
+  Reply.print(F("  |  log dropped "));
+  Reply.println(Logger.get_stats().dropped_messages);
+
+  printTimestamp(Reply);
+  Reply.print(F("History "));
+  Reply.print(History.get_count());
+  Reply.print(F(" readings held  |  "));
+  Reply.print(history.records);
+  Reply.print(F(" appended in "));
+  Reply.print(history.bytes);
+  Reply.println(F(" bytes"));
+}
+
+// Commands, the replies go to Reply, the text log or text frames:
+//   stats       state, calibration, scheduler, log and history statistics
+//   recal       calibrates again from STATE_MAIN, through STATE_CONFIG
+//   cycle [MS]  prints or sets the cycle of STATE_MAIN
+//   dump        dumps the history
+static void runCommand(void)
+{
+  uint32_t cycle;
+
+  printTimestamp(Reply);
+
+  if (Command.is("stats"))
+  {
+    printStats();
+  }
+  else if (Command.is("recal"))
+  {
+    if (Fsm.get_current_state() != STATE_MAIN)
+    {
+      Reply.println(F("Recalibration only from STATE_MAIN"));
+      return;
+    }
+    Recalibrate = true;
+    Fsm.set_transition(STATE_CONFIG);
+    Fsm.force_transition();
+    Reply.println(F("Recalibration requested"));
+  }
+  else if (Command.is("cycle"))
+  {
+    if (Command.get_argc() > 1)
+    {
+      if (!Command.get_uint(1, cycle) || cycle < MAIN_CYCLE_MIN_MS || cycle > MAIN_CYCLE_MAX_MS)
+      {
+        Reply.print(F("Cycle out of "));
+        Reply.print(MAIN_CYCLE_MIN_MS);
+        Reply.print('-');
+        Reply.print(MAIN_CYCLE_MAX_MS);
+        Reply.println(F("ms"));
+        return;
+      }
+      MainCycle = cycle;
+      Fsm.set_cycle(STATE_MAIN, MainCycle);
+    }
+    Reply.print(F("STATE_MAIN cycle "));
+    Reply.print(MainCycle);
+    Reply.println(F("ms"));
+  }
+  else if (Command.is("dump"))
+  {
+    startHistoryDump();
+  }
+  else
+  {
+    Reply.print(F("Unknown command "));
+    Reply.print(Command.get_arg(0));
+    Reply.println(F(", try stats, recal, cycle [ms] or dump"));
+  }
+}
+
+// A line per call, and none while the log is more than half full: the rest
+// waits in the RX buffer, so the replies are never dropped
+static void pollCommands(void)
+{
+  int c;
+
+  if (Logger.get_pending() > LOG_BUFFER_SIZE / 2)
+    return;
+
+  while ((c = hal_serial_read()) >= 0)
+  {
+    const E_COMMAND_STATUS status = Command.feed(c);
+
+    if (status == COMMAND_READY)
+    {
+      runCommand();
+      return;
+    }
+    if (status == COMMAND_TOO_LONG)
+    {
+      printTimestamp(Reply);
+      Reply.println(F("Command too long"));
+      return;
+    }
+  }
 }
 
 /***************************/
@@ -139,8 +748,8 @@ static void printAll(const char str_msg[2][16], bool newline=false)
 
 void delay_cb(void)
 {
-  Serial.print(String(millis()/1000) + "  |  ");
-  Serial.println("display cleared");
+  printTimestamp();
+  Log.println("display cleared");
   display.clear();
 }
 
@@ -150,32 +759,35 @@ void state_check_tempsensor(void * arg)
 
   (void) arg;
 
-  Serial.print(String(millis()/1000) + "  |  ");
+  printTimestamp();
 
   if (devices > 0 && Ds18b20.getAddress(InsideThermometer, 0))
   {
     char str_buf[2][16] = { "" , "sensor found. "};
 
-    Ds18b20.setResolution(InsideThermometer, 12);
+    Ds18b20.setResolution(InsideThermometer, TEMP_RESOLUTION);
+    // requestTemperatures() returns at once, see updateTemperature()
+    Ds18b20.setWaitForConversion(false);
+    TempConversionMs = Ds18b20.millisToWaitForConversion(TEMP_RESOLUTION);
 
     sprintf(str_buf[0], "%d Temperature ", devices);
     printAll(str_buf);
 
-    Serial.print("Device 0 address, resolution, mode: ");
+    Log.print("Device 0 address, resolution, mode: ");
     for (uint8_t i = 0; i < 8; i ++)
     {
       if (InsideThermometer[i] < 16)
-        Serial.print("0");
-      Serial.print(InsideThermometer[i], HEX);
+        Log.print("0");
+      Log.print(InsideThermometer[i], HEX);
     }
 
-    Serial.print(", ");
-    Serial.print(Ds18b20.getResolution(InsideThermometer), DEC);
+    Log.print(", ");
+    Log.print(Ds18b20.getResolution(InsideThermometer), DEC);
 
     if (Ds18b20.isParasitePowerMode())
-      Serial.println(", 2-wire (parasite) mode.");
+      Log.println(", 2-wire (parasite) mode.");
     else
-      Serial.println(", 3-wire (normal) mode.");
+      Log.println(", 3-wire (normal) mode.");
   }
   else
   {
@@ -192,8 +804,35 @@ void state_initWarmUp(void* arg)
 {
   (void) arg;
 
-  Serial.print(String(millis()/1000) + "  |  ");
-  Serial.println("Warming up");
+  Warmup.reset();
+  WarmupEta = MQ3_WARMUP_UNKNOWN;
+  WarmupResumed = 0;
+  CheckpointTimestamp = millis()/1000;
+
+  printTimestamp();
+
+  if (Resuming)
+  {
+    Resuming = false;
+    Warmup.resume(Resume.warmup_s, Resume.warmup_ready);
+    WarmupResumed = Resume.warmup_s < WARMUP_PERIOD_SEC ? Resume.warmup_s : WARMUP_PERIOD_SEC;
+
+    Log.print(F("Resuming warm-up after "));
+    Log.print(Resume.warmup_s);
+    Log.println(Warmup.is_ready() ? F("s, ready") : Warmup.is_done() ? F("s, out of time") : F("s"));
+
+    // Straight to the configuration, also when out of time
+    if (Warmup.is_done())
+    {
+      display.setCursor(0,0);
+      display.print("Warmup resumed");
+      Fsm.set_alt_transition();
+
+      return;
+    }
+  }
+
+  Log.println("Warming up");
 
   display.setCursor(0,0);
   display.print("Warming up");
@@ -202,27 +841,41 @@ void state_initWarmUp(void* arg)
 void state_runWarmUp(void* arg)
 {
   const int32_t timer = Fsm.get_current_steps() - 1;
-  const int32_t hours = timer / 3600;
-  const int16_t minutes = (timer - hours * 3600) / 60;
-  const int16_t seconds = timer - hours * 3600 - minutes * 60;
+  const uint32_t timestamp = millis()/1000;
+  // Estimated time to ready, counting down between the estimates
+  const uint32_t since = timestamp - WarmupEtaTimestamp;
+  const uint32_t eta = WarmupEta == MQ3_WARMUP_UNKNOWN ? MQ3_WARMUP_UNKNOWN :
+    WarmupEta > since ? WarmupEta - since : 0;
+  // Bounded by the warm-up period, less the time before a reset
+  const int32_t bound = timer > (int32_t) WarmupResumed ? timer - (int32_t) WarmupResumed : 0;
+  const bool estimated = eta < (uint32_t) bound;
+  const int32_t left = estimated ? (int32_t) eta : bound;
+  const int32_t hours = left / 3600;
+  const int16_t minutes = (left - hours * 3600) / 60;
+  const int16_t seconds = left - hours * 3600 - minutes * 60;
+  const char *label = estimated ? "ETA" : "max";
   char str_hours[3] = {'\0'};
   char str_minutes[3] = {'\0'};
   char str_seconds[3] = {'\0'};
-  const String timestamp = String(millis()/1000);
 
   (void) arg;
 
-  sprintf(str_hours, "%02ld", hours);
+  sprintf(str_hours, "%02d", (int16_t) hours);
   sprintf(str_minutes, "%02d", minutes);
   sprintf(str_seconds, "%02d", seconds);
 
-  Serial.print(timestamp + "  |  ");
-  Serial.print(str_hours);
-  Serial.print(':');
-  Serial.print(str_minutes);
-  Serial.print(':');
-  Serial.println(str_seconds);
+  Log.print(timestamp);
+  Log.print(F("  |  "));
+  Log.print(label);
+  Log.print(' ');
+  Log.print(str_hours);
+  Log.print(':');
+  Log.print(str_minutes);
+  Log.print(':');
+  Log.println(str_seconds);
 
+  display.setCursor(0,1);
+  display.print(label);
   display.setCursor(4,1);
   display.print(str_hours);
   display.setCursor(6,1);
@@ -234,31 +887,55 @@ void state_runWarmUp(void* arg)
   display.setCursor(10,1);
   display.print(str_seconds);
 
-  if (timer % 10 == 9)
+  if (timer % WARMUP_SAMPLE_SEC == WARMUP_SAMPLE_SEC - 1)
   {
     uint32_t value;
     double volts, rs;
 
-    Serial.print(timestamp + "  |  ");
+    Log.print(timestamp);
+    Log.print(F("  |  "));
 
     if (Mq3.measure(value, volts, rs))
     {
       char str_buf[17] = {0};
 
-      if (volts < .605)
+      sendTelemetry(value, rs, 0, DEVICE_DISCONNECTED_C);
+
+      // Ready once Rs settled, judged over hours
+      if (Warmup.add(rs))
       {
         const char msg[] = "Warmup OK ";
 
-        Serial.print(msg);
-        Serial.print(' ');
+        Log.print(msg);
+        Log.print(' ');
+
+        display.setCursor(0,0);
+        display.print(msg);
+
+        Fsm.set_all(false, 3, true);
+        saveCheckpoint(true);
+      }
+      // Out of time, saved as done so that a reset does not start it over
+      else if (Warmup.is_done())
+      {
+        const char msg[] = "Warmup max";
+
+        Log.print(msg);
+        Log.print(' ');
 
         display.setCursor(0,0);
         display.print(msg);
 
         Fsm.set_all(false, 3, true);
+        saveCheckpoint(true);
       }
-      Serial.print(volts);
-      Serial.println("V");
+      WarmupEta = Warmup.get_time_to_ready();
+      WarmupEtaTimestamp = timestamp;
+
+      Log.print(volts);
+      Log.print(F("V  |  drift = "));
+      Log.print(Warmup.get_drift() * 100, 2);
+      Log.println(F(" %/h"));
 
       dtostrf(volts, 4, 2, str_buf);
       strcat(str_buf, "V");
@@ -266,49 +943,82 @@ void state_runWarmUp(void* arg)
       display.setCursor(11,0);
       display.print(str_buf);
     }
-    else
+    // No new block yet, e.g. catching up missed cycles, is not a fault
+    else if (!Mq3.is_pending())
     {
       Fsm.set_all(true, 0, true, error_msg[E_ERROR_MSG_MQ3]);
     }
   }
+
+  saveCheckpoint();
 }
 
 void state_config(void* arg)
 {
+  ST_CONFIG_CALIBRATION calib;
+
   (void) arg;
 
-  Serial.print(String(millis()/1000) + "  |  ");
+  printTimestamp();
 
-  if (EEPROM.read(0) == EEPROM_VALID_CONFIG)
+  // The recal command skips the stored calibration, it stays in the store
+  // until a new one is verified
+  if (!Recalibrate && loadCalibration(calib))
   {
-    EEPROM.get(1, Mq3.R0);
+    const double precision = calib.precision / 100.0;
+
+    Mq3.R0 = calib.r0;
     if (Mq3.is_valid())
     {
-      double precision;
-
-      EEPROM.get(1 + sizeof(Mq3.R0), precision);
-
-      Serial.println("Loaded Configuration  |  [R0 = " + String(Mq3.R0, 2) + "] with precision " + String(precision, 2));
+      Log.print(F("Loaded Configuration  |  [R0 = "));
+      Log.print(Mq3.R0, 2);
+      Log.print(F("] with precision "));
+      Log.print(precision, 2);
+      if (calib.time_s != CONFIG_TIME_UNKNOWN)
+      {
+        Log.print(F("  |  calibrated "));
+        Log.print((operatingTime() - calib.time_s) / 3600);
+        Log.print(F("h of operation ago"));
+      }
+      Log.println();
 
       display.setCursor(1,0);
       display.print("Loaded Config.");
       display.setCursor(0,1);
-      display.print("R0: " + String(round(Mq3.R0)) + " E: " + String(precision, 2) + "%");
+      display.print(F("R0: "));
+      display.print(round(Mq3.R0));
+      display.print(F(" E: "));
+      display.print(precision, 2);
+      display.print('%');
+
+      Mq3.set_filter(MAIN_FILTER);
 
       return;
     }
-    Serial.println("Loaded configuration is invalid");
+    Log.println("Loaded configuration is invalid");
     display.setCursor(0,0);
     display.print("Config. invalid");
   }
-  Serial.println("No configuration found");
+  if (Recalibrate)
+  {
+    Recalibrate = false;
+    Log.println(F("Recalibrating"));
+    display.clear();
+    display.setCursor(0,1);
+    display.print(F("Recalibrating"));
+  }
+  else
+  {
+    Log.println("No configuration found");
 
-  display.setCursor(0,1);
-  display.print("No config. found");
+    display.setCursor(0,1);
+    display.print("No config. found");
+  }
 
   Fsm.set_alt_transition();
 
   Mq3.clear_calibration();
+  Mq3.set_filter(CALIBRATION_FILTER);
 }
 
 void state_calibrate(void* arg)
@@ -326,17 +1036,19 @@ void state_calibrate(void* arg)
     const uint8_t id = (step - 1) % sizeof(msg);
     const uint8_t split_len = sizeof(msg) - id - 1;
 
-    Serial.print(String(millis()/1000) + "  |  ");
-    Serial.println(msg);
-    Serial.print("Sensor value = ");
-    Serial.print(val);
-    Serial.print("  |  ");
-    Serial.print("sensor volts = ");
-    Serial.print(volts);
-    Serial.print("V  |  calib R0 = ");
-    Serial.print(r0);
-    Serial.print(" | Step = ");
-    Serial.println(step);
+    sendTelemetry(val, r0 * 60.0, 0, DEVICE_DISCONNECTED_C);
+
+    printTimestamp();
+    Log.println(msg);
+    Log.print("Sensor value = ");
+    Log.print(val);
+    Log.print("  |  ");
+    Log.print("sensor volts = ");
+    Log.print(volts);
+    Log.print("V  |  calib R0 = ");
+    Log.print(r0);
+    Log.print(" | Step = ");
+    Log.println(step);
 
     if (split_len > 15)
     {
@@ -357,11 +1069,17 @@ void state_calibrate(void* arg)
     }
     sprintf(str_buf, "R0: %ld", round(r0));
     memset(&str_buf[strlen(str_buf)], (int)' ', 9 - strlen(str_buf));
-    sprintf(&str_buf[9], "%3ld/200", step);
+    sprintf(&str_buf[9], "%3ld/200", (long) step);
     display.setCursor(0,1);
     display.print(str_buf);
+
+    // Ends as soon as the precision is surely reached or out of reach,
+    // state_verify makes the final check
+    if (Mq3.check_calibration_sequential(CALIBRATION_PRECISION) != MQ3_CALIB_RUNNING)
+      Fsm.force_transition();
   }
-  else
+  // No new block yet, e.g. catching up missed cycles, is not a fault
+  else if (!Mq3.is_pending())
   {
     Fsm.set_all(true, 0, true, error_msg[E_ERROR_MSG_MQ3]);
   }
@@ -373,33 +1091,51 @@ void state_verify(void* arg)
 
   (void) arg;
 
-  Serial.print(String(millis()/1000) + "  |  ");
+  printTimestamp();
 
-  if (Mq3.check_calibration(1.0, precision))
+  if (Mq3.check_calibration(CALIBRATION_PRECISION, precision))
   {
-    EEPROM.write(0, EEPROM_VALID_CONFIG);
-    EEPROM.put(1, Mq3.R0);
-    EEPROM.put(1 + sizeof(Mq3.R0), precision);
+    const ST_CONFIG_CALIBRATION calib = { (float) Mq3.R0, (uint16_t) round(precision * 100), operatingTime() };
+    ST_CONFIG_CALIBRATION previous;
 
-    Serial.print("Calibrated " + String(precision, 2) + "%  |  ");
-    Serial.println("[R0 = " + String(Mq3.R0, 2) + "]");
+    // The previous calibration stays in the history
+    if (loadCalibration(previous))
+    {
+      Log.print(F("Previous R0 = "));
+      Log.println(previous.r0, 2);
+    }
+    Config.append(E_CONFIG_CALIBRATION, CONFIG_CALIBRATION_VERSION, &calib, sizeof(calib));
+
+    Log.print(F("Calibrated "));
+    Log.print(precision, 2);
+    Log.print(F("%  |  [R0 = "));
+    Log.print(Mq3.R0, 2);
+    Log.println(']');
 
     display.setCursor(0,0);
-    display.print("Calibrated " + String(precision, 1) + "%");
+    display.print(F("Calibrated "));
+    display.print(precision, 1);
+    display.print('%');
     display.setCursor(0,1);
-    display.print("R0: " + String(Mq3.R0, 2));
+    display.print(F("R0: "));
+    display.print(Mq3.R0, 2);
 
     Mq3.clear_calibration();
+    Mq3.set_filter(MAIN_FILTER);
   }
   else
   {
-    Serial.println("Error too high!");
-    Serial.println("Error: " + String(precision, 2) + "%");
+    Log.println("Error too high!");
+    Log.print(F("Error: "));
+    Log.print(precision, 2);
+    Log.println('%');
 
     display.setCursor(0,0);
     display.print("Error too high!");
     display.setCursor(2,1);
-    display.println("Error: " + String(precision, 2) + "%");
+    display.print(F("Error: "));
+    display.print(precision, 2);
+    display.println('%');
 
     Fsm.set_alt_transition();
   }
@@ -408,41 +1144,62 @@ void state_verify(void* arg)
 void state_main(void* arg)
 {
   uint32_t val;
-  float tempC;
+  float tempC = DEVICE_DISCONNECTED_C;
+  bool temp_sensor = false;
   double volts, rs;
-  String str_tempC = "";
   char str_buf[2][17] = {0};
 
   (void) arg;
 
-  Serial.print(String(millis()/1000) + "  |  ");
+  printTimestamp();
 
   if (Ds18b20.getDeviceCount() > 0)
   {
-    Ds18b20.requestTemperatures();
-    if ((tempC = Ds18b20.getTempC(InsideThermometer)) == DEVICE_DISCONNECTED_C)
+    // Converted during the previous cycle, none yet at the first one
+    temp_sensor = TempRequested;
+    tempC = updateTemperature();
+    if (!temp_sensor)
+    {
+      tempC = DEVICE_DISCONNECTED_C;
+    }
+    else if (tempC == DEVICE_DISCONNECTED_C)
     {
-      str_tempC = "Temperature sensor disconnected!  |  ";
       sprintf(str_buf[1], "Temp. discon'ed.");
     }
     else
     {
-      str_tempC = "Temperature: " + String(tempC, 1) + " °C  |  ";
       dtostrf(tempC, 8, 1, str_buf[1]);
     }
   }
 
   if (Mq3.measure(val, volts, rs))
   {
-    const double mgL = pow(0.4 * rs / Mq3.R0, -1.431);
-
-    Serial.print("Sensor value = ");
-    Serial.print(val);
-    Serial.print("  |  sensor_volt = ");
-    Serial.print(volts);
-    Serial.print("  |  mg/L = ");
-    Serial.print(mgL, 3);
-    Serial.println(str_tempC);
+    const uint32_t mgL_q16 = Mq3.get_mgL_q16();
+    const double mgL = mgL_q16 * (1.0 / MQ3_MGL_ONE);
+
+    sendTelemetry(val, rs, mgL_q16, tempC);
+    recordHistory(rs, mgL_q16, tempC);
+
+    Log.print("Sensor value = ");
+    Log.print(val);
+    Log.print("  |  sensor_volt = ");
+    Log.print(volts);
+    Log.print("  |  mg/L = ");
+    Log.print(mgL, 3);
+    if (!temp_sensor)
+    {
+      Log.println();
+    }
+    else if (tempC == DEVICE_DISCONNECTED_C)
+    {
+      Log.println(F("Temperature sensor disconnected!  |  "));
+    }
+    else
+    {
+      Log.print(F("Temperature: "));
+      Log.print(tempC, 1);
+      Log.println(F(" °C  |  "));
+    }
 
     dtostrf(mgL, 8, 2, str_buf[0]);
     display.setCursor(0, 0);
@@ -453,17 +1210,20 @@ void state_main(void* arg)
       display.print(str_buf[1]);
     }
   }
-  else
+  // No new block yet, e.g. catching up missed cycles, is not a fault
+  else if (!Mq3.is_pending())
   {
     Fsm.set_all(true, 0, true, error_msg[E_ERROR_MSG_MQ3]);
   }
-  Serial.println();
+  Log.println();
+
+  saveCheckpoint();
 }
 
 void state_reset(void* arg)
 {
-  Serial.print(String(millis()/1000) + "  |  ");
-  Serial.println("Unexpected error occured, resetting when watchdog expires...");
+  printTimestamp();
+  Log.println("Unexpected error occured, resetting when watchdog expires...");
 
   if (arg != NULL)
   {
@@ -492,6 +1252,8 @@ void setup(void)
 
   Mq3.init();
   Ds18b20.begin();
+  loadConfig();
+  loadCheckpoint();
 
   wdt_disable();
   sprintf(str_line1, " WDT OFF for %ds", WDT_TIME_OFF);
@@ -499,19 +1261,23 @@ void setup(void)
   display.print(str_line1);
   display.setCursor(0, 1);
   display.print(" safe FW upload");
+  display.render();
   delay(WDT_TIME_OFF*1000);
   display.clear();
+  // Interrupt driven MQ3 sampling, falls back to blocking measurements
+  Mq3.set_filter(WARMUP_FILTER);
+  Mq3.start_sampling();
   wdt_enable(WDTO_8S); // 8s Watchdog
+
+  // Missed cycles are caught up, the warm-up countdown counts steps and must
+  // keep the wall clock. The runs caught up find no new MQ3 block.
+  Scheduler.add(Fsm, SCHEDULER_CATCH_UP);
+  Scheduler.set_idle_cb(idle_cb);
+  Scheduler.set_overrun_cb(overrun_cb);
+  Scheduler.start();
 }
 
 void loop(void)
 {
-  if (millis() - time > Fsm.get_current_cycle())
-  {
-    time = millis();
-
-    Fsm.run();
-
-    wdt_reset();
-  }
+  Scheduler.tick();
 }
\ No newline at end of file
@@ -0,0 +1,37 @@
+/*******************************************************************************
+ * @file    bench.h
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Minimal host microbenchmark helper. BENCH() runs a statement a
+ *          number of times, measures the wall clock with std::chrono and
+ *          prints the time per iteration in ns. Run with:
+ *            pio test -e native -f test_bench -v
+*******************************************************************************/
+
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include <chrono>
+#include <stdio.h>
+
+static inline double bench_report(const char *name, uint64_t ns, uint32_t iterations)
+{
+  const double ns_per_op = (double) ns / iterations;
+
+  printf("BENCH %-32s %12.1f ns/op (%lu iterations)\n", name, ns_per_op, (unsigned long) iterations);
+
+  return ns_per_op;
+}
+
+// Evaluates to the measured ns per iteration of "stmt".
+#define BENCH(name, iterations, stmt)                                         \
+  ([&]() -> double {                                                          \
+    const auto _start = std::chrono::steady_clock::now();                     \
+    for (uint32_t _i = 0; _i < (uint32_t) (iterations); _i++) { stmt; }       \
+    const auto _end = std::chrono::steady_clock::now();                       \
+    return bench_report(name, (uint64_t)                                      \
+      std::chrono::duration_cast<std::chrono::nanoseconds>(_end - _start).count(), \
+      (iterations));                                                          \
+  }())
+
+#endif // _BENCH_H
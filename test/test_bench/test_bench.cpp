@@ -0,0 +1,473 @@
+/*******************************************************************************
+ * @file    test_bench.cpp
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Host microbenchmarks of the MQ3 and TFSM libraries. Reports ns per
+ *          call of the hot paths, to catch performance regressions. The ADC is
+ *          the simulated one of lib/Hal, so the numbers are the CPU cost of
+ *          the library code, not the ADC conversion time.
+*******************************************************************************/
+
+#include <math.h>
+#include <unity.h>
+#include <Hal.h>
+#include <Mq3.h>
+#include <Mq3Array.h>
+#include <Mq3Filter.h>
+#include <Tfsm.h>
+#include <TfsmP.h>
+#include <Telemetry.h>
+#include <Logger.h>
+#include <ShadowLcd.h>
+#include <LcdI2c.h>
+#include <ConfigStore.h>
+#include <EepromQueue.h>
+#include "bench.h"
+
+#define CALIBRATION_STEPS 200
+
+static volatile uint32_t sink = 0;
+
+// The text line of state_main for a reading
+static const char state_main_text[] = "123  |  Sensor value = 512  |  sensor_volt = 2.50  |  mg/L = 0.019"
+  "Temperature: 21.5 \xC2\xB0""C  |  \r\n\r\n";
+
+static void noop_action(void *arg) { (void) arg; sink++; }
+static void noop_delay(void) { sink++; }
+
+static constexpr TFSM::ST_STATE table_P[] PROGMEM = {
+  {1000, 10, 1, 1, 1, noop_action, NULL, noop_delay},
+  {1000, 10, 0, 0, 0, noop_action, NULL, NULL},
+};
+
+// Counts the bytes sent to the LCD
+class COUNTING_LCD
+{
+  public:
+    void init(void) {}
+    void backlight(void) {}
+    void setCursor(uint8_t col, uint8_t row) { (void) col; (void) row; bytes++; }
+    size_t write(uint8_t c) { (void) c; bytes++; return 1; }
+    size_t write(const uint8_t *buffer, size_t size) { (void) buffer; bytes += size; return size; }
+    size_t print(const char *str) { size_t n = strlen(str); bytes += n; return n; }
+
+    uint32_t bytes = 0;
+};
+
+void setUp(void)
+{
+  hal_sim_reset();
+  hal_sim_set_adc_conversion_us(0);
+}
+
+void tearDown(void)
+{
+}
+
+static void bench_mq3_measure(void)
+{
+  MQ3 mq3(A3);
+
+  hal_sim_set_adc_value(A3, 100);
+
+  TEST_ASSERT_TRUE(BENCH("MQ3::measure()", 10000, sink += mq3.measure()) > 0);
+}
+
+static void bench_mq3_measure_sampling(void)
+{
+  MQ3 mq3(A3);
+
+  hal_sim_set_adc_value(A3, 100);
+  TEST_ASSERT_TRUE(mq3.start_sampling());
+
+  // Includes the simulated ISR cost of one block of samples
+  TEST_ASSERT_TRUE(BENCH("MQ3::measure() sampling + ISR", 10000, {
+    hal_sim_advance_us((uint64_t) MQ3_SAMPLES * HAL_ADC_FREE_RUNNING_US);
+    sink += mq3.measure();
+  }) > 0);
+
+  TEST_ASSERT_TRUE(BENCH("MQ3::measure() sampling", 1000000, sink += mq3.measure()) > 0);
+}
+
+static void bench_mq3_array_measure(void)
+{
+  MQ3 mq3_0(A0), mq3_1(A1), mq3_2(A2), mq3_3(A3);
+  MQ3 *sensors[] = { &mq3_0, &mq3_1, &mq3_2, &mq3_3 };
+  MQ3Array array(sensors, 4);
+
+  for (uint8_t i = 0; i < 4; i++)
+    hal_sim_set_adc_value(A0 + i, 100 + i);
+
+  TEST_ASSERT_TRUE(BENCH("4x MQ3::measure()", 10000, {
+    for (uint8_t c = 0; c < 4; c++)
+      sink += sensors[c]->measure();
+  }) > 0);
+  TEST_ASSERT_TRUE(BENCH("MQ3Array::measure() 4 sensors", 10000, sink += array.measure()) > 0);
+}
+
+static void bench_mq3_calibrate(void)
+{
+  MQ3 mq3(A3);
+
+  hal_sim_set_adc_value(A3, 100);
+
+  TEST_ASSERT_TRUE(BENCH("MQ3::calibrate()", 10000, {
+    if (_i % CALIBRATION_STEPS == 0)
+      mq3.clear_calibration();
+    sink += mq3.calibrate();
+  }) > 0);
+}
+
+// Sensor at 300.37 LSB, 1.5 LSB of gaussian noise and 0.2% spikes of
+// +300 LSB, as the heater switching couples into the ADC
+#define NOISE_LEVEL 300.37
+#define NOISE_SD 1.5
+#define NOISE_SPIKE 300.0
+#define NOISE_SPIKE_RATE 0.002
+#define NOISE_MEASUREMENTS 2000U
+
+static uint32_t noise_state = 12345;
+
+static double noise_uniform(void)
+{
+  // xorshift32, reproducible across runs
+  noise_state ^= noise_state << 13;
+  noise_state ^= noise_state >> 17;
+  noise_state ^= noise_state << 5;
+
+  return (noise_state + 1.0) / 4294967297.0;
+}
+
+static uint16_t noise_sample(void)
+{
+  const double gauss = sqrt(-2.0 * log(noise_uniform())) * cos(2.0 * M_PI * noise_uniform());
+  const double spike = noise_uniform() < NOISE_SPIKE_RATE ? NOISE_SPIKE : .0;
+  const double value = NOISE_LEVEL + NOISE_SD * gauss + spike;
+
+  return value < 0 ? 0 : (value > 1023 ? 1023 : (uint16_t) (value + .5));
+}
+
+static void bench_mq3_filter(const char *name, const ST_MQ3_FILTER &config)
+{
+  MQ3Filter filter;
+  double sum = .0, sum2 = .0;
+  uint32_t block;
+
+  TEST_ASSERT_TRUE(filter.set_config(config));
+  noise_state = 12345;
+  for (uint32_t i = 0; i < NOISE_MEASUREMENTS; i++)
+  {
+    while (!filter.add(noise_sample(), block))
+      ;
+
+    const double x = filter.smooth(block, filter.get_block_samples()) / (double) MQ3_FILTER_ONE;
+
+    sum += x;
+    sum2 += x * x;
+  }
+
+  const double mean = sum / NOISE_MEASUREMENTS;
+  const double sd = sqrt(sum2 / NOISE_MEASUREMENTS - mean * mean);
+
+  printf("BENCH filter %-22s %5u samples: noise %.4f LSB, bias %+.4f LSB\n",
+    name, (unsigned) filter.get_block_samples(), sd, mean - NOISE_LEVEL);
+
+  const uint32_t iterations = 1000000;
+  char bench_name[40];
+
+  snprintf(bench_name, sizeof(bench_name), "MQ3Filter::add() %s", name);
+  TEST_ASSERT_TRUE(BENCH(bench_name, iterations, sink += filter.add(_i & 0x3FF, block)) > 0);
+}
+
+static void bench_mq3_filters(void)
+{
+  // The former fixed filter, then fewer samples with spike rejection and
+  // smoothing across measurements. The median only rejects the spikes while
+  // most sub-blocks have none, so short sub-blocks do better than long ones.
+  bench_mq3_filter("average", { MQ3_SAMPLES, 1, 0, 0 });
+  bench_mq3_filter("average", { 250, 1, 0, 0 });
+  bench_mq3_filter("median 5", { MQ3_SAMPLES, 5, 0, 0 });
+  bench_mq3_filter("median 5", { 250, 5, 0, 0 });
+  bench_mq3_filter("median 7", { 175, 7, 0, 0 });
+  bench_mq3_filter("median 5 + EMA 1/2", { 125, 5, 1, 0 });
+  bench_mq3_filter("median 5 + EMA 1/4", { 250, 5, 2, 0 });
+}
+
+// Clean air of the replay at 20 C, ~125 LSB: Rs is large, the ADC value
+// small and its 10-bit steps coarse
+#define RESOLUTION_LEVEL 125.37
+#define RESOLUTION_SD 0.7
+
+static uint16_t resolution_adc_read(uint8_t pin)
+{
+  const double gauss = sqrt(-2.0 * log(noise_uniform())) * cos(2.0 * M_PI * noise_uniform());
+
+  (void) pin;
+
+  return (uint16_t) (RESOLUTION_LEVEL + RESOLUTION_SD * gauss + .5);
+}
+
+static void bench_mq3_resolution(void)
+{
+  const double rs_true = MQ3::R * (1024.0 - RESOLUTION_LEVEL) / RESOLUTION_LEVEL;
+
+  // The same 1000 samples at every resolution
+  for (uint8_t bits = 0; bits <= MQ3_FILTER_EXTRA_BITS_MAX; bits += 2)
+  {
+    MQ3 mq3(A3, resolution_adc_read);
+    double sum = .0, sum2 = .0;
+    uint32_t val;
+    double volts, rs;
+
+    TEST_ASSERT_TRUE(mq3.set_filter({ MQ3_SAMPLES, 1, 0, bits }));
+    noise_state = 12345;
+    for (uint16_t i = 0; i < 1000; i++)
+    {
+      mq3.measure(val, volts, rs);
+      sum += rs;
+      sum2 += rs * rs;
+    }
+
+    const double mean = sum / 1000;
+
+    printf("BENCH resolution %u bits: Rs error %+.2f Ohm, noise %.2f Ohm (%.3f %%)\n",
+      (unsigned) mq3.get_bits(), mean - rs_true, sqrt(sum2 / 1000 - mean * mean), (mean - rs_true) / rs_true * 100);
+  }
+}
+
+static void bench_mq3_check_calibration(void)
+{
+  MQ3 mq3(A3);
+
+  hal_sim_set_adc_value(A3, 100);
+  for (uint16_t i = 0; i < CALIBRATION_STEPS; i++)
+    mq3.calibrate();
+
+  TEST_ASSERT_TRUE(BENCH("MQ3::check_calibration()", 100000, sink += mq3.check_calibration(1.0)) > 0);
+}
+
+static void bench_mq3_mgL(void)
+{
+  MQ3 mq3(A3);
+  volatile double rs = 4700.0 * 3.0;
+  double mgL = .0;
+
+  mq3.R0 = 700.0;
+  hal_sim_set_adc_value(A3, 300);
+  mq3.measure();
+
+  TEST_ASSERT_TRUE(BENCH("pow(0.4 * Rs / R0, -1.431)", 1000000, mgL += pow(0.4 * rs / mq3.R0, -1.431)) > 0);
+  TEST_ASSERT_TRUE(BENCH("MQ3::get_mgL_q16()", 1000000, sink += mq3.get_mgL_q16()) > 0);
+  TEST_ASSERT_TRUE(BENCH("MQ3::mgL_q16()", 1000000, sink += MQ3::mgL_q16(_i & 0x3FFFFF)) > 0);
+  TEST_ASSERT_TRUE(mgL > 0);
+}
+
+static void bench_telemetry(void)
+{
+  const ST_TELEMETRY_READING reading = { 123456, 6, 512, 2500, 4700, 1234, 2150 };
+  uint8_t frame[TELEMETRY_FRAME_MAX];
+  size_t len = 0;
+
+  TEST_ASSERT_TRUE(BENCH("telemetry_encode()", 1000000, len = telemetry_encode(reading, frame); sink += len) > 0);
+  printf("BENCH telemetry bytes per reading: %u binary, %u text\n", (unsigned) len, (unsigned) (sizeof(state_main_text) - 1));
+  TEST_ASSERT_TRUE(len * 4 < sizeof(state_main_text));
+}
+
+static void bench_logger(void)
+{
+  static uint8_t buf[512];
+  LOGGER logger(buf, sizeof(buf));
+  uint64_t start;
+  uint32_t direct_us, logger_us;
+
+  // Time the caller is blocked by a state_main line at 9600 baud
+  start = hal_sim_get_time_us();
+  hal_serial_write((const uint8_t *) state_main_text, sizeof(state_main_text) - 1);
+  direct_us = hal_sim_get_time_us() - start;
+
+  hal_sim_advance_us(1000000);
+  start = hal_sim_get_time_us();
+  logger.print(state_main_text);
+  logger_us = hal_sim_get_time_us() - start;
+  while (logger.get_pending() > 0)
+  {
+    logger.pump();
+    hal_idle();
+  }
+  printf("BENCH caller blocked per line: %lu us Serial, %lu us LOGGER\n", (unsigned long) direct_us, (unsigned long) logger_us);
+  TEST_ASSERT_TRUE(direct_us > 30000);
+  TEST_ASSERT_EQUAL_UINT32(0, logger_us);
+  TEST_ASSERT_EQUAL_UINT32(2 * (sizeof(state_main_text) - 1), hal_sim_get_serial_bytes());
+
+  TEST_ASSERT_TRUE(BENCH("LOGGER::print() line + pump()", 100000, {
+    logger.print(state_main_text);
+    sink += logger.pump();
+    hal_sim_advance_us(100000);
+  }) > 0);
+}
+
+static void bench_shadow_lcd(void)
+{
+  const uint16_t frames = 1000;
+  COUNTING_LCD direct, lcd;
+  SHADOW_LCD<COUNTING_LCD, 16, 2> display(lcd);
+  char str_buf[2][17];
+
+  // state_main frames: a slowly changing mg/L value and the temperature
+  for (uint16_t i = 0; i < frames; i++)
+  {
+    snprintf(str_buf[0], sizeof(str_buf[0]), "%8.2f mg/L", 0.1 + (i / 20) * 0.01);
+    snprintf(str_buf[1], sizeof(str_buf[1]), "%8.1f", 21.5 + (i / 100) * 0.1);
+
+    direct.setCursor(0, 0);
+    direct.print(str_buf[0]);
+    direct.setCursor(0, 1);
+    direct.print(str_buf[1]);
+
+    display.setCursor(0, 0);
+    display.print(str_buf[0]);
+    display.setCursor(0, 1);
+    display.print(str_buf[1]);
+    display.render();
+  }
+  printf("BENCH LCD bytes per state_main frame: %.2f direct, %.2f shadow\n",
+    (double) direct.bytes / frames, (double) lcd.bytes / frames);
+  TEST_ASSERT_TRUE(lcd.bytes * 10 < direct.bytes);
+
+  TEST_ASSERT_TRUE(BENCH("SHADOW_LCD::render() unchanged", 1000000, {
+    display.setCursor(0, 0);
+    display.print(str_buf[0]);
+    sink += display.render();
+  }) > 0);
+}
+
+// LiquidCrystal_I2C: one transaction per expander write, a 50us delay after
+// every E pulse
+static void legacy_expander_write(uint8_t value)
+{
+  hal_i2c_write(0x27, &value, 1);
+}
+
+static void legacy_send(uint8_t value, uint8_t mode)
+{
+  const uint8_t nibbles[2] = { (uint8_t) (value & 0xF0), (uint8_t) (value << 4) };
+
+  for (uint8_t i = 0; i < 2; i++)
+  {
+    const uint8_t bits = nibbles[i] | mode | 0x08;
+
+    legacy_expander_write(bits);
+    legacy_expander_write(bits | 0x04);
+    hal_delay_us(1);
+    legacy_expander_write(bits & ~0x04);
+    hal_delay_us(50);
+  }
+}
+
+static void bench_lcd_i2c(void)
+{
+  const char line[] = "Calibrating... K";
+  LCD_I2C lcd(0x27, 16, 2);
+  uint32_t transactions, bytes;
+  uint64_t start, legacy_us;
+
+  // Cursor command and a 16 character line, default 100kHz Wire clock
+  start = hal_sim_get_time_us();
+  legacy_send(0x80 | 0x40, 0);
+  for (uint8_t i = 0; i < sizeof(line) - 1; i++)
+    legacy_send(line[i], 0x01);
+  legacy_us = hal_sim_get_time_us() - start;
+  transactions = hal_sim_get_i2c_transactions();
+  bytes = hal_sim_get_i2c_bytes();
+  printf("BENCH LCD line LiquidCrystal_I2C: %lu transactions, %lu bytes, %lu us\n",
+    (unsigned long) transactions, (unsigned long) bytes, (unsigned long) legacy_us);
+
+  lcd.init();
+  lcd.reset_stats();
+  start = hal_sim_get_time_us();
+  lcd.setCursor(0, 1);
+  lcd.print(line);
+  const uint64_t lcd_us = hal_sim_get_time_us() - start;
+  printf("BENCH LCD line LCD_I2C:           %lu transactions, %lu bytes, %lu us\n",
+    (unsigned long) lcd.get_stats().transactions, (unsigned long) lcd.get_stats().bytes, (unsigned long) lcd_us);
+  TEST_ASSERT_TRUE(lcd.get_stats().transactions * 10 < transactions);
+  TEST_ASSERT_TRUE(lcd_us * 5 < legacy_us);
+
+  hal_sim_set_adc_conversion_us(0);
+  TEST_ASSERT_TRUE(BENCH("LCD_I2C line", 100000, {
+    lcd.setCursor(0, 1);
+    lcd.print(line);
+  }) > 0);
+}
+
+static EEPROM_QUEUE *bench_queue;
+static uint8_t bench_queue_read(uint16_t addr) { return bench_queue->read(addr); }
+static void bench_queue_update(uint16_t addr, uint8_t value) { bench_queue->update(addr, value); }
+
+static void bench_eeprom(void)
+{
+  EEPROM_QUEUE queue;
+  CONFIG_STORE direct;
+  CONFIG_STORE queued(0, HAL_EEPROM_SIZE, bench_queue_read, bench_queue_update);
+  const float calib[2] = { 42.0, 0.5 };
+  uint64_t start;
+  uint32_t direct_us, queued_us;
+
+  // Time the caller is blocked by the calibration record of state_verify
+  direct.begin();
+  start = hal_sim_get_time_us();
+  direct.append(0, 1, calib, sizeof(calib));
+  direct_us = hal_sim_get_time_us() - start;
+
+  bench_queue = &queue;
+  queued.begin();
+  start = hal_sim_get_time_us();
+  queued.append(0, 1, calib, sizeof(calib));
+  queued_us = hal_sim_get_time_us() - start;
+  hal_sim_advance_us(CONFIG_STORE_RECORD * HAL_EEPROM_WRITE_US);
+
+  printf("BENCH caller blocked per config record: %lu us EEPROM, %lu us EEPROM_QUEUE\n",
+    (unsigned long) direct_us, (unsigned long) queued_us);
+  TEST_ASSERT_TRUE(direct_us > 40000);
+  TEST_ASSERT_EQUAL_UINT32(0, queued_us);
+  TEST_ASSERT_TRUE(queue.is_idle());
+}
+
+static void bench_tfsm_run(void)
+{
+  TFSM::ST_STATE table[] = {
+    {1000, 10, 1, 1, 1, noop_action, NULL, noop_delay},
+    {1000, 10, 0, 0, 0, noop_action, NULL, NULL},
+  };
+  TFSM fsm(table, sizeof(table) / sizeof(TFSM::ST_STATE));
+
+  TEST_ASSERT_TRUE(BENCH("TFSM::run()", 1000000, fsm.run()) > 0);
+}
+
+static void bench_tfsm_p_run(void)
+{
+  TFSM_STATIC<table_P> fsm;
+
+  TEST_ASSERT_TRUE(BENCH("TFSM_P::run()", 1000000, fsm.run()) > 0);
+}
+
+int main(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(bench_mq3_measure);
+  RUN_TEST(bench_mq3_measure_sampling);
+  RUN_TEST(bench_mq3_array_measure);
+  RUN_TEST(bench_mq3_calibrate);
+  RUN_TEST(bench_mq3_filters);
+  RUN_TEST(bench_mq3_resolution);
+  RUN_TEST(bench_mq3_check_calibration);
+  RUN_TEST(bench_mq3_mgL);
+  RUN_TEST(bench_telemetry);
+  RUN_TEST(bench_logger);
+  RUN_TEST(bench_shadow_lcd);
+  RUN_TEST(bench_lcd_i2c);
+  RUN_TEST(bench_eeprom);
+  RUN_TEST(bench_tfsm_run);
+  RUN_TEST(bench_tfsm_p_run);
+  return UNITY_END();
+}
@@ -0,0 +1,130 @@
+/*******************************************************************************
+ * @file    test_command_parser.cpp
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Unit tests of the COMMAND_PARSER class. They run both natively and
+ *          on target.
+*******************************************************************************/
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <string.h>
+#include <unity.h>
+#include <CommandParser.h>
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+// Feeds a string, returns the status of its last byte
+static E_COMMAND_STATUS feed(COMMAND_PARSER &parser, const char *str)
+{
+  E_COMMAND_STATUS status = COMMAND_PENDING;
+
+  for (; *str != '\0'; str++)
+    status = parser.feed(*str);
+
+  return status;
+}
+
+static void test_incremental(void)
+{
+  COMMAND_PARSER parser;
+
+  TEST_ASSERT_EQUAL(COMMAND_PENDING, feed(parser, "cyc"));
+  TEST_ASSERT_EQUAL(COMMAND_PENDING, feed(parser, "le  \t2"));
+  TEST_ASSERT_EQUAL(COMMAND_PENDING, feed(parser, "50 "));
+  TEST_ASSERT_EQUAL(COMMAND_READY, feed(parser, "\r"));
+  TEST_ASSERT_TRUE(parser.is("cycle"));
+  TEST_ASSERT_EQUAL_UINT8(2, parser.get_argc());
+  TEST_ASSERT_EQUAL_STRING("250", parser.get_arg(1));
+  TEST_ASSERT_EQUAL_STRING("", parser.get_arg(2));
+
+  // The '\n' of "\r\n" is an empty line
+  TEST_ASSERT_EQUAL(COMMAND_PENDING, feed(parser, "\n"));
+  TEST_ASSERT_EQUAL_UINT8(0, parser.get_argc());
+  TEST_ASSERT_FALSE(parser.is("cycle"));
+  TEST_ASSERT_EQUAL(COMMAND_READY, feed(parser, "stats\n"));
+  TEST_ASSERT_TRUE(parser.is("stats"));
+  TEST_ASSERT_EQUAL_UINT8(1, parser.get_argc());
+  TEST_ASSERT_EQUAL_UINT32(2, parser.get_stats().lines);
+}
+
+static void test_backspace(void)
+{
+  COMMAND_PARSER parser;
+
+  TEST_ASSERT_EQUAL(COMMAND_READY, feed(parser, "\bdumx\b\x7Fmp\n"));
+  TEST_ASSERT_TRUE(parser.is("dump"));
+}
+
+static void test_too_long(void)
+{
+  COMMAND_PARSER parser;
+  char line[COMMAND_LINE_MAX + 2];
+
+  memset(line, 'x', COMMAND_LINE_MAX);
+  line[COMMAND_LINE_MAX] = '\0';
+  // At most COMMAND_LINE_MAX characters
+  TEST_ASSERT_EQUAL(COMMAND_PENDING, feed(parser, line));
+  TEST_ASSERT_EQUAL(COMMAND_READY, feed(parser, "\n"));
+  TEST_ASSERT_EQUAL_UINT32(COMMAND_LINE_MAX, strlen(parser.get_arg(0)));
+
+  // Discarded whole, then the next line is parsed
+  line[COMMAND_LINE_MAX] = 'y';
+  line[COMMAND_LINE_MAX + 1] = '\0';
+  TEST_ASSERT_EQUAL(COMMAND_PENDING, feed(parser, line));
+  TEST_ASSERT_EQUAL(COMMAND_PENDING, feed(parser, " stats"));
+  TEST_ASSERT_EQUAL(COMMAND_TOO_LONG, feed(parser, "\n"));
+  TEST_ASSERT_EQUAL(COMMAND_READY, feed(parser, "recal\n"));
+  TEST_ASSERT_TRUE(parser.is("recal"));
+  TEST_ASSERT_EQUAL_UINT32(1, parser.get_stats().too_long);
+}
+
+static void test_words(void)
+{
+  COMMAND_PARSER parser;
+  uint32_t value = 7;
+
+  TEST_ASSERT_EQUAL(COMMAND_READY, feed(parser, "a 4294967295 4294967296 12x e f\n"));
+  TEST_ASSERT_EQUAL_UINT8(COMMAND_ARGS_MAX, parser.get_argc());
+  TEST_ASSERT_TRUE(parser.get_uint(1, value));
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, value);
+  TEST_ASSERT_FALSE(parser.get_uint(2, value));
+  TEST_ASSERT_FALSE(parser.get_uint(3, value));
+  TEST_ASSERT_FALSE(parser.get_uint(4, value));
+  TEST_ASSERT_FALSE(parser.get_uint(0, value));
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, value);
+}
+
+static int run_tests(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_incremental);
+  RUN_TEST(test_backspace);
+  RUN_TEST(test_too_long);
+  RUN_TEST(test_words);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup(void)
+{
+  delay(2000);
+  run_tests();
+}
+
+void loop(void)
+{
+}
+#else
+int main(void)
+{
+  return run_tests();
+}
+#endif
@@ -0,0 +1,275 @@
+/*******************************************************************************
+ * @file    test_history.cpp
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Unit tests of the HISTORY class and of its delta, zig-zag and
+ *          varint encoding. They run both natively and on target.
+*******************************************************************************/
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <string.h>
+#include <unity.h>
+#include <History.h>
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+// A reading a second after the previous one
+static ST_HISTORY_RECORD reading(uint32_t i)
+{
+  const ST_HISTORY_RECORD record = {
+    .time_s = 1000 + i,
+    .mgL_milli = (i % 50) < 10 ? 400 + 20 * (i % 50) : 5,
+    .rs = 33000 - 17 * (i % 7),
+    .temperature = (int16_t) (2150 + (i / 60) * 6),
+  };
+
+  return record;
+}
+
+static void assert_record(const ST_HISTORY_RECORD &expected, const ST_HISTORY_RECORD &actual)
+{
+  TEST_ASSERT_EQUAL_UINT32(expected.time_s, actual.time_s);
+  TEST_ASSERT_EQUAL_UINT32(expected.mgL_milli, actual.mgL_milli);
+  TEST_ASSERT_EQUAL_UINT32(expected.rs, actual.rs);
+  TEST_ASSERT_EQUAL_INT16(expected.temperature, actual.temperature);
+}
+
+static void test_varint(void)
+{
+  const int32_t values[] = { 0, -1, 1, 63, -64, 64, 8191, -8192, 8192, INT32_MAX, INT32_MIN };
+  const uint8_t lengths[] = { 1, 1, 1, 1, 1, 2, 2, 2, 3, 5, 5 };
+  uint8_t data[HISTORY_VARINT_MAX];
+  uint32_t value;
+
+  TEST_ASSERT_EQUAL_UINT32(0, history_zigzag(0));
+  TEST_ASSERT_EQUAL_UINT32(1, history_zigzag(-1));
+  TEST_ASSERT_EQUAL_UINT32(2, history_zigzag(1));
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, history_zigzag(INT32_MIN));
+
+  for (uint8_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+  {
+    const uint8_t len = history_varint_encode(history_zigzag(values[i]), data);
+
+    TEST_ASSERT_EQUAL_UINT8(lengths[i], len);
+    TEST_ASSERT_EQUAL_UINT8(len, history_varint_decode(data, value));
+    TEST_ASSERT_EQUAL_INT32(values[i], history_unzigzag(value));
+  }
+}
+
+static void test_round_trip(void)
+{
+  uint8_t buf[4 * HISTORY_BLOCK_SIZE];
+  HISTORY history(buf, sizeof(buf));
+  ST_HISTORY_CURSOR cursor;
+  ST_HISTORY_RECORD record;
+  ST_HISTORY_RECORD extreme = { UINT32_MAX, 0, 1, HISTORY_NO_TEMP };
+
+  for (uint32_t i = 0; i < 40; i++)
+    history.append(reading(i));
+  // Any difference, wrapping around
+  history.append(extreme);
+  extreme = { 5, 10000, UINT32_MAX, INT16_MAX };
+  history.append(extreme);
+
+  history.begin(cursor);
+  for (uint32_t i = 0; i < 40; i++)
+  {
+    TEST_ASSERT_TRUE(history.next(cursor, record));
+    assert_record(reading(i), record);
+  }
+  TEST_ASSERT_TRUE(history.next(cursor, record));
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, record.time_s);
+  TEST_ASSERT_EQUAL_INT16(HISTORY_NO_TEMP, record.temperature);
+  TEST_ASSERT_TRUE(history.next(cursor, record));
+  assert_record(extreme, record);
+  TEST_ASSERT_FALSE(history.next(cursor, record));
+  TEST_ASSERT_EQUAL_UINT16(42, history.get_count());
+  TEST_ASSERT_EQUAL_UINT32(0, cursor.lost);
+}
+
+static void test_compression(void)
+{
+  uint8_t buf[4 * HISTORY_BLOCK_SIZE];
+  HISTORY history(buf, sizeof(buf));
+
+  for (uint32_t i = 0; i < 60; i++)
+    history.append(reading(i));
+
+  const ST_HISTORY_STATS &stats = history.get_stats();
+
+  // Blocks of ~25 records of ~5 bytes, with the headers and unused bytes
+  TEST_ASSERT_EQUAL_UINT32(60, stats.records);
+  TEST_ASSERT_TRUE(stats.bytes <= 2 * HISTORY_BLOCK_SIZE + 60);
+  TEST_ASSERT_TRUE(stats.records * HISTORY_RAW_SIZE > 2 * stats.bytes);
+}
+
+static void test_oldest_block_dropped(void)
+{
+  uint8_t buf[3 * HISTORY_BLOCK_SIZE + 10];
+  HISTORY history(buf, sizeof(buf));
+  ST_HISTORY_CURSOR cursor;
+  ST_HISTORY_RECORD record;
+  uint32_t i;
+
+  memset(buf, 0xA5, sizeof(buf));
+  for (i = 0; i < 1000; i++)
+    history.append(reading(i));
+
+  const ST_HISTORY_STATS &stats = history.get_stats();
+
+  // The newest records, in 2 to 3 blocks
+  TEST_ASSERT_EQUAL_UINT32(1000, stats.records);
+  TEST_ASSERT_EQUAL_UINT32(1000 - history.get_count(), stats.dropped);
+  TEST_ASSERT_TRUE(history.get_count() > 2 * HISTORY_BLOCK_SIZE / HISTORY_RECORD_MAX);
+
+  history.begin(cursor);
+  for (i = stats.dropped; history.next(cursor, record); i++)
+    assert_record(reading(i), record);
+  TEST_ASSERT_EQUAL_UINT32(1000, i);
+  // Nothing past the last whole block was written
+  for (i = 3 * HISTORY_BLOCK_SIZE; i < sizeof(buf); i++)
+    TEST_ASSERT_EQUAL_HEX8(0xA5, buf[i]);
+}
+
+static void test_cursor_follows(void)
+{
+  uint8_t buf[2 * HISTORY_BLOCK_SIZE];
+  HISTORY history(buf, sizeof(buf));
+  ST_HISTORY_CURSOR cursor;
+  ST_HISTORY_RECORD record;
+  uint32_t read = 0;
+
+  history.begin(cursor);
+  TEST_ASSERT_FALSE(history.next(cursor, record));
+
+  // Read while appended, across blocks
+  for (uint32_t i = 0; i < 100; i++)
+  {
+    history.append(reading(i));
+    if (i % 3 == 0)
+    {
+      while (history.next(cursor, record))
+        assert_record(reading(read++), record);
+    }
+  }
+  while (history.next(cursor, record))
+    assert_record(reading(read++), record);
+  TEST_ASSERT_EQUAL_UINT32(100, read);
+  TEST_ASSERT_EQUAL_UINT32(0, cursor.lost);
+
+  // Fallen behind, the dropped records are lost
+  const uint32_t dropped = history.get_stats().dropped;
+
+  history.begin(cursor);
+  TEST_ASSERT_TRUE(history.next(cursor, record));
+  for (uint32_t i = 100; i < 200; i++)
+    history.append(reading(i));
+  TEST_ASSERT_TRUE(history.next(cursor, record));
+  assert_record(reading(history.get_stats().dropped), record);
+  TEST_ASSERT_EQUAL_UINT32(history.get_stats().dropped - dropped - 1, cursor.lost);
+}
+
+static void test_clear(void)
+{
+  uint8_t buf[2 * HISTORY_BLOCK_SIZE];
+  HISTORY history(buf, sizeof(buf));
+  ST_HISTORY_CURSOR cursor;
+  ST_HISTORY_RECORD record;
+
+  for (uint32_t i = 0; i < 10; i++)
+    history.append(reading(i));
+  history.begin(cursor);
+  history.next(cursor, record);
+  history.clear();
+  TEST_ASSERT_EQUAL_UINT16(0, history.get_count());
+  TEST_ASSERT_FALSE(history.next(cursor, record));
+  TEST_ASSERT_EQUAL_UINT32(9, cursor.lost);
+
+  history.append(reading(10));
+  TEST_ASSERT_TRUE(history.next(cursor, record));
+  assert_record(reading(10), record);
+}
+
+static void test_blocks(void)
+{
+  uint8_t buf[3 * HISTORY_BLOCK_SIZE];
+  HISTORY history(buf, sizeof(buf));
+  ST_HISTORY_CURSOR cursor;
+  ST_HISTORY_RECORD records[HISTORY_BLOCK_RECORDS_MAX];
+  uint8_t block[HISTORY_BLOCK_SIZE];
+  uint32_t i, bytes = 0;
+  uint8_t len;
+  int16_t n;
+
+  for (i = 0; i < 100; i++)
+    history.append(reading(i));
+
+  // Whole blocks, the newest one as far as it is written
+  history.begin(cursor);
+  i = history.get_stats().dropped;
+  while ((len = history.next_block(cursor, block)) > 0)
+  {
+    n = history_decode_block(block, len, records, HISTORY_BLOCK_RECORDS_MAX);
+    TEST_ASSERT_TRUE(n > 0);
+    for (int16_t j = 0; j < n; j++)
+      assert_record(reading(i++), records[j]);
+    bytes += len;
+  }
+  TEST_ASSERT_EQUAL_UINT32(100, i);
+  TEST_ASSERT_EQUAL_UINT32(0, cursor.lost);
+  TEST_ASSERT_TRUE(bytes <= 3 * HISTORY_BLOCK_SIZE);
+  TEST_ASSERT_TRUE(bytes * 2 < history.get_count() * HISTORY_RAW_SIZE);
+
+  // Malformed copies
+  history.begin(cursor);
+  len = history.next_block(cursor, block);
+  TEST_ASSERT_EQUAL_INT16(-1, history_decode_block(block, len - 1, records, HISTORY_BLOCK_RECORDS_MAX));
+  TEST_ASSERT_EQUAL_INT16(-1, history_decode_block(block, len, records, block[0] - 1));
+
+  // Fallen behind while dumping, the dropped records are lost
+  for (i = 100; i < 200; i++)
+    history.append(reading(i));
+  len = history.next_block(cursor, block);
+  n = history_decode_block(block, len, records, HISTORY_BLOCK_RECORDS_MAX);
+  TEST_ASSERT_TRUE(n > 0);
+  assert_record(reading(history.get_stats().dropped), records[0]);
+  TEST_ASSERT_TRUE(cursor.lost > 0);
+}
+
+static int run_tests(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_varint);
+  RUN_TEST(test_round_trip);
+  RUN_TEST(test_compression);
+  RUN_TEST(test_oldest_block_dropped);
+  RUN_TEST(test_cursor_follows);
+  RUN_TEST(test_clear);
+  RUN_TEST(test_blocks);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup(void)
+{
+  delay(2000);
+  run_tests();
+}
+
+void loop(void)
+{
+}
+#else
+int main(void)
+{
+  return run_tests();
+}
+#endif
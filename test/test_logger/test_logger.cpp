@@ -0,0 +1,187 @@
+/*******************************************************************************
+ * @file    test_logger.cpp
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Unit tests of the LOGGER class. The serial port is injected, so the
+ *          tests run both natively and on target.
+*******************************************************************************/
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <string.h>
+#include <unity.h>
+#include <Logger.h>
+
+static uint8_t sent[256] = {0};
+static uint16_t sent_len = 0;
+static int tx_room = 0;
+
+static size_t fake_write(const uint8_t *data, size_t len)
+{
+  TEST_ASSERT_TRUE((int) len <= tx_room);
+  memcpy(&sent[sent_len], data, len);
+  sent_len += len;
+  tx_room -= len;
+
+  return len;
+}
+
+static int fake_writable(void)
+{
+  return tx_room;
+}
+
+void setUp(void)
+{
+  memset(sent, 0, sizeof(sent));
+  sent_len = 0;
+  tx_room = 0;
+}
+
+void tearDown(void)
+{
+}
+
+static void test_never_blocks(void)
+{
+  uint8_t buf[32];
+  LOGGER logger(buf, sizeof(buf), LOGGER_DROP_MESSAGE, '\n', fake_write, fake_writable);
+
+  // Nothing is written while the port has no room
+  logger.print("12 |  ");
+  logger.println(3.5);
+  TEST_ASSERT_EQUAL_UINT16(0, logger.pump());
+  TEST_ASSERT_EQUAL_UINT16(0, sent_len);
+  TEST_ASSERT_EQUAL_UINT16(12, logger.get_pending());
+
+  // Only as much as the port takes
+  tx_room = 5;
+  TEST_ASSERT_EQUAL_UINT16(5, logger.pump());
+  tx_room = 64;
+  TEST_ASSERT_EQUAL_UINT16(7, logger.pump());
+  TEST_ASSERT_EQUAL_STRING("12 |  3.50\r\n", (const char *) sent);
+  TEST_ASSERT_EQUAL_UINT16(0, logger.get_pending());
+}
+
+static void test_incomplete_message_held(void)
+{
+  uint8_t buf[32];
+  LOGGER logger(buf, sizeof(buf), LOGGER_DROP_MESSAGE, '\n', fake_write, fake_writable);
+
+  tx_room = 64;
+  logger.print("Sensor value = ");
+  TEST_ASSERT_EQUAL_UINT16(0, logger.pump());
+  logger.println(512);
+  TEST_ASSERT_EQUAL_UINT16(20, logger.pump());
+  TEST_ASSERT_EQUAL_STRING("Sensor value = 512\r\n", (const char *) sent);
+}
+
+static void test_wrap_around(void)
+{
+  uint8_t buf[16];
+  LOGGER logger(buf, sizeof(buf), LOGGER_DROP_MESSAGE, '\n', fake_write, fake_writable);
+  char expected[256] = "";
+
+  for (uint8_t i = 0; i < 20; i++)
+  {
+    logger.print("line ");
+    logger.println(i);
+    strcat(expected, "line ");
+    sprintf(&expected[strlen(expected)], "%u\r\n", i);
+    tx_room = 3;
+    logger.pump();
+    tx_room = 64;
+    logger.pump();
+  }
+  TEST_ASSERT_EQUAL_STRING(expected, (const char *) sent);
+  TEST_ASSERT_EQUAL_UINT32(0, logger.get_stats().dropped_bytes);
+}
+
+static void test_drop_message(void)
+{
+  uint8_t buf[16];
+  LOGGER logger(buf, sizeof(buf), LOGGER_DROP_MESSAGE, '\n', fake_write, fake_writable);
+
+  logger.println("first");
+  // Does not fit, dropped whole
+  logger.println("second message");
+  logger.println("third");
+
+  const ST_LOGGER_STATS &stats = logger.get_stats();
+
+  TEST_ASSERT_EQUAL_UINT16(1, stats.dropped_messages);
+  TEST_ASSERT_EQUAL_UINT32(16, stats.dropped_bytes);
+  TEST_ASSERT_EQUAL_UINT32(7 + 16 + 7, stats.bytes);
+  TEST_ASSERT_EQUAL_UINT16(16, stats.high_watermark);
+
+  tx_room = 64;
+  logger.pump();
+  TEST_ASSERT_EQUAL_STRING("first\r\nthird\r\n", (const char *) sent);
+
+  logger.reset_stats();
+  TEST_ASSERT_EQUAL_UINT16(0, logger.get_stats().dropped_messages);
+}
+
+static void test_drop_bytes(void)
+{
+  uint8_t buf[8];
+  LOGGER logger(buf, sizeof(buf), LOGGER_DROP_BYTES, '\n', fake_write, fake_writable);
+
+  // Sent without waiting for the delimiter, truncated when full
+  tx_room = 2;
+  logger.print("abcdefghijkl");
+  TEST_ASSERT_EQUAL_UINT16(2, logger.pump());
+  logger.print('\n');
+  tx_room = 64;
+  logger.pump();
+  logger.print("xy\n");
+  logger.pump();
+
+  TEST_ASSERT_EQUAL_STRING("abcdefgh\nxy\n", (const char *) sent);
+  TEST_ASSERT_EQUAL_UINT16(1, logger.get_stats().dropped_messages);
+  TEST_ASSERT_EQUAL_UINT32(4, logger.get_stats().dropped_bytes);
+}
+
+static void test_binary_frames(void)
+{
+  uint8_t buf[8];
+  LOGGER logger(buf, sizeof(buf), LOGGER_DROP_MESSAGE, 0x00, fake_write, fake_writable);
+  const uint8_t frame[] = { 0x03, 0x11, 0x22, 0x00 };
+
+  tx_room = 64;
+  logger.write(frame, 3);
+  TEST_ASSERT_EQUAL_UINT16(0, logger.pump());
+  logger.write(&frame[3], 1);
+  TEST_ASSERT_EQUAL_UINT16(4, logger.pump());
+  TEST_ASSERT_EQUAL_MEMORY(frame, sent, sizeof(frame));
+}
+
+static int run_tests(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_never_blocks);
+  RUN_TEST(test_incomplete_message_held);
+  RUN_TEST(test_wrap_around);
+  RUN_TEST(test_drop_message);
+  RUN_TEST(test_drop_bytes);
+  RUN_TEST(test_binary_frames);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup(void)
+{
+  delay(2000);
+  run_tests();
+}
+
+void loop(void)
+{
+}
+#else
+int main(void)
+{
+  return run_tests();
+}
+#endif
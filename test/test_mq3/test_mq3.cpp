@@ -0,0 +1,708 @@
+/*******************************************************************************
+ * @file    test_mq3.cpp
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Unit tests of the MQ3 class. The ADC and the clock are injected, so
+ *          the tests run both natively and on target.
+*******************************************************************************/
+
+#include <unity.h>
+#include <math.h>
+#include <Mq3.h>
+#include <Mq3Array.h>
+#include <Mq3Warmup.h>
+
+static uint16_t adc_value = 0;
+static uint32_t adc_reads = 0;
+static uint32_t clock_ms = 0;
+
+static uint16_t fake_adc_read(uint8_t pin)
+{
+  (void) pin;
+  adc_reads++;
+  return adc_value;
+}
+
+// 100 + 10 * channel, records the channel order
+static uint8_t adc_order[8] = {0};
+
+static uint16_t fake_pin_adc_read(uint8_t pin)
+{
+  if (adc_reads < sizeof(adc_order))
+    adc_order[adc_reads] = pin - A0;
+  adc_reads++;
+  return 100 + 10 * (pin - A0);
+}
+
+// adc_value with a burst of full scale samples from read 50 to 149
+static uint16_t spiky_adc_read(uint8_t pin)
+{
+  (void) pin;
+  return (adc_reads++ % MQ3_SAMPLES) - 50 < 100 ? 1023 : adc_value;
+}
+
+// adc_value + 1 for a quarter of the samples, 0.25 LSB above adc_value
+static uint16_t dithered_adc_read(uint8_t pin)
+{
+  (void) pin;
+  return adc_value + (adc_reads++ % 4 == 0);
+}
+
+static uint32_t fake_clock(void)
+{
+  return clock_ms;
+}
+
+void setUp(void)
+{
+  adc_value = 0;
+  adc_reads = 0;
+  clock_ms = 0;
+}
+
+void tearDown(void)
+{
+}
+
+static void test_measure_zero_fails(void)
+{
+  MQ3 mq3(A3, fake_adc_read, fake_clock);
+
+  TEST_ASSERT_FALSE(mq3.measure());
+}
+
+static void test_measure_values(void)
+{
+  MQ3 mq3(A3, fake_adc_read, fake_clock);
+  uint32_t val;
+  double volts, rs;
+
+  adc_value = 512;
+  clock_ms = 1234;
+
+  TEST_ASSERT_TRUE(mq3.measure(val, volts, rs));
+  TEST_ASSERT_EQUAL_UINT32(MQ3_SAMPLES, adc_reads);
+  TEST_ASSERT_EQUAL_UINT32(512, val);
+  TEST_ASSERT_DOUBLE_WITHIN(1e-9, 2.5, volts);
+  TEST_ASSERT_DOUBLE_WITHIN(1e-6, MQ3::R, rs);
+  TEST_ASSERT_EQUAL_UINT32(1234, mq3.get_timestamp());
+}
+
+static void test_calibration(void)
+{
+  MQ3 mq3(A3, fake_adc_read, fake_clock);
+  uint32_t val;
+  double volts, r0, precision;
+
+  // Rs = 4700 * (1024 / 100 - 1) -> R0 = Rs / 60 = 724.13
+  adc_value = 100;
+
+  for (uint8_t i = 0; i < 10; i++)
+    TEST_ASSERT_TRUE(mq3.calibrate(val, volts, r0));
+
+  TEST_ASSERT_DOUBLE_WITHIN(1e-6, MQ3::R * (1024.0 / 100 - 1) / 60.0, r0);
+  TEST_ASSERT_TRUE(mq3.check_calibration(1.0, precision));
+  TEST_ASSERT_DOUBLE_WITHIN(1e-9, 0.0, precision);
+  TEST_ASSERT_DOUBLE_WITHIN(1e-6, r0, mq3.R0);
+  TEST_ASSERT_TRUE(mq3.is_valid());
+}
+
+static void test_calibration_out_of_range(void)
+{
+  MQ3 mq3(A3, fake_adc_read, fake_clock);
+  double precision;
+
+  // R0 ~ 15.6 is outside of [300 ... 4000]
+  adc_value = 1000;
+  TEST_ASSERT_TRUE(mq3.calibrate());
+  TEST_ASSERT_FALSE(mq3.check_calibration(1.0, precision));
+  TEST_ASSERT_FALSE(mq3.is_valid());
+}
+
+static void test_calibration_imprecise(void)
+{
+  MQ3 mq3(A3, fake_adc_read, fake_clock);
+  double precision;
+
+  adc_value = 100;
+  TEST_ASSERT_TRUE(mq3.calibrate());
+  adc_value = 150;
+  TEST_ASSERT_TRUE(mq3.calibrate());
+  TEST_ASSERT_FALSE(mq3.check_calibration(1.0, precision));
+  TEST_ASSERT_TRUE(precision > 1.0);
+
+  mq3.clear_calibration();
+  TEST_ASSERT_FALSE(mq3.check_calibration(1.0));
+}
+
+static void test_calibration_statistics(void)
+{
+  MQ3 mq3(A3, fake_adc_read, fake_clock);
+  const uint16_t steps = 5000;
+  double sum = .0, sum2 = .0, r0, precision;
+  uint32_t val;
+  double volts;
+
+  // Reference two-pass statistics over a ramp of ADC values
+  for (uint16_t i = 0; i < steps; i++)
+  {
+    adc_value = 95 + i % 11;
+    TEST_ASSERT_TRUE(mq3.calibrate(val, volts, r0));
+    sum += r0;
+  }
+  const double mean = sum / steps;
+  for (uint16_t i = 0; i < steps; i++)
+  {
+    const double rs = (5.0 * MQ3::R) / ((95 + i % 11) / 1024.0 * 5.0) - MQ3::R;
+
+    sum2 += (rs / 60.0 - mean) * (rs / 60.0 - mean);
+  }
+  const double expected = 3 * sqrt(sum2 / steps) / mean * 100;
+
+  TEST_ASSERT_FALSE(mq3.check_calibration(1.0, precision));
+  TEST_ASSERT_DOUBLE_WITHIN(1e-6, expected, precision);
+  TEST_ASSERT_TRUE(mq3.check_calibration(100.0, precision));
+  TEST_ASSERT_DOUBLE_WITHIN(1e-6, mean, mq3.R0);
+}
+
+static void test_calibration_sequential(void)
+{
+  MQ3 mq3(A3, fake_adc_read, fake_clock);
+  uint8_t steps;
+
+  // Noiseless sensor, passes as soon as allowed
+  adc_value = 100;
+  for (steps = 1; steps <= 200; steps++)
+  {
+    TEST_ASSERT_TRUE(mq3.calibrate());
+    if (mq3.check_calibration_sequential(1.0) != MQ3_CALIB_RUNNING)
+      break;
+  }
+  TEST_ASSERT_EQUAL_UINT8(MQ3_CALIB_MIN_STEPS, steps);
+  TEST_ASSERT_EQUAL_INT(MQ3_CALIB_PASSED, mq3.check_calibration_sequential(1.0));
+  TEST_ASSERT_TRUE(mq3.check_calibration(1.0));
+
+  // Noisy sensor, fails early
+  mq3.clear_calibration();
+  for (steps = 1; steps <= 200; steps++)
+  {
+    adc_value = steps % 2 ? 100 : 110;
+    TEST_ASSERT_TRUE(mq3.calibrate());
+    if (mq3.check_calibration_sequential(1.0) != MQ3_CALIB_RUNNING)
+      break;
+  }
+  TEST_ASSERT_TRUE(steps < 20);
+  TEST_ASSERT_EQUAL_INT(MQ3_CALIB_FAILED, mq3.check_calibration_sequential(1.0));
+  TEST_ASSERT_FALSE(mq3.check_calibration(1.0));
+
+  // R0 ~ 15.6 out of range
+  mq3.clear_calibration();
+  adc_value = 1000;
+  for (steps = 1; steps <= MQ3_CALIB_MIN_STEPS; steps++)
+    TEST_ASSERT_TRUE(mq3.calibrate());
+  TEST_ASSERT_EQUAL_INT(MQ3_CALIB_FAILED, mq3.check_calibration_sequential(1.0));
+}
+
+static void test_calibration_sequential_agrees(void)
+{
+  MQ3 mq3(A3, fake_adc_read, fake_clock);
+  uint32_t seed = 7;
+
+  // ADC averages of 100 and sometimes 101, 3 sd of R0 around the 1% limit
+  for (uint8_t run = 0; run < 20; run++)
+  {
+    const uint8_t percent = 4 + 3 * (run % 5);
+    E_MQ3_CALIB result = MQ3_CALIB_RUNNING;
+    uint16_t steps;
+
+    mq3.clear_calibration();
+    for (steps = 1; steps <= 200 && result == MQ3_CALIB_RUNNING; steps++)
+    {
+      seed = seed * 1103515245UL + 12345UL;
+      adc_value = 100 + ((seed >> 16) % 100 < percent);
+      TEST_ASSERT_TRUE(mq3.calibrate());
+      result = mq3.check_calibration_sequential(1.0);
+    }
+    // An early decision matches the final check on the same data
+    if (result == MQ3_CALIB_PASSED)
+      TEST_ASSERT_TRUE(mq3.check_calibration(1.0));
+    else if (result == MQ3_CALIB_FAILED)
+      TEST_ASSERT_FALSE(mq3.check_calibration(1.0));
+  }
+}
+
+static void test_mgL_error_bound(void)
+{
+  double max_error = .0;
+
+  // Rs/R0 over the table range [0.25 ... 1024) in 0.1% steps
+  for (double ratio = 0.25; ratio < 1024.0; ratio *= 1.001)
+  {
+    const double expected = pow(0.4 * ratio, -1.431);
+    const double mgL = MQ3::mgL_q16((uint32_t) (ratio * (1UL << MQ3_RATIO_Q))) / (double) MQ3_MGL_ONE;
+    const double error = fabs(mgL - expected) - 2.0 / MQ3_MGL_ONE;
+
+    if (error / expected > max_error)
+      max_error = error / expected;
+  }
+  TEST_ASSERT_TRUE(max_error < 0.002);
+
+  TEST_ASSERT_EQUAL_UINT32(MQ3::mgL_q16(1UL << (MQ3_RATIO_Q - 2)), MQ3::mgL_q16(0));
+  TEST_ASSERT_EQUAL_UINT32(0, MQ3::mgL_q16(1024UL << MQ3_RATIO_Q));
+}
+
+static void test_get_mgL(void)
+{
+  MQ3 mq3(A3, fake_adc_read, fake_clock);
+  uint32_t val;
+  double volts, rs;
+
+  mq3.R0 = 700.0;
+  for (adc_value = 20; adc_value < 1024; adc_value += 7)
+  {
+    TEST_ASSERT_TRUE(mq3.measure(val, volts, rs));
+
+    // Saturated below the table range
+    if (rs / mq3.R0 < 0.25)
+      break;
+
+    const double expected = pow(0.4 * rs / mq3.R0, -1.431);
+
+    TEST_ASSERT_DOUBLE_WITHIN(expected * 0.004 + 3.0 / MQ3_MGL_ONE, expected, mq3.get_mgL_q16() / (double) MQ3_MGL_ONE);
+  }
+}
+
+static void test_array(void)
+{
+  MQ3 mq3_0(A0, fake_pin_adc_read, fake_clock);
+  MQ3 mq3_1(A1, fake_pin_adc_read, fake_clock);
+  MQ3 mq3_2(A2, fake_pin_adc_read, fake_clock);
+  MQ3 mq3_3(A3, fake_pin_adc_read, fake_clock);
+  MQ3 *sensors[] = { &mq3_0, &mq3_1, &mq3_2, &mq3_3 };
+  MQ3Array array(sensors, 4);
+
+  // The samples of a scan are shared
+  TEST_ASSERT_EQUAL_UINT16(MQ3_SAMPLES / 4, array.get_samples_per_sensor());
+  TEST_ASSERT_EQUAL_UINT8(0x0F, array.measure());
+  TEST_ASSERT_EQUAL_UINT32(MQ3_SAMPLES, adc_reads);
+  // Round robin
+  for (uint8_t i = 0; i < 8; i++)
+    TEST_ASSERT_EQUAL_UINT8(i % 4, adc_order[i]);
+
+  // Per sensor calibration state
+  adc_reads = 0;
+  for (uint8_t i = 0; i < 10; i++)
+    TEST_ASSERT_EQUAL_UINT8(0x0F, array.calibrate());
+  TEST_ASSERT_EQUAL_UINT8(0x0F, array.check_calibration(1.0));
+  for (uint8_t i = 0; i < 4; i++)
+    TEST_ASSERT_DOUBLE_WITHIN(1e-6, MQ3::R * (1024.0 / (100 + 10 * i) - 1) / 60.0, array.get(i).R0);
+
+  array.clear_calibration();
+  TEST_ASSERT_EQUAL_UINT8(0, array.check_calibration(1.0));
+}
+
+// Rs of a heating sensor: 1.5x the final value decaying with a time
+// constant of tau_h hours, with an optional uniform noise
+static double warmup_rs(uint32_t t_s, double tau_h, double noise, uint32_t &seed)
+{
+  seed = seed * 1103515245UL + 12345UL;
+
+  const double u = ((seed >> 16) & 0x7FFF) / 16383.5 - 1.0;
+
+  return 20000.0 * (1 + 0.5 * exp(-(t_s / 3600.0) / tau_h)) * (1 + noise * u);
+}
+
+static void test_warmup_drift(void)
+{
+  MQ3Warmup warmup(10, 0.02);
+  uint32_t seed = 1, t_s, eta = 0;
+
+  // With a 2h time constant Rs gets within 2% of the settled one after
+  // ~6.5h, the baseline lags by ~1h
+  for (t_s = 10; t_s <= 24 * 3600UL && !warmup.add(warmup_rs(t_s, 2, .0, seed)); t_s += 10)
+    if (t_s == 3 * 3600UL)
+      eta = warmup.get_time_to_ready();
+
+  TEST_ASSERT_TRUE(warmup.is_ready());
+  TEST_ASSERT_TRUE(t_s > 6.5 * 3600 && t_s < 8 * 3600);
+  TEST_ASSERT_TRUE(fabs(warmup.get_drift()) < 0.02);
+  TEST_ASSERT_TRUE(warmup.get_remaining() < MQ3_WARMUP_SETTLED);
+  TEST_ASSERT_EQUAL_UINT32(0, warmup.get_time_to_ready());
+  // Time to ready estimated 4h before
+  TEST_ASSERT_TRUE(eta != MQ3_WARMUP_UNKNOWN);
+  TEST_ASSERT_UINT32_WITHIN((t_s - 3 * 3600UL) / 4, t_s - 3 * 3600UL, eta);
+
+  // Noise delays it within reason
+  warmup.reset();
+  TEST_ASSERT_FALSE(warmup.is_ready());
+  for (t_s = 10; t_s <= 24 * 3600UL && !warmup.add(warmup_rs(t_s, 2, 0.002, seed)); t_s += 10)
+    ;
+  TEST_ASSERT_TRUE(t_s > 6.5 * 3600 && t_s < 10 * 3600);
+  TEST_ASSERT_TRUE(warmup.get_noise() > 0.0005 && warmup.get_noise() < 0.002);
+}
+
+static void test_warmup_slow(void)
+{
+  const double taus_h[] = { 4, 8, 12, 24 };
+  uint32_t seed = 1, t_s;
+
+  // A drift below 2%/h is not settled yet when it decays slowly, ready only
+  // once Rs is within MQ3_WARMUP_SETTLED of the settled one
+  for (uint8_t i = 0; i < sizeof(taus_h) / sizeof(taus_h[0]); i++)
+  {
+    MQ3Warmup warmup(10, 0.02);
+
+    for (t_s = 10; t_s <= 48 * 3600UL && !warmup.add(warmup_rs(t_s, taus_h[i], 0.002, seed)); t_s += 10)
+      ;
+    if (taus_h[i] < 24)
+      TEST_ASSERT_TRUE(warmup.is_ready());
+    else
+      TEST_ASSERT_FALSE(warmup.is_ready());
+    if (warmup.is_ready())
+      TEST_ASSERT_DOUBLE_WITHIN(20000.0 * MQ3_WARMUP_SETTLED, 20000.0, warmup_rs(t_s, taus_h[i], .0, seed));
+  }
+}
+
+static void test_warmup_min_time(void)
+{
+  MQ3Warmup warmup(10, 0.02, 7200);
+  const uint32_t block_s = MQ3_WARMUP_BLOCK * 10;
+  uint32_t t_s;
+
+  // Stable from the start, judged after 3 blocks, ready at the end of the
+  // block after the minimum time
+  for (t_s = 10; !warmup.add(20000.0); t_s += 10)
+  {
+    TEST_ASSERT_TRUE(t_s < 7200 + block_s);
+    if (t_s >= 3 * block_s)
+      TEST_ASSERT_EQUAL_UINT32((7200 + block_s - 1) / block_s * block_s - t_s, warmup.get_time_to_ready());
+    else
+      TEST_ASSERT_EQUAL_UINT32(MQ3_WARMUP_UNKNOWN, warmup.get_time_to_ready());
+  }
+  TEST_ASSERT_EQUAL_UINT32((7200 + block_s - 1) / block_s * block_s, t_s);
+  TEST_ASSERT_EQUAL_UINT32(t_s, warmup.get_elapsed());
+
+  // Invalid values are ignored
+  warmup.reset();
+  TEST_ASSERT_FALSE(warmup.add(-1.0));
+  TEST_ASSERT_EQUAL_UINT32(0, warmup.get_elapsed());
+  TEST_ASSERT_EQUAL_UINT32(MQ3_WARMUP_UNKNOWN, warmup.get_time_to_ready());
+}
+
+static void test_warmup_resume(void)
+{
+  MQ3Warmup warmup(10, 0.02, 3600);
+  uint32_t t_s;
+
+  // Interrupted after 3000s, Rs is checked again, the time so far counts
+  // towards the minimum
+  warmup.resume(3000);
+  TEST_ASSERT_EQUAL_UINT32(3000, warmup.get_elapsed());
+  for (t_s = 10; !warmup.add(20000.0); t_s += 10)
+    TEST_ASSERT_TRUE(t_s < 3 * MQ3_WARMUP_BLOCK * 10);
+  TEST_ASSERT_EQUAL_UINT32(3 * MQ3_WARMUP_BLOCK * 10, t_s);
+
+  // Interrupted once ready
+  warmup.reset();
+  warmup.resume(3600, true);
+  TEST_ASSERT_TRUE(warmup.is_ready());
+  TEST_ASSERT_EQUAL_UINT32(0, warmup.get_time_to_ready());
+}
+
+static void test_warmup_timeout(void)
+{
+  MQ3Warmup warmup(10, 0.02, 0, 24 * 3600UL);
+  uint32_t seed = 1, t_s;
+
+  // Too slow to settle, done once out of time
+  for (t_s = 10; t_s <= 48 * 3600UL; t_s += 10)
+  {
+    warmup.add(warmup_rs(t_s, 24, .0, seed));
+    if (warmup.is_done())
+      break;
+  }
+  TEST_ASSERT_EQUAL_UINT32(24 * 3600UL, t_s);
+  TEST_ASSERT_FALSE(warmup.is_ready());
+
+  // Interrupted after 20h, the time so far counts towards the bound
+  warmup.reset();
+  warmup.resume(20 * 3600UL);
+  TEST_ASSERT_FALSE(warmup.is_done());
+  for (t_s = 20 * 3600UL + 10; !warmup.is_done(); t_s += 10)
+    warmup.add(warmup_rs(t_s, 24, .0, seed));
+  TEST_ASSERT_EQUAL_UINT32(24 * 3600UL + 10, t_s);
+  TEST_ASSERT_FALSE(warmup.is_ready());
+
+  // Interrupted once out of time
+  warmup.reset();
+  warmup.resume(24 * 3600UL);
+  TEST_ASSERT_TRUE(warmup.is_done());
+  TEST_ASSERT_FALSE(warmup.is_ready());
+
+  // Unbounded
+  MQ3Warmup unbounded(10, 0.02);
+
+  unbounded.resume(48 * 3600UL);
+  TEST_ASSERT_FALSE(unbounded.is_done());
+}
+
+static void test_filter_config(void)
+{
+  MQ3Filter filter;
+  const ST_MQ3_FILTER even = { 1000, 4, 0, 0 };
+  const ST_MQ3_FILTER too_few = { 2, 3, 0, 0 };
+  const ST_MQ3_FILTER slow = { 1000, 1, MQ3_FILTER_EMA_SHIFT_MAX + 1, 0 };
+  const ST_MQ3_FILTER median = { 1000, 7, 2, 0 };
+  const ST_MQ3_FILTER coarse = { 7 * 25, 7, 0, 3 };
+  const ST_MQ3_FILTER fine = { 7 * 64, 7, 0, 3 };
+
+  // The plain average of MQ3_SAMPLES by default
+  TEST_ASSERT_EQUAL_UINT16(MQ3_SAMPLES, filter.get_block_samples());
+  TEST_ASSERT_FALSE(filter.set_config(even));
+  TEST_ASSERT_FALSE(filter.set_config(too_few));
+  TEST_ASSERT_FALSE(filter.set_config(slow));
+  TEST_ASSERT_EQUAL_UINT8(1, filter.get_config().median);
+
+  // 7 sub-blocks of 142 samples
+  TEST_ASSERT_TRUE(filter.set_config(median));
+  TEST_ASSERT_EQUAL_UINT16(994, filter.get_block_samples());
+  TEST_ASSERT_EQUAL_UINT32(512 * MQ3_FILTER_ONE + MQ3_FILTER_ONE / 4, MQ3Filter::average_q16(2049, 4));
+
+  // 4^n samples a sub-block for n extra bits, not a block
+  TEST_ASSERT_FALSE(filter.set_config(coarse));
+  TEST_ASSERT_TRUE(filter.set_config(fine));
+  TEST_ASSERT_EQUAL_UINT16(448, filter.get_block_samples());
+}
+
+static void test_filter_median(void)
+{
+  MQ3 plain(A3, spiky_adc_read, fake_clock);
+  MQ3 median(A3, spiky_adc_read, fake_clock);
+  const ST_MQ3_FILTER filter = { MQ3_SAMPLES, 5, 0, 0 };
+  uint32_t val;
+  double volts, rs;
+
+  adc_value = 300;
+  TEST_ASSERT_TRUE(plain.measure(val, volts, rs));
+  TEST_ASSERT_EQUAL_UINT32(300 + (1023 - 300) / 10, val);
+
+  // The burst spans 2 of the 5 sub-blocks
+  TEST_ASSERT_TRUE(median.set_filter(filter));
+  adc_reads = 0;
+  TEST_ASSERT_TRUE(median.measure(val, volts, rs));
+  TEST_ASSERT_EQUAL_UINT32(300, val);
+  TEST_ASSERT_EQUAL_UINT32(MQ3_SAMPLES, adc_reads);
+}
+
+static void test_filter_ema(void)
+{
+  MQ3 mq3(A3, fake_adc_read, fake_clock);
+  const ST_MQ3_FILTER filter = { 100, 1, 2, 0 };
+  uint32_t val;
+  double volts, rs;
+
+  TEST_ASSERT_TRUE(mq3.set_filter(filter));
+
+  // Starts at the first measurement, then a quarter of every step
+  adc_value = 400;
+  TEST_ASSERT_TRUE(mq3.measure(val, volts, rs));
+  TEST_ASSERT_EQUAL_UINT32(400, val);
+  TEST_ASSERT_EQUAL_UINT32(100, adc_reads);
+  adc_value = 800;
+  TEST_ASSERT_TRUE(mq3.measure(val, volts, rs));
+  TEST_ASSERT_EQUAL_UINT32(500, val);
+  TEST_ASSERT_TRUE(mq3.measure(val, volts, rs));
+  TEST_ASSERT_EQUAL_UINT32(575, val);
+  for (uint8_t i = 0; i < 60; i++)
+    mq3.measure(val, volts, rs);
+  TEST_ASSERT_EQUAL_UINT32(800, val);
+
+  // A new filter starts over
+  TEST_ASSERT_TRUE(mq3.set_filter(filter));
+  adc_value = 200;
+  TEST_ASSERT_TRUE(mq3.measure(val, volts, rs));
+  TEST_ASSERT_EQUAL_UINT32(200, val);
+}
+
+static void test_resolution(void)
+{
+  MQ3 mq3(A3, dithered_adc_read, fake_clock);
+  MQ3 plain(A3, fake_adc_read, fake_clock);
+  const ST_MQ3_FILTER twelve = { MQ3_SAMPLES, 1, 0, 2 };
+  const ST_MQ3_FILTER fourteen = { 256, 1, 0, 4 };
+  const ST_MQ3_FILTER too_few = { 255, 1, 0, 4 };
+  const ST_MQ3_FILTER too_many = { MQ3_SAMPLES, 1, 0, MQ3_FILTER_EXTRA_BITS_MAX + 1 };
+  uint32_t val;
+  double volts, rs;
+
+  TEST_ASSERT_FALSE(mq3.set_filter(too_few));
+  TEST_ASSERT_FALSE(mq3.set_filter(too_many));
+
+  // 10 bits by default, the quarter LSB is lost
+  adc_value = 512;
+  TEST_ASSERT_TRUE(mq3.measure(val, volts, rs));
+  TEST_ASSERT_EQUAL_UINT8(10, mq3.get_bits());
+  TEST_ASSERT_EQUAL_UINT16(512, mq3.get_value());
+
+  TEST_ASSERT_TRUE(mq3.set_filter(twelve));
+  TEST_ASSERT_TRUE(mq3.measure(val, volts, rs));
+  TEST_ASSERT_EQUAL_UINT8(12, mq3.get_bits());
+  TEST_ASSERT_EQUAL_UINT16(4 * 512 + 1, mq3.get_value());
+  TEST_ASSERT_EQUAL_UINT32(512, val);
+  TEST_ASSERT_DOUBLE_WITHIN(1e-9, 2049 * 5.0 / 4096, volts);
+  TEST_ASSERT_DOUBLE_WITHIN(1e-6, 4700.0 * (4096 - 2049) / 2049, rs);
+
+  // 4^4 samples shifted right by 4
+  TEST_ASSERT_TRUE(mq3.set_filter(fourteen));
+  adc_reads = 0;
+  TEST_ASSERT_TRUE(mq3.measure(val, volts, rs));
+  TEST_ASSERT_EQUAL_UINT32(256, adc_reads);
+  TEST_ASSERT_EQUAL_UINT16(16 * 512 + 4, mq3.get_value());
+
+  // The quarter LSB is a smaller Rs, more alcohol
+  adc_value = 300;
+  mq3.R0 = plain.R0 = 1500.0;
+  TEST_ASSERT_TRUE(plain.measure());
+  TEST_ASSERT_TRUE(mq3.measure());
+  TEST_ASSERT_TRUE(mq3.get_mgL_q16() > plain.get_mgL_q16());
+
+  // The same mg/L at any resolution without it
+  MQ3 exact(A3, fake_adc_read, fake_clock);
+
+  exact.R0 = 1500.0;
+  TEST_ASSERT_TRUE(exact.set_filter(fourteen));
+  TEST_ASSERT_TRUE(exact.measure());
+  TEST_ASSERT_EQUAL_UINT16(16 * 300, exact.get_value());
+  TEST_ASSERT_UINT32_WITHIN(2, plain.get_mgL_q16(), exact.get_mgL_q16());
+}
+
+#ifndef ARDUINO
+static void test_free_running_sampling(void)
+{
+  MQ3 mq3(A3, fake_adc_read, fake_clock);
+  uint32_t val;
+  double volts, rs;
+
+  hal_sim_reset();
+  hal_sim_set_adc_value(A3, 512);
+
+  TEST_ASSERT_TRUE(mq3.start_sampling());
+  TEST_ASSERT_TRUE(mq3.is_sampling());
+  TEST_ASSERT_FALSE(mq3.measure());
+
+  // one block of samples
+  hal_sim_advance_us((uint64_t) MQ3_SAMPLES * HAL_ADC_FREE_RUNNING_US);
+  TEST_ASSERT_TRUE(mq3.measure(val, volts, rs));
+  TEST_ASSERT_EQUAL_UINT32(512, val);
+  TEST_ASSERT_EQUAL_UINT32(0, adc_reads);
+  // no new block
+  TEST_ASSERT_FALSE(mq3.measure());
+
+  // the newest block is used
+  hal_sim_advance_us((uint64_t) MQ3_SAMPLES * HAL_ADC_FREE_RUNNING_US);
+  hal_sim_set_adc_value(A3, 256);
+  hal_sim_advance_us((uint64_t) MQ3_SAMPLES * HAL_ADC_FREE_RUNNING_US);
+  TEST_ASSERT_TRUE(mq3.measure(val, volts, rs));
+  TEST_ASSERT_EQUAL_UINT32(256, val);
+
+  // the ring buffer overflows
+  hal_sim_advance_us((uint64_t) (MQ3_SAMPLING_BLOCKS + 1) * MQ3_SAMPLES * HAL_ADC_FREE_RUNNING_US);
+  TEST_ASSERT_EQUAL_UINT16(1, mq3.get_overruns());
+
+  // blocking fallback
+  mq3.stop_sampling();
+  adc_value = 100;
+  TEST_ASSERT_TRUE(mq3.measure(val, volts, rs));
+  TEST_ASSERT_EQUAL_UINT32(100, val);
+  TEST_ASSERT_EQUAL_UINT32(MQ3_SAMPLES, adc_reads);
+}
+
+static void test_free_running_filter(void)
+{
+  MQ3 mq3(A3, fake_adc_read, fake_clock);
+  const ST_MQ3_FILTER filter = { 300, 3, 0, 0 };
+  uint32_t val;
+  double volts, rs;
+
+  hal_sim_reset();
+  hal_sim_set_adc_value(A3, 512);
+  TEST_ASSERT_TRUE(mq3.start_sampling());
+  hal_sim_advance_us(100 * HAL_ADC_FREE_RUNNING_US);
+
+  // Restarts the sampling, the partial block is dropped
+  TEST_ASSERT_TRUE(mq3.set_filter(filter));
+  TEST_ASSERT_TRUE(mq3.is_sampling());
+  TEST_ASSERT_FALSE(mq3.measure());
+
+  // A spike of a whole sub-block
+  hal_sim_advance_us(100 * HAL_ADC_FREE_RUNNING_US);
+  hal_sim_set_adc_value(A3, 1000);
+  hal_sim_advance_us(100 * HAL_ADC_FREE_RUNNING_US);
+  hal_sim_set_adc_value(A3, 512);
+  hal_sim_advance_us(100 * HAL_ADC_FREE_RUNNING_US);
+  TEST_ASSERT_TRUE(mq3.measure(val, volts, rs));
+  TEST_ASSERT_EQUAL_UINT32(512, val);
+  TEST_ASSERT_EQUAL_UINT16(0, mq3.get_overruns());
+
+  // More blocks than the ring buffer holds, polled from the idle time
+  for (uint8_t i = 0; i < 4 * MQ3_SAMPLING_BLOCKS; i++)
+  {
+    if (i == 4 * MQ3_SAMPLING_BLOCKS - 1)
+      hal_sim_set_adc_value(A3, 700);
+    hal_sim_advance_us(300 * HAL_ADC_FREE_RUNNING_US);
+    if (i % 4 == 0)
+      mq3.poll();
+  }
+  TEST_ASSERT_TRUE(mq3.measure(val, volts, rs));
+  TEST_ASSERT_EQUAL_UINT32(700, val);
+  TEST_ASSERT_EQUAL_UINT16(0, mq3.get_overruns());
+  TEST_ASSERT_FALSE(mq3.measure());
+}
+#endif
+
+static int run_tests(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_measure_zero_fails);
+  RUN_TEST(test_measure_values);
+  RUN_TEST(test_calibration);
+  RUN_TEST(test_calibration_out_of_range);
+  RUN_TEST(test_calibration_imprecise);
+  RUN_TEST(test_calibration_statistics);
+  RUN_TEST(test_calibration_sequential);
+  RUN_TEST(test_calibration_sequential_agrees);
+  RUN_TEST(test_mgL_error_bound);
+  RUN_TEST(test_get_mgL);
+  RUN_TEST(test_array);
+  RUN_TEST(test_warmup_drift);
+  RUN_TEST(test_warmup_slow);
+  RUN_TEST(test_warmup_min_time);
+  RUN_TEST(test_warmup_resume);
+  RUN_TEST(test_warmup_timeout);
+  RUN_TEST(test_filter_config);
+  RUN_TEST(test_filter_median);
+  RUN_TEST(test_filter_ema);
+  RUN_TEST(test_resolution);
+#ifndef ARDUINO
+  RUN_TEST(test_free_running_sampling);
+  RUN_TEST(test_free_running_filter);
+#endif
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup(void)
+{
+  delay(2000);
+  run_tests();
+}
+
+void loop(void)
+{
+}
+#else
+int main(void)
+{
+  return run_tests();
+}
+#endif
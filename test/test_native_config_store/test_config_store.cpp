@@ -0,0 +1,248 @@
+/*******************************************************************************
+ * @file    test_config_store.cpp
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Unit tests of the CONFIG_STORE against the simulated EEPROM of
+ *          lib/Hal. Host only.
+*******************************************************************************/
+
+#include <string.h>
+#include <unity.h>
+#include <Hal.h>
+#include <ConfigStore.h>
+
+#define TYPE_CALIBRATION 0
+#define TYPE_CHECKPOINT 1
+#define VERSION 1
+
+static uint32_t read_value(CONFIG_STORE &store, uint8_t type, uint16_t age=0)
+{
+  ST_CONFIG_RECORD record;
+  uint32_t value;
+
+  TEST_ASSERT_TRUE(store.find(type, record, age));
+  TEST_ASSERT_EQUAL_UINT8(type, record.type);
+  TEST_ASSERT_EQUAL_UINT8(VERSION, record.version);
+  memcpy(&value, record.data, sizeof(value));
+
+  return value;
+}
+
+static void append_value(CONFIG_STORE &store, uint8_t type, uint32_t value)
+{
+  TEST_ASSERT_TRUE(store.append(type, VERSION, &value, sizeof(value)));
+}
+
+void setUp(void)
+{
+  hal_sim_reset();
+}
+
+void tearDown(void)
+{
+}
+
+static void test_empty_and_reload(void)
+{
+  CONFIG_STORE store;
+  ST_CONFIG_RECORD record;
+
+  TEST_ASSERT_FALSE(store.begin());
+  TEST_ASSERT_TRUE(store.is_empty());
+  TEST_ASSERT_FALSE(store.find(TYPE_CALIBRATION, record));
+  TEST_ASSERT_FALSE(store.append(CONFIG_STORE_TYPES, VERSION, "x", 1));
+
+  append_value(store, TYPE_CALIBRATION, 1234);
+  append_value(store, TYPE_CHECKPOINT, 5678);
+  TEST_ASSERT_EQUAL_UINT32(1234, read_value(store, TYPE_CALIBRATION));
+
+  // After a reset
+  CONFIG_STORE reloaded;
+
+  TEST_ASSERT_TRUE(reloaded.begin());
+  TEST_ASSERT_EQUAL_UINT32(1234, read_value(reloaded, TYPE_CALIBRATION));
+  TEST_ASSERT_EQUAL_UINT32(5678, read_value(reloaded, TYPE_CHECKPOINT));
+  TEST_ASSERT_FALSE(reloaded.find(TYPE_CALIBRATION, record, 1));
+}
+
+static void test_history_and_wear(void)
+{
+  CONFIG_STORE store;
+  const uint16_t slots = store.get_slots();
+  uint32_t max_writes = 0, min_writes = UINT32_MAX;
+
+  store.begin();
+  // The sequence number wraps around too
+  for (uint32_t i = 0; i < 70000; i++)
+    append_value(store, TYPE_CALIBRATION, i);
+
+  CONFIG_STORE reloaded;
+
+  TEST_ASSERT_TRUE(reloaded.begin());
+  TEST_ASSERT_EQUAL_UINT32(69999, read_value(reloaded, TYPE_CALIBRATION));
+  TEST_ASSERT_EQUAL_UINT32(69998, read_value(reloaded, TYPE_CALIBRATION, 1));
+  TEST_ASSERT_EQUAL_UINT32(70000 - slots, read_value(reloaded, TYPE_CALIBRATION, slots - 1));
+
+  // Every slot wears the same, the second sequence number byte changes on
+  // every append to it
+  for (uint16_t addr = 0; addr < HAL_EEPROM_SIZE; addr += CONFIG_STORE_RECORD)
+  {
+    const uint32_t writes = hal_sim_get_eeprom_writes(addr + 1);
+
+    max_writes = writes > max_writes ? writes : max_writes;
+    min_writes = writes < min_writes ? writes : min_writes;
+  }
+  TEST_ASSERT_TRUE(max_writes - min_writes <= 1);
+  TEST_ASSERT_EQUAL_UINT32((70000 + slots - 1) / slots, max_writes);
+}
+
+static void test_newest_of_type_kept(void)
+{
+  CONFIG_STORE store;
+
+  store.begin();
+  append_value(store, TYPE_CALIBRATION, 42);
+  for (uint32_t i = 0; i < 1000; i++)
+    append_value(store, TYPE_CHECKPOINT, i);
+
+  CONFIG_STORE reloaded;
+
+  TEST_ASSERT_TRUE(reloaded.begin());
+  TEST_ASSERT_EQUAL_UINT32(42, read_value(reloaded, TYPE_CALIBRATION));
+  TEST_ASSERT_EQUAL_UINT32(999, read_value(reloaded, TYPE_CHECKPOINT));
+  TEST_ASSERT_EQUAL_UINT32(1000 / (store.get_slots() - 1), store.get_stats().carried);
+}
+
+static void test_torn_append(void)
+{
+  CONFIG_STORE store;
+  uint8_t *eeprom = hal_sim_get_eeprom();
+
+  store.begin();
+  for (uint32_t i = 0; i < 300; i++)
+    append_value(store, TYPE_CALIBRATION, i);
+
+  // Reset in the middle of the 301st append, over the record 300 - slots
+  const uint16_t slot = 300 % store.get_slots();
+
+  eeprom[slot * CONFIG_STORE_RECORD] = 300 & 0xFF;
+  eeprom[slot * CONFIG_STORE_RECORD + 1] = 300 >> 8;
+  eeprom[slot * CONFIG_STORE_RECORD + 4] = 0xAA;
+
+  CONFIG_STORE reloaded;
+
+  TEST_ASSERT_TRUE(reloaded.begin());
+  TEST_ASSERT_EQUAL_UINT32(299, read_value(reloaded, TYPE_CALIBRATION));
+
+  // The torn slot is written again
+  append_value(reloaded, TYPE_CALIBRATION, 300);
+
+  CONFIG_STORE again;
+
+  TEST_ASSERT_TRUE(again.begin());
+  TEST_ASSERT_EQUAL_UINT32(300, read_value(again, TYPE_CALIBRATION));
+  TEST_ASSERT_EQUAL_UINT32(299, read_value(again, TYPE_CALIBRATION, 1));
+}
+
+// Writes only the first _budget bytes, as if reset during the next one
+static int32_t _budget;
+
+static void torn_write(uint16_t addr, uint8_t value)
+{
+  if (_budget > 0)
+  {
+    _budget--;
+    hal_eeprom_update(addr, value);
+  }
+}
+
+static void test_torn_carry_forward(void)
+{
+  // A reset at any byte of the appends around the copy of the calibration
+  for (int32_t bytes = 0; bytes <= 4 * (int32_t) CONFIG_STORE_RECORD; bytes++)
+  {
+    CONFIG_STORE store;
+    const uint16_t slots = store.get_slots();
+
+    hal_sim_reset();
+    store.begin();
+    append_value(store, TYPE_CALIBRATION, 42);
+    for (uint32_t i = 1; i < slots - 2U; i++)
+      append_value(store, TYPE_CHECKPOINT, i);
+
+    CONFIG_STORE torn(0, HAL_EEPROM_SIZE, hal_eeprom_read, torn_write);
+
+    _budget = bytes;
+    TEST_ASSERT_TRUE(torn.begin());
+    for (uint32_t i = slots - 2U; i < slots + 1U; i++)
+    {
+      const uint32_t value = i;
+
+      torn.append(TYPE_CHECKPOINT, VERSION, &value, sizeof(value));
+    }
+
+    CONFIG_STORE reloaded;
+
+    TEST_ASSERT_TRUE(reloaded.begin());
+    TEST_ASSERT_EQUAL_UINT32(42, read_value(reloaded, TYPE_CALIBRATION));
+    TEST_ASSERT_TRUE(read_value(reloaded, TYPE_CHECKPOINT) >= slots - 3U);
+  }
+}
+
+static void test_carry_forward_unreadable(void)
+{
+  CONFIG_STORE store;
+  const uint16_t slots = store.get_slots();
+  const uint32_t value = 5;
+  uint8_t eeprom[HAL_EEPROM_SIZE];
+
+  store.begin();
+  append_value(store, TYPE_CALIBRATION, 42);
+  for (uint32_t i = 1; i < slots - 1U; i++)
+    append_value(store, TYPE_CHECKPOINT, i);
+
+  // The calibration in slot 0 goes bad before it is copied forward
+  hal_sim_get_eeprom()[4] ^= 0x01;
+  memcpy(eeprom, hal_sim_get_eeprom(), sizeof(eeprom));
+  TEST_ASSERT_FALSE(store.append(TYPE_CHECKPOINT, VERSION, &value, sizeof(value)));
+  TEST_ASSERT_EQUAL_MEMORY(eeprom, hal_sim_get_eeprom(), sizeof(eeprom));
+  TEST_ASSERT_EQUAL_UINT32(0, store.get_stats().carried);
+  TEST_ASSERT_EQUAL_UINT32(slots - 2U, read_value(store, TYPE_CHECKPOINT));
+}
+
+static void test_boot_reads_bounded(void)
+{
+  CONFIG_STORE store;
+
+  store.begin();
+  for (uint32_t i = 0; i < 1000; i++)
+    append_value(store, i % 10 ? TYPE_CHECKPOINT : TYPE_CALIBRATION, i);
+
+  CONFIG_STORE reloaded;
+  const uint32_t reads = hal_sim_get_eeprom_reads();
+
+  TEST_ASSERT_TRUE(reloaded.begin());
+  // Headers twice and a few records, not the whole EEPROM
+  TEST_ASSERT_EQUAL_UINT32(hal_sim_get_eeprom_reads() - reads, reloaded.get_stats().reads);
+  TEST_ASSERT_TRUE(reloaded.get_stats().reads < HAL_EEPROM_SIZE / 2);
+  TEST_ASSERT_EQUAL_UINT32(990, read_value(reloaded, TYPE_CALIBRATION));
+  TEST_ASSERT_EQUAL_UINT32(999, read_value(reloaded, TYPE_CHECKPOINT));
+}
+
+static int run_tests(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_empty_and_reload);
+  RUN_TEST(test_history_and_wear);
+  RUN_TEST(test_newest_of_type_kept);
+  RUN_TEST(test_torn_append);
+  RUN_TEST(test_torn_carry_forward);
+  RUN_TEST(test_carry_forward_unreadable);
+  RUN_TEST(test_boot_reads_bounded);
+  return UNITY_END();
+}
+
+int main(void)
+{
+  return run_tests();
+}
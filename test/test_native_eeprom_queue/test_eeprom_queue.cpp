@@ -0,0 +1,199 @@
+/*******************************************************************************
+ * @file    test_eeprom_queue.cpp
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Unit tests of the EEPROM_QUEUE against the simulated EEPROM and
+ *          its ready interrupt of lib/Hal. Host only.
+*******************************************************************************/
+
+#include <string.h>
+#include <unity.h>
+#include <Hal.h>
+#include <EepromQueue.h>
+#include <ConfigStore.h>
+
+static EEPROM_QUEUE *queue;
+static uint32_t done_calls = 0;
+
+static void done_cb(void *ctx)
+{
+  (void) ctx;
+  done_calls++;
+}
+
+static uint8_t queue_read(uint16_t addr)
+{
+  return queue->read(addr);
+}
+
+static void queue_update(uint16_t addr, uint8_t value)
+{
+  queue->update(addr, value);
+}
+
+void setUp(void)
+{
+  hal_sim_reset();
+  done_calls = 0;
+}
+
+void tearDown(void)
+{
+}
+
+static void test_non_blocking(void)
+{
+  EEPROM_QUEUE q;
+  const uint64_t start = hal_sim_get_time_us();
+
+  q.set_done_cb(done_cb);
+  for (uint8_t i = 0; i < 16; i++)
+    TEST_ASSERT_TRUE(q.write(100 + i, i));
+
+  // Queued, nothing waited for the EEPROM
+  TEST_ASSERT_EQUAL_UINT64(start, hal_sim_get_time_us());
+  TEST_ASSERT_EQUAL_UINT8(16, q.get_pending());
+  TEST_ASSERT_FALSE(q.is_idle());
+  TEST_ASSERT_EQUAL_HEX8(0xFF, hal_sim_get_eeprom()[115]);
+  TEST_ASSERT_EQUAL_UINT8(15, q.read(115));
+
+  // Written in the background
+  hal_sim_advance_us(16 * HAL_EEPROM_WRITE_US);
+  TEST_ASSERT_TRUE(q.is_idle());
+  TEST_ASSERT_EQUAL_UINT32(1, done_calls);
+  TEST_ASSERT_EQUAL_UINT32(16, q.get_stats().written);
+  for (uint8_t i = 0; i < 16; i++)
+    TEST_ASSERT_EQUAL_UINT8(i, hal_sim_get_eeprom()[100 + i]);
+}
+
+static void test_coherent_read(void)
+{
+  EEPROM_QUEUE q;
+
+  // The first write starts at once, the second one is queued behind it
+  q.write(10, 1);
+  q.write(11, 7);
+  q.write(10, 2);
+  hal_sim_advance_us(HAL_EEPROM_WRITE_US / 2);
+  TEST_ASSERT_EQUAL_HEX8(0xFF, hal_sim_get_eeprom()[10]);
+  TEST_ASSERT_EQUAL_UINT8(2, q.read(10));
+  TEST_ASSERT_EQUAL_UINT8(7, q.read(11));
+
+  hal_sim_advance_us(HAL_EEPROM_WRITE_US);
+  TEST_ASSERT_EQUAL_UINT8(1, hal_sim_get_eeprom()[10]);
+  TEST_ASSERT_EQUAL_UINT8(2, q.read(10));
+
+  hal_sim_advance_us(2 * HAL_EEPROM_WRITE_US);
+  TEST_ASSERT_TRUE(q.is_idle());
+  TEST_ASSERT_EQUAL_UINT8(2, hal_sim_get_eeprom()[10]);
+  TEST_ASSERT_EQUAL_UINT8(2, q.read(10));
+  // Not queued, from the EEPROM
+  TEST_ASSERT_EQUAL_HEX8(0xFF, q.read(12));
+}
+
+static void test_read_while_writing(void)
+{
+  EEPROM_QUEUE q;
+
+  for (uint8_t i = 0; i < 8; i++)
+    hal_sim_get_eeprom()[200 + i] = 0x80 | i;
+  for (uint8_t i = 0; i < 8; i++)
+    q.write(300 + i, i);
+
+  // Bytes not queued, each one after the write in progress, between the
+  // writes the ready interrupt starts
+  for (uint8_t i = 0; i < 6; i++)
+  {
+    const uint64_t start = hal_sim_get_time_us();
+
+    TEST_ASSERT_EQUAL_HEX8(0x80 | i, q.read(200 + i));
+    TEST_ASSERT_TRUE(hal_sim_get_time_us() - start <= HAL_EEPROM_WRITE_US);
+    TEST_ASSERT_EQUAL_UINT32(i + 1, q.get_stats().written);
+    TEST_ASSERT_FALSE(q.is_idle());
+  }
+  // Queued ones from the queue
+  TEST_ASSERT_EQUAL_UINT8(7, q.read(307));
+
+  hal_sim_advance_us(8 * HAL_EEPROM_WRITE_US);
+  TEST_ASSERT_TRUE(q.is_idle());
+  for (uint8_t i = 0; i < 8; i++)
+    TEST_ASSERT_EQUAL_UINT8(i, hal_sim_get_eeprom()[300 + i]);
+  for (uint8_t i = 0; i < 8; i++)
+    TEST_ASSERT_EQUAL_HEX8(0x80 | i, hal_sim_get_eeprom()[200 + i]);
+}
+
+static void test_unchanged_skipped(void)
+{
+  EEPROM_QUEUE q;
+
+  hal_sim_get_eeprom()[20] = 0x55;
+  q.write(20, 0x55);
+  q.write(21, 0xFF);
+  hal_sim_advance_us(HAL_EEPROM_WRITE_US);
+  TEST_ASSERT_TRUE(q.is_idle());
+  TEST_ASSERT_EQUAL_UINT32(0, q.get_stats().written);
+  TEST_ASSERT_EQUAL_UINT32(2, q.get_stats().skipped);
+  TEST_ASSERT_EQUAL_UINT32(0, hal_sim_get_eeprom_writes(20));
+  TEST_ASSERT_EQUAL_UINT32(0, hal_sim_get_eeprom_writes(21));
+}
+
+static void test_full_update_waits(void)
+{
+  EEPROM_QUEUE q;
+
+  for (uint16_t i = 0; i < 2 * EEPROM_QUEUE_SIZE; i++)
+    q.update(i, i & 0x7F);
+
+  TEST_ASSERT_TRUE(q.get_stats().full > 0);
+  TEST_ASSERT_EQUAL_UINT8(EEPROM_QUEUE_SIZE, q.get_stats().high_watermark);
+  hal_sim_advance_us(EEPROM_QUEUE_SIZE * HAL_EEPROM_WRITE_US);
+  TEST_ASSERT_TRUE(q.is_idle());
+  for (uint16_t i = 0; i < 2 * EEPROM_QUEUE_SIZE; i++)
+    TEST_ASSERT_EQUAL_UINT8(i & 0x7F, hal_sim_get_eeprom()[i]);
+}
+
+static void test_config_store_append(void)
+{
+  EEPROM_QUEUE q;
+  CONFIG_STORE store(0, HAL_EEPROM_SIZE, queue_read, queue_update);
+  const uint32_t value = 0x12345678;
+  ST_CONFIG_RECORD record;
+
+  queue = &q;
+  store.begin();
+
+  const uint64_t start = hal_sim_get_time_us();
+
+  TEST_ASSERT_TRUE(store.append(0, 1, &value, sizeof(value)));
+  TEST_ASSERT_EQUAL_UINT64(start, hal_sim_get_time_us());
+  // Readable while queued
+  TEST_ASSERT_TRUE(store.find(0, record));
+  TEST_ASSERT_EQUAL_MEMORY(&value, record.data, sizeof(value));
+
+  hal_sim_advance_us(CONFIG_STORE_RECORD * HAL_EEPROM_WRITE_US);
+  TEST_ASSERT_TRUE(q.is_idle());
+
+  // After a reset, directly from the EEPROM
+  CONFIG_STORE reloaded;
+
+  TEST_ASSERT_TRUE(reloaded.begin());
+  TEST_ASSERT_TRUE(reloaded.find(0, record));
+  TEST_ASSERT_EQUAL_MEMORY(&value, record.data, sizeof(value));
+}
+
+static int run_tests(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_non_blocking);
+  RUN_TEST(test_coherent_read);
+  RUN_TEST(test_read_while_writing);
+  RUN_TEST(test_unchanged_skipped);
+  RUN_TEST(test_full_update_waits);
+  RUN_TEST(test_config_store_append);
+  return UNITY_END();
+}
+
+int main(void)
+{
+  return run_tests();
+}
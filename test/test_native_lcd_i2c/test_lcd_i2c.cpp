@@ -0,0 +1,168 @@
+/*******************************************************************************
+ * @file    test_lcd_i2c.cpp
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Unit tests of the LCD_I2C class. The I2C writes of the simulated
+ *          HAL drive a model of the PCF8574 and the HD44780, which checks the
+ *          RS setup and the execution time between characters. Host only.
+*******************************************************************************/
+
+#include <string.h>
+#include <unity.h>
+#include <Hal.h>
+#include <LcdI2c.h>
+
+#define ADDRESS 0x27
+#define RS 0x01
+#define EN 0x04
+
+static const uint8_t row_offsets[] = { 0x00, 0x40, 0x14, 0x54 };
+
+// HD44780 in front of a PCF8574
+static struct {
+  bool four_bit;
+  bool high;
+  uint8_t hi;
+  uint8_t addr;
+  uint8_t ddram[128];
+  uint8_t last;
+  uint32_t bytes_since_exec;
+  uint32_t setup_errors;
+  uint32_t timing_errors;
+} lcd;
+
+static void exec(uint8_t value, bool rs)
+{
+  if (rs)
+    lcd.ddram[lcd.addr++ & 0x7F] = value;
+  else if (value == 0x01)
+    memset(lcd.ddram, ' ', sizeof(lcd.ddram)), lcd.addr = 0;
+  else if (value == 0x02)
+    lcd.addr = 0;
+  else if (value & 0x80)
+    lcd.addr = value & 0x7F;
+  lcd.bytes_since_exec = 0;
+}
+
+static void expander(uint8_t b)
+{
+  if ((b & EN) && !(lcd.last & EN))
+  {
+    if ((b ^ lcd.last) & RS)
+      lcd.setup_errors++;
+    // 37us at 22.5us per byte
+    if (lcd.four_bit && lcd.high && lcd.bytes_since_exec < 2)
+      lcd.timing_errors++;
+  }
+  if (!(b & EN) && (lcd.last & EN))
+  {
+    const uint8_t data = lcd.last & 0xF0;
+
+    if (!lcd.four_bit)
+    {
+      lcd.four_bit = data == 0x20;
+      lcd.high = true;
+    }
+    else if (lcd.high)
+    {
+      lcd.hi = data;
+      lcd.high = false;
+    }
+    else
+    {
+      lcd.high = true;
+      exec(lcd.hi | (data >> 4), lcd.last & RS);
+    }
+  }
+  lcd.bytes_since_exec++;
+  lcd.last = b;
+}
+
+static void i2c_sink(uint8_t address, const uint8_t *data, uint8_t len)
+{
+  TEST_ASSERT_EQUAL_UINT8(ADDRESS, address);
+  for (uint8_t i = 0; i < len; i++)
+    expander(data[i]);
+}
+
+static void assert_row(const char *expected, uint8_t row)
+{
+  TEST_ASSERT_EQUAL_MEMORY(expected, &lcd.ddram[row_offsets[row]], strlen(expected));
+}
+
+void setUp(void)
+{
+  hal_sim_reset();
+  hal_sim_set_i2c_sink(i2c_sink);
+  memset(&lcd, 0, sizeof(lcd));
+  lcd.bytes_since_exec = 100;
+}
+
+void tearDown(void)
+{
+}
+
+static void test_init_and_write(void)
+{
+  LCD_I2C display(ADDRESS, 20, 4);
+
+  display.init();
+  display.backlight();
+  TEST_ASSERT_TRUE(lcd.four_bit);
+  TEST_ASSERT_TRUE(lcd.last & 0x08);
+
+  display.setCursor(0, 0);
+  display.print("Warming up");
+  display.setCursor(4, 1);
+  display.print("23:59:59");
+  display.setCursor(0, 3);
+  display.print('x');
+
+  assert_row("Warming up          ", 0);
+  assert_row("    23:59:59        ", 1);
+  assert_row("x", 3);
+  TEST_ASSERT_EQUAL_UINT32(0, lcd.setup_errors);
+  TEST_ASSERT_EQUAL_UINT32(0, lcd.timing_errors);
+}
+
+static void test_line_batched(void)
+{
+  LCD_I2C display(ADDRESS, 16, 2);
+
+  display.init();
+  display.reset_stats();
+  const uint32_t transactions = hal_sim_get_i2c_transactions();
+  const uint64_t start = hal_sim_get_time_us();
+
+  // A cursor command and a line
+  display.setCursor(0, 1);
+  display.print("Calibrating... K");
+
+  const uint64_t elapsed = hal_sim_get_time_us() - start;
+  const ST_LCD_I2C_STATS &stats = display.get_stats();
+
+  assert_row("Calibrating... K", 1);
+  TEST_ASSERT_EQUAL_UINT32(16, stats.chars);
+  TEST_ASSERT_EQUAL_UINT32(1, stats.commands);
+  TEST_ASSERT_EQUAL_UINT32(hal_sim_get_i2c_transactions() - transactions, stats.transactions);
+  // 17 LCD bytes of 5 expander writes, one RS setup
+  TEST_ASSERT_EQUAL_UINT32(17 * 5 + 1, stats.bytes);
+  TEST_ASSERT_EQUAL_UINT32((stats.bytes + HAL_I2C_BUFFER - 1) / HAL_I2C_BUFFER, stats.transactions);
+  // ~22.5us per byte at 400kHz
+  TEST_ASSERT_TRUE(elapsed < 2500);
+  TEST_ASSERT_EQUAL_UINT32(0, lcd.setup_errors);
+  TEST_ASSERT_EQUAL_UINT32(0, lcd.timing_errors);
+}
+
+static int run_tests(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_init_and_write);
+  RUN_TEST(test_line_batched);
+  return UNITY_END();
+}
+
+int main(void)
+{
+  return run_tests();
+}
@@ -0,0 +1,317 @@
+/*******************************************************************************
+ * @file    test_scheduler.cpp
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Unit tests of the SCHEDULER against the virtual clock of lib/Hal.
+ *          Host only.
+*******************************************************************************/
+
+#include <unity.h>
+#include <Hal.h>
+#include <Tfsm.h>
+#include <TfsmP.h>
+#include <Scheduler.h>
+#include <Mq3.h>
+
+#define STATE_PARK 1
+
+static uint32_t runs[3] = {0};
+static uint32_t idle_calls = 0;
+static uint32_t overrun_calls = 0;
+static uint32_t overrun_lateness_us = 0;
+// Run time of the next action_stall, once
+static uint32_t stall_us = 0;
+// Sampled by action_measure, its measurements and faults
+static MQ3 *sensor = NULL;
+static uint32_t measured = 0;
+static uint32_t faults = 0;
+
+static void action_fast(void *arg) { (void) arg; runs[0]++; hal_sim_advance_us(2000); }
+static void action_medium(void *arg) { (void) arg; runs[1]++; hal_sim_advance_us(3000); }
+static void action_slow(void *arg) { (void) arg; runs[2]++; hal_sim_advance_us(20000); }
+static void action_stall(void *arg) { (void) arg; runs[0]++; hal_sim_advance_us(stall_us); stall_us = 0; }
+static void action_measure(void *arg)
+{
+  (void) arg;
+  runs[0]++;
+  hal_sim_advance_us(stall_us);
+  stall_us = 0;
+  if (sensor->measure())
+    measured++;
+  else if (!sensor->is_pending())
+    faults++;
+}
+static void idle_cb(void) { idle_calls++; }
+static void overrun_cb(uint8_t id, uint32_t lateness_us) { (void) id; overrun_calls++; overrun_lateness_us = lateness_us; }
+
+static constexpr TFSM::ST_STATE table_fast[] PROGMEM = {
+  {100, 1, 0, 0, 0, action_fast, NULL, NULL},
+};
+static TFSM::ST_STATE table_medium[] = {
+  {250, 1, 0, 0, 0, action_medium, NULL, NULL},
+};
+static constexpr TFSM::ST_STATE table_slow[] PROGMEM = {
+  {1000, 5, 0, STATE_PARK, 0, action_slow, NULL, NULL},
+  {UINT32_MAX, 1, 0, STATE_PARK, STATE_PARK, NULL, NULL, NULL},
+};
+static constexpr TFSM::ST_STATE table_warmup[] PROGMEM = {
+  {1000, 3600, 0, 0, 0, action_medium, NULL, NULL},
+};
+static constexpr TFSM::ST_STATE table_minute[] PROGMEM = {
+  {60000, 1, 0, 0, 0, action_fast, NULL, NULL},
+};
+static constexpr TFSM::ST_STATE table_stall[] PROGMEM = {
+  {100, 1, 0, 0, 0, action_stall, NULL, NULL},
+};
+static constexpr TFSM::ST_STATE table_measure[] PROGMEM = {
+  {250, 1, 0, 0, 0, action_measure, NULL, NULL},
+};
+
+void setUp(void)
+{
+  hal_sim_reset();
+  runs[0] = runs[1] = runs[2] = 0;
+  idle_calls = 0;
+  overrun_calls = 0;
+  overrun_lateness_us = 0;
+  stall_us = 0;
+  measured = 0;
+  faults = 0;
+}
+
+void tearDown(void)
+{
+}
+
+static void test_dispatch(void)
+{
+  TFSM_STATIC<table_fast> fast;
+  TFSM medium(table_medium, 1);
+  SCHEDULER<2> scheduler;
+
+  TEST_ASSERT_EQUAL_INT8(0, scheduler.add(fast));
+  TEST_ASSERT_EQUAL_INT8(1, scheduler.add(medium));
+  TEST_ASSERT_EQUAL_INT8(-1, scheduler.add(medium));
+  scheduler.set_idle_cb(idle_cb);
+  scheduler.start();
+
+  while (hal_sim_get_time_us() < 10000000UL)
+    scheduler.tick();
+
+  // 10 and 4 runs per second, the run time and lateness do not add to the period
+  TEST_ASSERT_TRUE(runs[0] >= 99 && runs[0] <= 100);
+  TEST_ASSERT_TRUE(runs[1] >= 39 && runs[1] <= 40);
+  TEST_ASSERT_EQUAL_UINT32(0, scheduler.get_task_stats(0).overruns);
+  TEST_ASSERT_EQUAL_UINT32(runs[0], scheduler.get_task_stats(0).runs);
+  TEST_ASSERT_EQUAL_UINT32(runs[1], scheduler.get_task_stats(1).runs);
+  // After every run and before every idle sleep
+  TEST_ASSERT_EQUAL_UINT32(runs[0] + runs[1] + scheduler.get_stats().wakeups, hal_sim_get_watchdog_resets());
+  // Late by at most a wake up period plus the run time of the other machine
+  TEST_ASSERT_TRUE(scheduler.get_task_stats(0).lateness_max_us <= HAL_TICK_US + 3000);
+  TEST_ASSERT_TRUE(scheduler.get_task_stats(1).lateness_max_us <= HAL_TICK_US + 2000);
+  TEST_ASSERT_TRUE(scheduler.get_duty_cycle() > 0);
+  // Once before every idle sleep
+  TEST_ASSERT_EQUAL_UINT32(scheduler.get_stats().wakeups, idle_calls);
+  TEST_ASSERT_EQUAL_UINT32(hal_sim_get_idles(), idle_calls);
+}
+
+static void test_idle_skip(void)
+{
+  TFSM_STATIC<table_fast> fast;
+  TFSM medium(table_medium, 1);
+  SCHEDULER<2> scheduler;
+
+  hal_sim_set_idle_skip(true);
+  scheduler.add(fast);
+  scheduler.add(medium);
+  scheduler.start();
+
+  while (hal_sim_get_time_us() < 10000000UL)
+    scheduler.tick();
+
+  // One wake up per run instead of one per tick, on the deadline
+  TEST_ASSERT_TRUE(runs[0] >= 98 && runs[0] <= 100);
+  TEST_ASSERT_TRUE(runs[1] >= 39 && runs[1] <= 40);
+  TEST_ASSERT_TRUE(scheduler.get_stats().wakeups <= runs[0] + runs[1]);
+  TEST_ASSERT_TRUE(scheduler.get_task_stats(0).lateness_max_us <= 3000);
+  TEST_ASSERT_TRUE(scheduler.get_task_stats(1).lateness_max_us <= 2000);
+}
+
+static void test_drift_free(void)
+{
+  TFSM_STATIC<table_warmup> warmup;
+  SCHEDULER<1> scheduler;
+
+  hal_sim_set_idle_skip(true);
+  scheduler.add(warmup);
+  scheduler.start();
+
+  // An hour of 1000ms cycles, each with 3ms of run time
+  while (warmup.get_current_steps() > 0)
+    scheduler.tick();
+
+  // The last run is on its deadline, 3600s after the start
+  TEST_ASSERT_EQUAL_UINT32(3600, runs[1]);
+  TEST_ASSERT_EQUAL_UINT64(3600000000ULL + 3000, hal_sim_get_time_us());
+  TEST_ASSERT_EQUAL_UINT32(0, scheduler.get_task_stats(0).overruns);
+}
+
+static void test_overrun_catch_up(void)
+{
+  TFSM_STATIC<table_stall> stall;
+  SCHEDULER<1> scheduler;
+
+  hal_sim_set_idle_skip(true);
+  scheduler.add(stall);
+  scheduler.set_overrun_cb(overrun_cb);
+  scheduler.start();
+
+  while (hal_sim_get_time_us() <= 1000000UL)
+  {
+    // The 3rd run takes 350ms, 3 deadlines pass meanwhile
+    if (runs[0] == 2)
+      stall_us = 350000UL;
+    scheduler.tick();
+  }
+
+  // The missed runs ran back to back, no step is lost
+  TEST_ASSERT_EQUAL_UINT32(10, runs[0]);
+  TEST_ASSERT_EQUAL_UINT32(0, scheduler.get_task_stats(0).skipped);
+  // The runs 4 and 5 found their next deadline passed too
+  TEST_ASSERT_EQUAL_UINT32(2, scheduler.get_task_stats(0).overruns);
+  TEST_ASSERT_EQUAL_UINT32(2, overrun_calls);
+  TEST_ASSERT_EQUAL_UINT32(150000UL, overrun_lateness_us);
+  TEST_ASSERT_EQUAL_UINT32(250000UL, scheduler.get_task_stats(0).lateness_max_us);
+}
+
+static void test_overrun_skip(void)
+{
+  TFSM_STATIC<table_stall> stall;
+  SCHEDULER<1> scheduler;
+
+  hal_sim_set_idle_skip(true);
+  TEST_ASSERT_EQUAL_INT8(0, scheduler.add(stall, SCHEDULER_SKIP));
+  scheduler.start();
+
+  while (hal_sim_get_time_us() <= 1000000UL)
+  {
+    if (runs[0] == 2)
+      stall_us = 350000UL;
+    scheduler.tick();
+  }
+
+  // The deadlines at 400, 500 and 600ms were dropped, the rest on the grid
+  TEST_ASSERT_EQUAL_UINT32(7, runs[0]);
+  TEST_ASSERT_EQUAL_UINT32(3, scheduler.get_task_stats(0).skipped);
+  TEST_ASSERT_EQUAL_UINT32(0, scheduler.get_task_stats(0).overruns);
+  TEST_ASSERT_EQUAL_UINT32(0, scheduler.get_task_stats(0).lateness_max_us);
+  // Asleep until the deadline after the one at 1000ms
+  TEST_ASSERT_EQUAL_UINT64(1100000UL, hal_sim_get_time_us());
+}
+
+static void test_overrun_measure(void)
+{
+  TFSM_STATIC<table_measure> measure;
+  SCHEDULER<1> scheduler;
+  MQ3 mq3(A3);
+
+  sensor = &mq3;
+  hal_sim_set_idle_skip(true);
+  hal_sim_set_adc_value(A3, 300);
+  TEST_ASSERT_TRUE(mq3.start_sampling());
+  scheduler.add(measure);
+  scheduler.start();
+
+  while (hal_sim_get_time_us() <= 3000000UL)
+  {
+    // The 3rd run takes 1s, 4 deadlines pass meanwhile
+    if (runs[0] == 2)
+      stall_us = 1000000UL;
+    scheduler.tick();
+  }
+
+  // The runs caught up back to back found no new block, not a fault
+  TEST_ASSERT_EQUAL_UINT32(12, runs[0]);
+  TEST_ASSERT_TRUE(scheduler.get_task_stats(0).overruns > 0);
+  TEST_ASSERT_EQUAL_UINT32(0, faults);
+  TEST_ASSERT_TRUE(measured >= runs[0] - 4 && measured < runs[0]);
+
+  // No block for MQ3_SAMPLING_BLOCKS block periods is a fault
+  hal_adc_stop_free_running();
+  while (hal_sim_get_time_us() <= 6000000UL)
+    scheduler.tick();
+  TEST_ASSERT_TRUE(faults > 0);
+  TEST_ASSERT_TRUE(faults < runs[0] - 12);
+  mq3.stop_sampling();
+}
+
+static void test_long_cycle_keeps_watchdog(void)
+{
+  TFSM_STATIC<table_minute> minute;
+  SCHEDULER<1> scheduler;
+  // The WDTO_8S period of main.cpp
+  const uint64_t watchdog_us = 8000000ULL;
+  uint64_t last_reset_us = 0;
+  uint32_t resets = 0;
+
+  hal_sim_set_idle_skip(true);
+  scheduler.add(minute);
+  scheduler.start();
+
+  while (hal_sim_get_time_us() <= 180000000ULL)
+  {
+    scheduler.tick();
+    if (hal_sim_get_watchdog_resets() != resets)
+    {
+      resets = hal_sim_get_watchdog_resets();
+      last_reset_us = hal_sim_get_time_us();
+    }
+    TEST_ASSERT_TRUE(hal_sim_get_time_us() - last_reset_us < watchdog_us);
+  }
+
+  // Still on its deadlines, woken up at most every SCHEDULER_IDLE_MAX_MS
+  TEST_ASSERT_EQUAL_UINT32(3, runs[0]);
+  TEST_ASSERT_EQUAL_UINT32(0, scheduler.get_task_stats(0).overruns);
+  TEST_ASSERT_TRUE(scheduler.get_stats().wakeups <= 180000 / SCHEDULER_IDLE_MAX_MS + 3);
+}
+
+static void test_parked_machine_stops_watchdog(void)
+{
+  TFSM_STATIC<table_fast> fast;
+  TFSM_STATIC<table_slow> slow;
+  SCHEDULER<2> scheduler;
+
+  scheduler.add(fast);
+  scheduler.add(slow);
+  scheduler.start();
+
+  while (hal_sim_get_time_us() < 10000000UL)
+    scheduler.tick();
+
+  // 5 steps and the transition into the parked state
+  TEST_ASSERT_EQUAL_UINT32(5, runs[2]);
+  TEST_ASSERT_TRUE(scheduler.is_parked(1));
+  TEST_ASSERT_FALSE(scheduler.is_parked(0));
+  TEST_ASSERT_TRUE(runs[0] > 90);
+  // no watchdog resets after parking at ~6s, neither on runs nor idle
+  const uint32_t resets = hal_sim_get_watchdog_resets();
+
+  while (hal_sim_get_time_us() < 15000000UL)
+    scheduler.tick();
+  TEST_ASSERT_EQUAL_UINT32(resets, hal_sim_get_watchdog_resets());
+  TEST_ASSERT_TRUE(runs[0] > 140);
+}
+
+int main(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_dispatch);
+  RUN_TEST(test_idle_skip);
+  RUN_TEST(test_drift_free);
+  RUN_TEST(test_overrun_catch_up);
+  RUN_TEST(test_overrun_skip);
+  RUN_TEST(test_overrun_measure);
+  RUN_TEST(test_long_cycle_keeps_watchdog);
+  RUN_TEST(test_parked_machine_stops_watchdog);
+  return UNITY_END();
+}
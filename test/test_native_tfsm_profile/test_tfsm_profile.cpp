@@ -0,0 +1,232 @@
+/*******************************************************************************
+ * @file    test_tfsm_profile.cpp
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Unit tests of the TFSM profiling against the virtual clock of
+ *          lib/Hal. Host only, built with TFSM_PROFILE=1 (env:native_profile).
+*******************************************************************************/
+
+#include <string.h>
+#include <unity.h>
+#include <Hal.h>
+#include <Tfsm.h>
+#include <TfsmP.h>
+
+#define STATE_A 0
+#define STATE_B 1
+#define STATE_C 2
+
+#define ACTION_A_US 50U
+#define ACTION_B_US 3000U
+#define DELAY_CB_US 700U
+
+void setUp(void)
+{
+  hal_sim_reset();
+}
+
+void tearDown(void)
+{
+}
+
+#if TFSM_PROFILE
+class STRING_PRINT : public Print
+{
+  public:
+    size_t write(uint8_t c)
+    {
+      if (this->_len + 1 < sizeof(this->_buf))
+      {
+        this->_buf[this->_len++] = (char) c;
+        this->_buf[this->_len] = '\0';
+      }
+      return 1;
+    }
+    const char *c_str(void) { return this->_buf; }
+
+  private:
+    char _buf[512] = {0};
+    size_t _len = 0;
+};
+
+static void action_a(void *arg) { (void) arg; hal_sim_advance_us(ACTION_A_US); }
+static void action_b(void *arg) { (void) arg; hal_sim_advance_us(ACTION_B_US); }
+static void action_c(void *arg) { (void) arg; }
+static void delay_cb(void) { hal_sim_advance_us(DELAY_CB_US); }
+
+static TFSM::ST_STATE table[] = {
+  {100, 2, 1, STATE_B, STATE_C, action_a, NULL, delay_cb},
+  {200, 3, 0, STATE_A, STATE_C, action_b, NULL, NULL},
+  {UINT32_MAX, 1, 0, STATE_C, STATE_C, action_c, NULL, NULL},
+};
+
+static constexpr TFSM::ST_STATE table_P[] PROGMEM = {
+  {100, 2, 1, STATE_B, STATE_C, action_a, NULL, delay_cb},
+  {200, 3, 0, STATE_A, STATE_C, action_b, NULL, NULL},
+  {UINT32_MAX, 1, 0, STATE_C, STATE_C, action_c, NULL, NULL},
+};
+
+// Runs as the scheduler does, late_us after the cycle of the previous run,
+// counted from its start, has elapsed
+template <typename T>
+static void run_late(T &fsm, uint64_t &start_us, uint32_t late_us)
+{
+  start_us += fsm.get_current_cycle() * 1000ULL + late_us;
+  hal_sim_advance_us(start_us - hal_sim_get_time_us());
+  fsm.run();
+}
+
+static void test_bucket(void)
+{
+  TEST_ASSERT_EQUAL_UINT8(0, TFSM_PROFILER::bucket(0));
+  TEST_ASSERT_EQUAL_UINT8(1, TFSM_PROFILER::bucket(1));
+  TEST_ASSERT_EQUAL_UINT8(2, TFSM_PROFILER::bucket(2));
+  TEST_ASSERT_EQUAL_UINT8(2, TFSM_PROFILER::bucket(3));
+  TEST_ASSERT_EQUAL_UINT8(6, TFSM_PROFILER::bucket(ACTION_A_US));
+  TEST_ASSERT_EQUAL_UINT8(9, TFSM_PROFILER::bucket(256));
+  TEST_ASSERT_EQUAL_UINT8(17, TFSM_PROFILER::bucket(65536));
+  TEST_ASSERT_EQUAL_UINT8(TFSM_PROFILE_BUCKETS - 1, TFSM_PROFILER::bucket(UINT32_MAX));
+}
+
+static void test_action_and_delay_cb(void)
+{
+  TFSM fsm(table, sizeof(table) / sizeof(TFSM::ST_STATE));
+
+  // A, A, delay, B
+  for (uint8_t i = 0; i < 4; i++)
+    fsm.run();
+
+  const ST_TFSM_PROFILE &a = fsm.get_profile().get(STATE_A);
+  const ST_TFSM_PROFILE &b = fsm.get_profile().get(STATE_B);
+
+  TEST_ASSERT_EQUAL_UINT32(2, a.runs);
+  TEST_ASSERT_EQUAL_UINT16(2, a.action_us[TFSM_PROFILER::bucket(ACTION_A_US)]);
+  TEST_ASSERT_EQUAL_UINT32(ACTION_A_US, a.action_max_us);
+  TEST_ASSERT_EQUAL_UINT32(1, a.delay_cbs);
+  TEST_ASSERT_EQUAL_UINT32(DELAY_CB_US, a.delay_cb_max_us);
+  // The delay cycle is not an action
+  TEST_ASSERT_EQUAL_UINT32(1, b.runs);
+  TEST_ASSERT_EQUAL_UINT32(ACTION_B_US, b.action_max_us);
+  TEST_ASSERT_EQUAL_UINT16(1, b.action_us[TFSM_PROFILER::bucket(ACTION_B_US)]);
+}
+
+static void test_lateness(void)
+{
+  TFSM fsm(table, sizeof(table) / sizeof(TFSM::ST_STATE));
+
+  uint64_t start = hal_sim_get_time_us();
+
+  // Nothing to be late against
+  fsm.run();
+  TEST_ASSERT_EQUAL_UINT32(0, fsm.get_profile().get(STATE_A).lateness_max_us);
+
+  // The action of the previous run is part of the cycle, not lateness
+  run_late(fsm, start, 300);
+  run_late(fsm, start, 0);
+
+  const ST_TFSM_PROFILE &a = fsm.get_profile().get(STATE_A);
+
+  TEST_ASSERT_EQUAL_UINT32(300, a.lateness_max_us);
+  TEST_ASSERT_EQUAL_UINT16(1, a.lateness_us[TFSM_PROFILER::bucket(300)]);
+  TEST_ASSERT_EQUAL_UINT16(0, a.lateness_us[TFSM_PROFILER::bucket(ACTION_A_US)]);
+
+  // Early counts as 0, as the one on time
+  hal_sim_advance_us(10);
+  fsm.run();
+  TEST_ASSERT_EQUAL_UINT16(2, fsm.get_profile().get(STATE_A).lateness_us[0]);
+
+  fsm.get_profile().reset();
+  run_late(fsm, start, 1000);
+  TEST_ASSERT_EQUAL_UINT32(0, fsm.get_profile().get(STATE_A).lateness_max_us);
+  TEST_ASSERT_EQUAL_UINT16(0, fsm.get_profile().get(STATE_A).lateness_us[0]);
+}
+
+static void test_transitions_flash_table(void)
+{
+  TFSM fsm(table, sizeof(table) / sizeof(TFSM::ST_STATE));
+  TFSM_STATIC<table_P> fsm_P;
+  uint64_t start = hal_sim_get_time_us();
+
+  for (uint16_t i = 0; i < 100; i++)
+  {
+    if (i == 50)
+    {
+      fsm.set_alt_transition();
+      fsm_P.set_alt_transition();
+    }
+    // C never elapses, both machines are driven by hand there
+    if (fsm.get_current_state() == STATE_C)
+    {
+      fsm.run();
+      fsm_P.run();
+      continue;
+    }
+    run_late(fsm, start, i % 5);
+    fsm_P.run();
+  }
+
+  TEST_ASSERT_EQUAL_UINT8(STATE_C, fsm.get_current_state());
+  TEST_ASSERT_EQUAL_UINT8(sizeof(table_P) / sizeof(table_P[0]), fsm_P.get_profile().get_size());
+  for (uint8_t s = STATE_A; s <= STATE_C; s++)
+  {
+    const ST_TFSM_PROFILE &ram = fsm.get_profile().get(s);
+    const ST_TFSM_PROFILE &flash = fsm_P.get_profile().get(s);
+
+    TEST_ASSERT_EQUAL_UINT32(ram.runs, flash.runs);
+    TEST_ASSERT_EQUAL_UINT32(ram.entries, flash.entries);
+    TEST_ASSERT_EQUAL_UINT32(ram.alternate, flash.alternate);
+    TEST_ASSERT_EQUAL_MEMORY(ram.action_us, flash.action_us, sizeof(ram.action_us));
+  }
+
+  const uint32_t alternate = fsm.get_profile().get(STATE_A).alternate + fsm.get_profile().get(STATE_B).alternate;
+
+  TEST_ASSERT_EQUAL_UINT32(1, alternate);
+  // C has a step each and transitions to itself
+  TEST_ASSERT_EQUAL_UINT32(fsm.get_profile().get(STATE_C).runs, fsm.get_profile().get(STATE_C).entries);
+  // The start is not an entry
+  TEST_ASSERT_EQUAL_UINT32(fsm.get_profile().get(STATE_B).entries, fsm.get_profile().get(STATE_A).entries);
+}
+
+static void test_print(void)
+{
+  TFSM fsm(table, sizeof(table) / sizeof(TFSM::ST_STATE));
+  STRING_PRINT out;
+  uint64_t start = hal_sim_get_time_us();
+
+  fsm.run();
+  run_late(fsm, start, 5);
+  fsm.get_profile().print(out, STATE_A);
+
+  TEST_ASSERT_EQUAL_STRING(
+    "S0 runs 2 in 0 alt 0 dcb 0 max_us 50 5 0\r\n"
+    "S0 act 0 0 0 0 0 0 2\r\n"
+    "S0 late 0 0 0 1\r\n",
+    out.c_str()
+  );
+}
+#else
+static void test_disabled(void)
+{
+  TEST_IGNORE_MESSAGE("built without TFSM_PROFILE, see env:native_profile");
+}
+#endif
+
+static int run_tests(void)
+{
+  UNITY_BEGIN();
+#if TFSM_PROFILE
+  RUN_TEST(test_bucket);
+  RUN_TEST(test_action_and_delay_cb);
+  RUN_TEST(test_lateness);
+  RUN_TEST(test_transitions_flash_table);
+  RUN_TEST(test_print);
+#else
+  RUN_TEST(test_disabled);
+#endif
+  return UNITY_END();
+}
+
+int main(void)
+{
+  return run_tests();
+}
@@ -0,0 +1,176 @@
+/*******************************************************************************
+ * @file    test_shadow_lcd.cpp
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Unit tests of the SHADOW_LCD class against a fake LCD that keeps
+ *          its screen and counts the bytes sent. Runs both natively and on
+ *          target.
+*******************************************************************************/
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <string.h>
+#include <stdlib.h>
+#include <unity.h>
+#include <ShadowLcd.h>
+
+#define COLS 16
+#define ROWS 2
+
+class FAKE_LCD
+{
+  public:
+    void init(void) { memset(screen, ' ', sizeof(screen)); inits++; }
+    void backlight(void) {}
+    void setCursor(uint8_t c, uint8_t r) { col = c; row = r; commands++; }
+    size_t write(uint8_t c)
+    {
+      TEST_ASSERT_TRUE(col < COLS && row < ROWS);
+      screen[row][col++] = (char) c;
+      chars++;
+      return 1;
+    }
+    size_t write(const uint8_t *buffer, size_t size)
+    {
+      for (size_t i = 0; i < size; i++)
+        write(buffer[i]);
+      return size;
+    }
+
+    char screen[ROWS][COLS];
+    uint8_t col = 0, row = 0;
+    uint32_t inits = 0, commands = 0, chars = 0;
+};
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+static void test_only_changes_sent(void)
+{
+  FAKE_LCD lcd;
+  SHADOW_LCD<FAKE_LCD, COLS, ROWS> display(lcd);
+
+  display.init();
+  // Blank frame, nothing to send
+  TEST_ASSERT_EQUAL_UINT16(0, display.render());
+
+  display.setCursor(0, 0);
+  display.print("    0.12 mg/L");
+  TEST_ASSERT_EQUAL_UINT16(1 + 9, display.render());
+  TEST_ASSERT_EQUAL_MEMORY("    0.12 mg/L   ", lcd.screen[0], COLS);
+
+  // Same text again
+  display.setCursor(0, 0);
+  display.print("    0.12 mg/L");
+  TEST_ASSERT_EQUAL_UINT16(0, display.render());
+
+  // One digit
+  display.setCursor(0, 0);
+  display.print("    0.13 mg/L");
+  TEST_ASSERT_EQUAL_UINT16(2, display.render());
+
+  // Runs one character apart are merged
+  display.setCursor(0, 0);
+  display.print("    1.24 mg/L");
+  TEST_ASSERT_EQUAL_UINT16(1 + 4, display.render());
+  TEST_ASSERT_EQUAL_MEMORY("    1.24 mg/L   ", lcd.screen[0], COLS);
+  TEST_ASSERT_EQUAL_UINT32(3, display.get_stats().commands);
+  TEST_ASSERT_EQUAL_UINT32(1, lcd.inits);
+}
+
+static void test_clear_without_flicker(void)
+{
+  FAKE_LCD lcd;
+  SHADOW_LCD<FAKE_LCD, COLS, ROWS> display(lcd);
+
+  display.init();
+  display.setCursor(0, 1);
+  display.print("R0: 724");
+  display.render();
+
+  // Cleared and redrawn in the same frame: nothing changes on the LCD
+  display.clear();
+  display.setCursor(0, 1);
+  display.print("R0: 724");
+  TEST_ASSERT_EQUAL_UINT16(0, display.render());
+
+  display.clear();
+  TEST_ASSERT_EQUAL_UINT16(1 + 7, display.render());
+  TEST_ASSERT_EQUAL_MEMORY("                ", lcd.screen[1], COLS);
+}
+
+static void test_clipping(void)
+{
+  FAKE_LCD lcd;
+  SHADOW_LCD<FAKE_LCD, COLS, ROWS> display(lcd);
+
+  display.init();
+  display.setCursor(10, 0);
+  display.println("1234567890");
+  display.setCursor(0, 2);
+  display.print("x");
+  display.render();
+
+  TEST_ASSERT_EQUAL_MEMORY("          123456", lcd.screen[0], COLS);
+  TEST_ASSERT_EQUAL_MEMORY("                ", lcd.screen[1], COLS);
+  TEST_ASSERT_EQUAL_INT8('6', display.get_char(15, 0));
+}
+
+static void test_random_frames(void)
+{
+  FAKE_LCD lcd;
+  SHADOW_LCD<FAKE_LCD, COLS, ROWS> display(lcd);
+
+  srand(1);
+  display.init();
+  for (uint16_t frame = 0; frame < 500; frame++)
+  {
+    if (frame % 50 == 0)
+      display.clear();
+    for (uint8_t i = rand() % 4; i > 0; i--)
+    {
+      display.setCursor(rand() % COLS, rand() % ROWS);
+      display.print((long) (rand() % 1000));
+    }
+    display.render();
+
+    for (uint8_t r = 0; r < ROWS; r++)
+      for (uint8_t c = 0; c < COLS; c++)
+        TEST_ASSERT_EQUAL_INT8(display.get_char(c, r), lcd.screen[r][c]);
+  }
+  TEST_ASSERT_EQUAL_UINT32(lcd.commands, display.get_stats().commands);
+  TEST_ASSERT_EQUAL_UINT32(lcd.chars, display.get_stats().chars);
+}
+
+static int run_tests(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_only_changes_sent);
+  RUN_TEST(test_clear_without_flicker);
+  RUN_TEST(test_clipping);
+  RUN_TEST(test_random_frames);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup(void)
+{
+  delay(2000);
+  run_tests();
+}
+
+void loop(void)
+{
+}
+#else
+int main(void)
+{
+  return run_tests();
+}
+#endif
@@ -0,0 +1,161 @@
+/*******************************************************************************
+ * @file    test_telemetry.cpp
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Unit tests of the binary telemetry encoder and decoder.
+*******************************************************************************/
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <Telemetry.h>
+
+static const ST_TELEMETRY_READING reading = {
+  .timestamp = 0x00123400,
+  .state = 6,
+  .avalue = 512,
+  .millivolts = 2500,
+  .rs = 4700,
+  .mgL_q16 = 0x00010000,
+  .temperature = -1250,
+};
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+static void test_cobs_round_trip(void)
+{
+  const uint8_t data[] = { 0x00, 0x11, 0x00, 0x00, 0x22, 0x33, 0x00 };
+  uint8_t encoded[sizeof(data) + 2];
+  uint8_t decoded[sizeof(data) + 2];
+  const size_t len = telemetry_cobs_encode(data, sizeof(data), encoded);
+
+  TEST_ASSERT_EQUAL_size_t(sizeof(data) + 1, len);
+  for (size_t i = 0; i < len; i++)
+    TEST_ASSERT_TRUE(encoded[i] != 0x00);
+  TEST_ASSERT_EQUAL_size_t(sizeof(data), telemetry_cobs_decode(encoded, len, decoded));
+  TEST_ASSERT_EQUAL_MEMORY(data, decoded, sizeof(data));
+}
+
+static void test_record_round_trip(void)
+{
+  uint8_t frame[TELEMETRY_FRAME_MAX];
+  TELEMETRY_DECODER decoder;
+  const size_t len = telemetry_encode(reading, frame);
+  bool done = false;
+
+  TEST_ASSERT_TRUE(len <= TELEMETRY_FRAME_MAX);
+  TEST_ASSERT_EQUAL_HEX8(0x00, frame[len - 1]);
+
+  for (size_t i = 0; i < len; i++)
+    done = decoder.feed(frame[i]);
+
+  TEST_ASSERT_TRUE(done);
+  TEST_ASSERT_EQUAL_UINT32(reading.timestamp, decoder.get_reading().timestamp);
+  TEST_ASSERT_EQUAL_UINT8(reading.state, decoder.get_reading().state);
+  TEST_ASSERT_EQUAL_UINT16(reading.avalue, decoder.get_reading().avalue);
+  TEST_ASSERT_EQUAL_UINT16(reading.millivolts, decoder.get_reading().millivolts);
+  TEST_ASSERT_EQUAL_UINT32(reading.rs, decoder.get_reading().rs);
+  TEST_ASSERT_EQUAL_UINT32(reading.mgL_q16, decoder.get_reading().mgL_q16);
+  TEST_ASSERT_EQUAL_INT16(reading.temperature, decoder.get_reading().temperature);
+}
+
+static void test_corruption_and_resync(void)
+{
+  uint8_t frame[TELEMETRY_FRAME_MAX];
+  TELEMETRY_DECODER decoder;
+  const size_t len = telemetry_encode(reading, frame);
+  const char noise[] = "some text\r\n";
+  uint8_t records = 0;
+
+  // Noise, a corrupted frame, then a good one
+  for (size_t i = 0; i < sizeof(noise) - 1; i++)
+    records += decoder.feed(noise[i]);
+  for (size_t i = 0; i < len; i++)
+    records += decoder.feed(i == 5 ? frame[i] ^ 0x01 : frame[i]);
+  for (size_t i = 0; i < len; i++)
+    records += decoder.feed(frame[i]);
+
+  TEST_ASSERT_EQUAL_UINT8(1, records);
+  TEST_ASSERT_EQUAL_UINT32(1, decoder.get_frames());
+  TEST_ASSERT_EQUAL_UINT32(1, decoder.get_errors());
+}
+
+static void test_payload_round_trip(void)
+{
+  const char text[] = "STATE_MAIN cycle 250ms";
+  uint8_t frame[TELEMETRY_PAYLOAD_FRAME_MAX];
+  uint8_t long_text[TELEMETRY_PAYLOAD_MAX + 10];
+  TELEMETRY_DECODER decoder;
+  size_t len = telemetry_encode_payload(TELEMETRY_TYPE_TEXT, (const uint8_t *) text, sizeof(text) - 1, frame);
+  uint8_t records = 0;
+
+  for (size_t i = 0; i < len; i++)
+    records += decoder.feed(frame[i]);
+  TEST_ASSERT_EQUAL_UINT8(1, records);
+  TEST_ASSERT_EQUAL_HEX8(TELEMETRY_TYPE_TEXT, decoder.get_type());
+  TEST_ASSERT_EQUAL_UINT8(sizeof(text) - 1, decoder.get_payload_len());
+  TEST_ASSERT_EQUAL_MEMORY(text, decoder.get_payload(), sizeof(text) - 1);
+
+  // Truncated, then a reading in the same stream
+  for (size_t i = 0; i < sizeof(long_text); i++)
+    long_text[i] = 'a' + i % 26;
+  len = telemetry_encode_payload(TELEMETRY_TYPE_TEXT, long_text, sizeof(long_text), frame);
+  TEST_ASSERT_EQUAL_size_t(TELEMETRY_PAYLOAD_FRAME_MAX, len);
+  for (size_t i = 0; i < len; i++)
+    records += decoder.feed(frame[i]);
+  TEST_ASSERT_EQUAL_UINT8(TELEMETRY_PAYLOAD_MAX, decoder.get_payload_len());
+  TEST_ASSERT_EQUAL_MEMORY(long_text, decoder.get_payload(), TELEMETRY_PAYLOAD_MAX);
+
+  len = telemetry_encode(reading, frame);
+  for (size_t i = 0; i < len; i++)
+    records += decoder.feed(frame[i]);
+  TEST_ASSERT_EQUAL_UINT8(3, records);
+  TEST_ASSERT_EQUAL_HEX8(TELEMETRY_TYPE_READING, decoder.get_type());
+  TEST_ASSERT_EQUAL_UINT32(reading.rs, decoder.get_reading().rs);
+
+  // A binary payload, zeros included
+  const uint8_t block[] = { 2, 0x00, 0x80, 0x01, 0x00, 0x7F };
+
+  len = telemetry_encode_payload(TELEMETRY_TYPE_HISTORY, block, sizeof(block), frame);
+  for (size_t i = 0; i < len; i++)
+    records += decoder.feed(frame[i]);
+  TEST_ASSERT_EQUAL_UINT8(4, records);
+  TEST_ASSERT_EQUAL_HEX8(TELEMETRY_TYPE_HISTORY, decoder.get_type());
+  TEST_ASSERT_EQUAL_UINT8(sizeof(block), decoder.get_payload_len());
+  TEST_ASSERT_EQUAL_MEMORY(block, decoder.get_payload(), sizeof(block));
+  TEST_ASSERT_EQUAL_UINT32(0, decoder.get_errors());
+}
+
+static int run_tests(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_cobs_round_trip);
+  RUN_TEST(test_record_round_trip);
+  RUN_TEST(test_corruption_and_resync);
+  RUN_TEST(test_payload_round_trip);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup(void)
+{
+  delay(2000);
+  run_tests();
+}
+
+void loop(void)
+{
+}
+#else
+int main(void)
+{
+  return run_tests();
+}
+#endif
@@ -0,0 +1,233 @@
+/*******************************************************************************
+ * @file    test_tfsm.cpp
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Unit tests of the TFSM class.
+*******************************************************************************/
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <Tfsm.h>
+#include <TfsmP.h>
+
+#define STATE_A 0
+#define STATE_B 1
+#define STATE_C 2
+
+static uint32_t calls[3] = {0};
+static uint32_t delay_calls = 0;
+static const char *last_arg = NULL;
+
+static void action_a(void *arg) { (void) arg; calls[STATE_A]++; }
+static void action_b(void *arg) { (void) arg; calls[STATE_B]++; }
+static void action_c(void *arg) { last_arg = (const char *) arg; calls[STATE_C]++; }
+static void delay_cb(void) { delay_calls++; }
+
+static TFSM::ST_STATE table[] = {
+  {100, 2, 1, STATE_B, STATE_C, action_a, NULL, delay_cb},
+  {200, 3, 0, STATE_A, STATE_C, action_b, NULL, NULL},
+  {UINT32_MAX, 1, 0, STATE_C, STATE_C, action_c, NULL, NULL},
+};
+
+static constexpr TFSM::ST_STATE table_P[] PROGMEM = {
+  {100, 2, 1, STATE_B, STATE_C, action_a, NULL, delay_cb},
+  {200, 3, 0, STATE_A, STATE_C, action_b, NULL, NULL},
+  {UINT32_MAX, 1, 0, STATE_C, STATE_C, action_c, NULL, NULL},
+};
+
+static constexpr TFSM::ST_STATE table_invalid[] = {
+  {100, 2, 1, STATE_B, STATE_C, action_a, NULL, delay_cb},
+  {200, 3, 0, STATE_A, STATE_C, action_b, NULL, NULL},
+};
+
+static_assert(TFSM::is_valid_table(table_P), "valid table");
+static_assert(!TFSM::is_valid_table(table_invalid), "transition out of range");
+
+void setUp(void)
+{
+  calls[STATE_A] = calls[STATE_B] = calls[STATE_C] = 0;
+  delay_calls = 0;
+  last_arg = NULL;
+}
+
+void tearDown(void)
+{
+}
+
+static void test_primary_transitions(void)
+{
+  TFSM fsm(table, sizeof(table) / sizeof(TFSM::ST_STATE));
+
+  TEST_ASSERT_EQUAL_UINT32(100, fsm.get_current_cycle());
+
+  // 2 steps of A
+  fsm.run();
+  fsm.run();
+  TEST_ASSERT_EQUAL_UINT32(2, calls[STATE_A]);
+  TEST_ASSERT_EQUAL_INT32(0, fsm.get_current_steps());
+
+  // 1 cycle of transition delay
+  fsm.run();
+  TEST_ASSERT_EQUAL_UINT32(1, delay_calls);
+  TEST_ASSERT_EQUAL_UINT32(0, calls[STATE_B]);
+
+  // transition to B and its first step
+  fsm.run();
+  TEST_ASSERT_EQUAL_UINT32(1, calls[STATE_B]);
+  TEST_ASSERT_EQUAL_UINT32(200, fsm.get_current_cycle());
+  TEST_ASSERT_EQUAL_INT32(2, fsm.get_current_steps());
+
+  fsm.run();
+  fsm.run();
+  // back to A
+  fsm.run();
+  TEST_ASSERT_EQUAL_UINT32(3, calls[STATE_B]);
+  TEST_ASSERT_EQUAL_UINT32(3, calls[STATE_A]);
+  TEST_ASSERT_EQUAL_UINT32(100, fsm.get_current_cycle());
+}
+
+static void test_alt_transition_with_arg(void)
+{
+  TFSM fsm(table, sizeof(table) / sizeof(TFSM::ST_STATE));
+
+  fsm.run();
+  fsm.set_all(true, 0, true, "error");
+  // a delay of 0 does not override the transition delay of the state table
+  fsm.run();
+  TEST_ASSERT_EQUAL_UINT32(0, calls[STATE_C]);
+  fsm.run();
+
+  TEST_ASSERT_EQUAL_UINT32(1, calls[STATE_A]);
+  TEST_ASSERT_EQUAL_UINT32(1, calls[STATE_C]);
+  TEST_ASSERT_EQUAL_UINT32(1, delay_calls);
+  TEST_ASSERT_EQUAL_STRING("error", last_arg);
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, fsm.get_current_cycle());
+}
+
+static void test_set_delay(void)
+{
+  TFSM fsm(table, sizeof(table) / sizeof(TFSM::ST_STATE));
+
+  fsm.run();
+  fsm.set_all(false, 3, true);
+  fsm.run();
+  fsm.run();
+  TEST_ASSERT_EQUAL_UINT32(0, delay_calls);
+  fsm.run();
+  TEST_ASSERT_EQUAL_UINT32(1, delay_calls);
+  fsm.run();
+  TEST_ASSERT_EQUAL_UINT32(1, calls[STATE_B]);
+}
+
+static void test_flash_table_equivalence(void)
+{
+  TFSM fsm(table, sizeof(table) / sizeof(TFSM::ST_STATE));
+  TFSM_STATIC<table_P> fsm_P;
+  uint32_t calls_ram[3];
+  uint32_t delay_calls_ram;
+
+  for (uint16_t i = 0; i < 500; i++)
+  {
+    // Same external inputs to both machines, counters compared after a run
+    calls[STATE_A] = calls[STATE_B] = calls[STATE_C] = 0;
+    delay_calls = 0;
+    if (i % 7 == 3)
+      fsm.set_all(false, 2, true);
+    if (i % 97 == 50)
+      fsm.set_all(true, 0, true, "error");
+    fsm.run();
+    memcpy(calls_ram, calls, sizeof(calls));
+    delay_calls_ram = delay_calls;
+    const char *arg_ram = last_arg;
+
+    calls[STATE_A] = calls[STATE_B] = calls[STATE_C] = 0;
+    delay_calls = 0;
+    if (i % 7 == 3)
+      fsm_P.set_all(false, 2, true);
+    if (i % 97 == 50)
+      fsm_P.set_all(true, 0, true, "error");
+    fsm_P.run();
+
+    TEST_ASSERT_EQUAL_MEMORY(calls_ram, calls, sizeof(calls));
+    TEST_ASSERT_EQUAL_UINT32(delay_calls_ram, delay_calls);
+    TEST_ASSERT_EQUAL_UINT32(fsm.get_current_cycle(), fsm_P.get_current_cycle());
+    TEST_ASSERT_EQUAL_INT32(fsm.get_current_steps(), fsm_P.get_current_steps());
+    if (arg_ram != NULL)
+      TEST_ASSERT_EQUAL_STRING(arg_ram, last_arg);
+  }
+  TEST_ASSERT_EQUAL_UINT8(STATE_C, fsm_P.get_current_state());
+}
+
+static void test_set_transition_and_cycle(void)
+{
+  TFSM fsm(table, sizeof(table) / sizeof(TFSM::ST_STATE));
+  TFSM_STATIC<table_P> fsm_P;
+
+  // Out of the table, ignored
+  fsm.set_transition(3);
+  fsm_P.set_transition(3);
+  fsm.set_cycle(3, 1);
+  fsm_P.set_cycle(3, 1);
+
+  // From A straight to A instead of B, with a new cycle from now on
+  fsm.run();
+  fsm_P.run();
+  fsm.set_transition(STATE_A);
+  fsm_P.set_transition(STATE_A);
+  fsm.set_cycle(STATE_A, 50);
+  fsm_P.set_cycle(STATE_A, 50);
+  TEST_ASSERT_EQUAL_UINT32(50, fsm.get_current_cycle());
+  TEST_ASSERT_EQUAL_UINT32(50, fsm_P.get_current_cycle());
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    fsm.run();
+    fsm_P.run();
+  }
+  TEST_ASSERT_EQUAL_UINT8(STATE_A, fsm.get_current_state());
+  TEST_ASSERT_EQUAL_UINT8(STATE_A, fsm_P.get_current_state());
+  TEST_ASSERT_EQUAL_UINT32(2 * 3, calls[STATE_A]);
+  TEST_ASSERT_EQUAL_UINT32(0, calls[STATE_B]);
+  TEST_ASSERT_EQUAL_UINT32(50, fsm.get_current_cycle());
+  TEST_ASSERT_EQUAL_UINT32(50, fsm_P.get_current_cycle());
+
+  // Once, then the table transitions again
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    fsm.run();
+    fsm_P.run();
+  }
+  TEST_ASSERT_EQUAL_UINT8(STATE_B, fsm.get_current_state());
+  TEST_ASSERT_EQUAL_UINT8(STATE_B, fsm_P.get_current_state());
+  TEST_ASSERT_EQUAL_UINT32(200, fsm.get_current_cycle());
+  TEST_ASSERT_EQUAL_UINT32(200, fsm_P.get_current_cycle());
+}
+
+static int run_tests(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_primary_transitions);
+  RUN_TEST(test_alt_transition_with_arg);
+  RUN_TEST(test_set_delay);
+  RUN_TEST(test_flash_table_equivalence);
+  RUN_TEST(test_set_transition_and_cycle);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup(void)
+{
+  delay(2000);
+  run_tests();
+}
+
+void loop(void)
+{
+}
+#else
+int main(void)
+{
+  return run_tests();
+}
+#endif
@@ -0,0 +1,419 @@
+/*******************************************************************************
+ * @file    replay.cpp
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Host replay of the recorded experiments (experiments/),
+ *          through the firmware. src/main.cpp is built unchanged against the
+ *          simulated HAL (lib/Hal) and the stand-ins of the Arduino libraries
+ *          in shim/, with binary telemetry (TELEMETRY_BINARY=1). setup() and
+ *          loop() run its state table and state actions on the virtual
+ *          clock, which skips the idle time between the deadlines of the
+ *          state machine (hal_sim_set_idle_skip()), so a day of operation
+ *          replays in a fraction of a second.
+ *
+ *          The recordings were taken in alcohol vapour, so the warm-up and
+ *          the calibration run in simulated clean air first: Rs settles from
+ *          half to 60 * R0 exponentially, with a time constant of --tau
+ *          hours, with a noise of --noise LSB standard deviation from one
+ *          second to the next. R0 is by default the one the recorded mg/L
+ *          were computed with. The recording starts with the first measurement in
+ *          STATE_MAIN, one sample per second, a missing second holds the
+ *          previous sample.
+ *
+ *          Input: the CSV of xlsx_to_csv.py on stdin. Output: one CSV line
+ *          per telemetry record on stdout, the Rs (60 * R0 while
+ *          calibrating) and mg/L trajectory with the recorded mg/L alongside,
+ *          and a summary on stderr: states entered, calibrated R0, mg/L
+ *          against the recording, the compression ratio of the history
+ *          (lib/History) and throughput. The replay ends with the
+ *          recording, on a watchdog reset (e.g. STATE_RESET) or after --hours
+ *          of virtual time.
+ *
+ *          Build and run with:
+ *            pio run -e replay
+ *            tools/replay/xlsx_to_csv.py RECORDING.xlsx | .pio/build/replay/program > trajectory.csv
+ *
+ *          Options:
+ *            --air ADC       clean air ADC value instead of the recording R0
+ *            --tau HOURS     warm-up time constant (REPLAY_TAU_H)
+ *            --noise LSB     clean air noise (REPLAY_NOISE_LSB)
+ *            --hours HOURS   virtual time limit (REPLAY_HOURS)
+ *            --free-running  samples with the ADC interrupt as on target,
+ *                            ~100 times slower than the blocking fallback
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <Arduino.h>
+#include <avr/wdt.h>
+#include <Hal.h>
+#include <Mq3.h>
+#include <Telemetry.h>
+#include <History.h>
+
+#define REPLAY_TAU_H 8.0
+#define REPLAY_NOISE_LSB 0.35
+#define REPLAY_HOURS 72.0
+// E_STATE of src/main.cpp
+#define REPLAY_STATE_CALIBRATE 4
+#define REPLAY_STATE_MAIN 6
+#define REPLAY_STATES 8
+
+// Firmware of src/main.cpp
+void setup(void);
+void loop(void);
+extern MQ3 Mq3;
+extern HISTORY History;
+
+static const char *const state_names[REPLAY_STATES] = {
+  "CHECK_TEMPSENSOR", "INIT_WARMUP", "RUN_WARMUP", "CONFIG",
+  "CALIBRATE", "VERIFY", "MAIN", "RESET",
+};
+
+typedef struct {
+  uint16_t avalue;
+  // Negative if not recorded
+  float mgL;
+} ST_SAMPLE;
+
+// The recording, one sample per second
+static std::vector<ST_SAMPLE> Recording;
+static uint16_t AirValue = 0;
+static double TauUs = REPLAY_TAU_H * 3600e6;
+static double NoiseLsb = REPLAY_NOISE_LSB;
+// Virtual time of the first STATE_MAIN record, 0 before
+static uint64_t RecordingStartUs = 0;
+static size_t LastIndex = 0;
+static std::chrono::steady_clock::time_point Start;
+// Wall time to STATE_MAIN
+static double ReadyWallS = 0;
+// Clean air Rs relative to the settled one when the calibration started
+static double CalibrationSettled = 0;
+static TELEMETRY_DECODER Decoder;
+// Every reading of STATE_MAIN encoded as the history of the firmware, only
+// the statistics are used
+static uint8_t EveryBuffer[8 * HISTORY_BLOCK_SIZE];
+static HISTORY Every(EveryBuffer, sizeof(EveryBuffer));
+static uint32_t FirstRecordMs[REPLAY_STATES];
+static bool SeenState[REPLAY_STATES] = { false };
+static uint32_t Records = 0;
+static uint32_t Compared = 0;
+static double ErrorSum = 0, ErrorMax = 0;
+static double MgLMin = INFINITY, MgLMax = 0, MgLSum = 0;
+static uint32_t MgLCount = 0;
+static bool WdtEnabled = false;
+static uint64_t WdtPeriodUs = 0;
+static uint64_t WdtLastResetUs = 0;
+
+/***************************/
+/* Stand-ins of avr/wdt.h  */
+/***************************/
+
+void wdt_enable(uint8_t timeout)
+{
+  WdtEnabled = true;
+  WdtPeriodUs = 15000ULL << timeout;
+  WdtLastResetUs = hal_sim_get_time_us();
+}
+
+void wdt_disable(void)
+{
+  WdtEnabled = false;
+}
+
+void wdt_reset(void)
+{
+  hal_watchdog_reset();
+}
+
+/***************************/
+/* Static functions        */
+/***************************/
+
+static double rs_of(double avalue)
+{
+  return MQ3::R * (1024.0 / avalue - 1.0);
+}
+
+static double avalue_of(double rs)
+{
+  return 1024.0 * MQ3::R / (MQ3::R + rs);
+}
+
+// R0 the recorded mg/L were computed with, the median over the recording
+static double recordingR0(void)
+{
+  std::vector<double> r0;
+
+  for (const ST_SAMPLE &s : Recording)
+    if (s.mgL > 0 && s.avalue > 0 && s.avalue < 1024)
+      r0.push_back(0.4 * rs_of(s.avalue) * pow(s.mgL, 1 / 1.431));
+  if (r0.empty())
+    return 0;
+
+  std::nth_element(r0.begin(), r0.begin() + r0.size() / 2, r0.end());
+
+  return r0[r0.size() / 2];
+}
+
+// Warming up in clean air, settles to 60 * R0
+static double cleanAirRs(uint64_t us)
+{
+  return rs_of(AirValue) * (1.0 - 0.5 * exp(-(double) us / TauUs));
+}
+
+// Same for every read within a second, a measurement averages them
+static double noise(uint64_t second)
+{
+  // splitmix64 of the second, 4 uniforms summed, ~normal
+  uint64_t x = second + 0x9E3779B97F4A7C15ULL;
+  double sum = 0;
+
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  x ^= x >> 31;
+  for (uint8_t i = 0; i < 4; i++)
+    sum += ((x >> (16 * i)) & 0xFFFF) / 65536.0 - 0.5;
+
+  // The sum of 4 uniforms has a standard deviation of 1/sqrt(3)
+  return sum * sqrt(3.0) * NoiseLsb;
+}
+
+static bool readRecording(FILE *in)
+{
+  char line[128];
+
+  while (fgets(line, sizeof(line), in) != NULL)
+  {
+    char *end;
+    const long timestamp = strtol(line, &end, 10);
+
+    // The header and malformed lines
+    if (end == line || *end != ',' || timestamp < 0)
+      continue;
+
+    const long avalue = strtol(end + 1, &end, 10);
+    const char *mgL = *end == ',' ? end + 1 : "";
+    const ST_SAMPLE sample = { (uint16_t) avalue, *mgL >= '0' && *mgL <= '9' ? (float) atof(mgL) : -1.0f };
+
+    // A missing second holds the previous sample
+    while (!Recording.empty() && Recording.size() < (size_t) timestamp)
+      Recording.push_back({ Recording.back().avalue, -1.0f });
+    if (Recording.size() == (size_t) timestamp || Recording.empty())
+      Recording.push_back(sample);
+  }
+
+  return !Recording.empty();
+}
+
+static uint16_t adc_source(uint8_t pin)
+{
+  const uint64_t now = hal_sim_get_time_us();
+
+  (void) pin;
+
+  if (RecordingStartUs == 0)
+  {
+    // A measurement reads 1000 times per second
+    static uint64_t second = UINT64_MAX;
+    static uint16_t value;
+
+    if (now / 1000000 != second)
+    {
+      const double avalue = avalue_of(cleanAirRs(now)) + noise(now / 1000000);
+
+      second = now / 1000000;
+      value = avalue > 0 ? (uint16_t) (avalue + 0.5) : 0;
+    }
+
+    return value;
+  }
+
+  LastIndex = (now - RecordingStartUs) / 1000000;
+
+  return Recording[LastIndex < Recording.size() ? LastIndex : Recording.size() - 1].avalue;
+}
+
+static void record(const ST_TELEMETRY_READING &r)
+{
+  const double mgL = r.mgL_q16 / 65536.0;
+  const uint8_t state = r.state < REPLAY_STATES ? r.state : REPLAY_STATES - 1;
+  float recorded = -1.0f;
+
+  Records++;
+  if (!SeenState[state])
+  {
+    SeenState[state] = true;
+    FirstRecordMs[state] = r.timestamp;
+    if (state == REPLAY_STATE_CALIBRATE)
+      CalibrationSettled = cleanAirRs(hal_sim_get_time_us()) / rs_of(AirValue);
+  }
+
+  if (state == REPLAY_STATE_MAIN)
+  {
+    if (RecordingStartUs == 0)
+    {
+      // Measured in clean air, the recording starts with the next one
+      RecordingStartUs = hal_sim_get_time_us();
+      ReadyWallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+    }
+    else if (LastIndex < Recording.size())
+    {
+      recorded = Recording[LastIndex].mgL;
+      if (recorded >= 0)
+      {
+        const double error = fabs(mgL - recorded);
+
+        ErrorSum += error;
+        ErrorMax = error > ErrorMax ? error : ErrorMax;
+        Compared++;
+      }
+      MgLMin = mgL < MgLMin ? mgL : MgLMin;
+      MgLMax = mgL > MgLMax ? mgL : MgLMax;
+      MgLSum += mgL;
+      MgLCount++;
+    }
+
+    const ST_HISTORY_RECORD reading = {
+      .time_s = r.timestamp / 1000,
+      .mgL_milli = (uint32_t) ((r.mgL_q16 * 1000ULL + MQ3_MGL_ONE / 2) >> 16),
+      .rs = r.rs,
+      .temperature = r.temperature,
+    };
+
+    Every.append(reading);
+  }
+
+  printf("%.3f,%s,%u,%lu,%.4f,", r.timestamp / 1000.0, state_names[state], r.avalue, (unsigned long) r.rs, mgL);
+  if (recorded >= 0)
+    printf("%.4f\n", recorded);
+  else
+    printf("\n");
+}
+
+static void serial_sink(const uint8_t *data, size_t len)
+{
+  for (size_t i = 0; i < len; i++)
+    if (Decoder.feed(data[i]) && Decoder.get_type() == TELEMETRY_TYPE_READING)
+      record(Decoder.get_reading());
+}
+
+static void usage(const char *name)
+{
+  fprintf(stderr, "usage: %s [--air ADC] [--tau HOURS] [--noise LSB] [--hours HOURS] [--free-running] < recording.csv\n", name);
+}
+
+int main(int argc, char **argv)
+{
+  double hours = REPLAY_HOURS;
+  bool free_running = false;
+  const char *watchdog = NULL;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "--air") && i + 1 < argc)
+      AirValue = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--tau") && i + 1 < argc)
+      TauUs = atof(argv[++i]) * 3600e6;
+    else if (!strcmp(argv[i], "--noise") && i + 1 < argc)
+      NoiseLsb = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--hours") && i + 1 < argc)
+      hours = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--free-running"))
+      free_running = true;
+    else
+    {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+
+  if (!readRecording(stdin))
+  {
+    fprintf(stderr, "No samples on stdin\n");
+    usage(argv[0]);
+    return 1;
+  }
+
+  const double r0 = recordingR0();
+
+  if (AirValue == 0)
+    AirValue = r0 > 0 ? (uint16_t) (avalue_of(60 * r0) + 0.5) : 125;
+  TauUs = TauUs > 1 ? TauUs : 1;
+
+  hal_sim_reset();
+  hal_sim_set_idle_skip(true);
+  hal_sim_set_adc_free_running(free_running);
+  hal_sim_set_adc_source(adc_source);
+  hal_sim_set_serial_sink(serial_sink);
+
+  printf("time_s,state,avalue,rs_ohm,mg_per_l,recorded_mg_per_l\n");
+
+  const uint64_t limit_us = (uint64_t) (hours * 3600e6);
+  uint32_t watchdog_resets = 0;
+
+  Start = std::chrono::steady_clock::now();
+
+  setup();
+  for (;;)
+  {
+    const uint64_t now = hal_sim_get_time_us();
+
+    if (RecordingStartUs != 0 && now - RecordingStartUs >= Recording.size() * 1000000ULL)
+      break;
+    if (now >= limit_us)
+      break;
+    if (hal_sim_get_watchdog_resets() != watchdog_resets)
+    {
+      watchdog_resets = hal_sim_get_watchdog_resets();
+      WdtLastResetUs = now;
+    }
+    if (WdtEnabled && now - WdtLastResetUs > WdtPeriodUs)
+    {
+      watchdog = "watchdog reset";
+      break;
+    }
+
+    loop();
+  }
+
+  const double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+  const double virtual_s = hal_sim_get_time_us() / 1e6;
+
+  fprintf(stderr, "Recording: %zu s, R0 %.1f Ohm, clean air ADC %u\n", Recording.size(), r0, AirValue);
+  for (uint8_t i = 0; i < REPLAY_STATES; i++)
+    if (SeenState[i])
+      fprintf(stderr, "  %-16s from %10.1f s (%.2f h)\n", state_names[i], FirstRecordMs[i] / 1000.0, FirstRecordMs[i] / 3600e3);
+  if (SeenState[REPLAY_STATE_CALIBRATE])
+    fprintf(stderr, "Clean air Rs at %.1f %% of the settled one when calibrating\n", CalibrationSettled * 100);
+  fprintf(stderr, "Calibrated R0: %.1f Ohm%s\n", Mq3.R0, Mq3.is_valid() ? "" : " (invalid)");
+  if (RecordingStartUs != 0)
+    fprintf(stderr, "Warm-up and calibration: %.2f h of virtual time in %.3f s\n", RecordingStartUs / 3600e6, ReadyWallS);
+  if (MgLCount > 0)
+    fprintf(stderr, "mg/L: %u measurements, min %.3f, mean %.3f, max %.3f\n", MgLCount, MgLMin, MgLSum / MgLCount, MgLMax);
+  if (Compared > 0)
+    fprintf(stderr, "mg/L against the recording: mean abs error %.4f, max %.4f\n", ErrorSum / Compared, ErrorMax);
+  if (Every.get_stats().records > 0)
+  {
+    const ST_HISTORY_STATS &every = Every.get_stats();
+    const ST_HISTORY_STATS &kept = History.get_stats();
+
+    fprintf(stderr, "History: every reading %lu bytes for %lu (%.2fx), ",
+      (unsigned long) every.bytes, (unsigned long) every.records, (double) every.records * HISTORY_RAW_SIZE / every.bytes);
+    fprintf(stderr, "the firmware's %lu bytes for %lu (%.2fx), %u held\n",
+      (unsigned long) kept.bytes, (unsigned long) kept.records, kept.bytes > 0 ? (double) kept.records * HISTORY_RAW_SIZE / kept.bytes : 0.0,
+      History.get_count());
+  }
+  if (watchdog != NULL)
+    fprintf(stderr, "Stopped by a %s at %.1f s\n", watchdog, virtual_s);
+  fprintf(stderr, "Replayed %.1f h of virtual time in %.3f s: %.0fx real time, %lu telemetry records (%lu errors), %lu ADC reads, %lu idle wake ups\n",
+    virtual_s / 3600, wall_s, virtual_s / wall_s, (unsigned long) Records, (unsigned long) Decoder.get_errors(),
+    (unsigned long) hal_sim_get_adc_reads(), (unsigned long) hal_sim_get_idles());
+
+  return watchdog != NULL ? 1 : 0;
+}
@@ -0,0 +1,61 @@
+/*******************************************************************************
+ * @file    Arduino.h
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Host stand-in of the Arduino core for the replay of src/main.cpp
+ *          (see tools/replay). Only what main.cpp uses, on top of the
+ *          simulated HAL: the time functions run on the virtual clock and
+ *          Serial only sets the baud rate of the simulated TX buffer, the
+ *          firmware writes through LOGGER.
+*******************************************************************************/
+
+#ifndef _REPLAY_ARDUINO_H
+#define _REPLAY_ARDUINO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <Hal.h>
+
+typedef uint8_t byte;
+
+// As the Arduino core, rounds to a long
+#define round(x) ((x) >= 0 ? (long) ((x) + 0.5) : (long) ((x) - 0.5))
+
+// 32 bits, they wrap as on target
+inline uint32_t millis(void)
+{
+  return hal_millis();
+}
+
+inline uint32_t micros(void)
+{
+  return hal_micros();
+}
+
+inline void delay(unsigned long ms)
+{
+  hal_delay_us(ms * 1000);
+}
+
+inline char *dtostrf(double value, signed char width, unsigned char prec, char *buf)
+{
+  sprintf(buf, "%*.*f", width, prec, value);
+
+  return buf;
+}
+
+class HardwareSerial
+{
+  public:
+    void begin(unsigned long baud)
+    {
+      hal_sim_set_serial_baud(baud);
+    }
+};
+
+inline HardwareSerial Serial;
+
+#endif // _REPLAY_ARDUINO_H
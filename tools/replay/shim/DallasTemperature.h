@@ -0,0 +1,100 @@
+/*******************************************************************************
+ * @file    DallasTemperature.h
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Host stand-in of the DallasTemperature library for the replay. One
+ *          DS18B20 on the bus, at the fixed temperature of the recordings
+ *          (DallasTemperature::sim_temp_c, 20 degC by default), or none with
+ *          DallasTemperature::sim_devices = 0. A conversion takes the time
+ *          of millisToWaitForConversion() on the virtual clock.
+*******************************************************************************/
+
+#ifndef _REPLAY_DALLAS_TEMPERATURE_H
+#define _REPLAY_DALLAS_TEMPERATURE_H
+
+#include <Arduino.h>
+#include <OneWire.h>
+
+#define DEVICE_DISCONNECTED_C -127
+
+typedef uint8_t DeviceAddress[8];
+
+class DallasTemperature
+{
+  public:
+    static inline uint8_t sim_devices = 1;
+    static inline float sim_temp_c = 20.0;
+
+    DallasTemperature(OneWire *wire) { (void) wire; }
+    void begin(void) {}
+
+    uint8_t getDeviceCount(void)
+    {
+      return sim_devices;
+    }
+
+    bool getAddress(uint8_t *address, uint8_t index)
+    {
+      static const DeviceAddress rom = { 0x28, 0x52, 0x45, 0x50, 0x4C, 0x41, 0x59, 0x00 };
+
+      if (index >= sim_devices)
+        return false;
+      memcpy(address, rom, sizeof(rom));
+
+      return true;
+    }
+
+    bool setResolution(const uint8_t *address, uint8_t resolution)
+    {
+      (void) address;
+      this->_resolution = resolution;
+
+      return true;
+    }
+
+    uint8_t getResolution(const uint8_t *address)
+    {
+      (void) address;
+
+      return this->_resolution;
+    }
+
+    bool isParasitePowerMode(void)
+    {
+      return false;
+    }
+
+    void setWaitForConversion(bool wait)
+    {
+      this->_wait = wait;
+    }
+
+    uint16_t millisToWaitForConversion(uint8_t resolution)
+    {
+      return resolution >= 12 ? 750 : resolution == 11 ? 375 : resolution == 10 ? 188 : 94;
+    }
+
+    void requestTemperatures(void)
+    {
+      this->_requested_ms = hal_millis();
+      if (this->_wait)
+        hal_delay_us(millisToWaitForConversion(this->_resolution) * 1000UL);
+    }
+
+    float getTempC(const uint8_t *address)
+    {
+      (void) address;
+
+      if (sim_devices == 0 || hal_millis() - this->_requested_ms < millisToWaitForConversion(this->_resolution))
+        return DEVICE_DISCONNECTED_C;
+
+      return sim_temp_c;
+    }
+
+  private:
+    uint8_t _resolution = 12;
+    bool _wait = true;
+    uint32_t _requested_ms = 0;
+};
+
+#endif // _REPLAY_DALLAS_TEMPERATURE_H
@@ -0,0 +1,20 @@
+/*******************************************************************************
+ * @file    OneWire.h
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Host stand-in of the OneWire library for the replay, see
+ *          DallasTemperature.h.
+*******************************************************************************/
+
+#ifndef _REPLAY_ONE_WIRE_H
+#define _REPLAY_ONE_WIRE_H
+
+#include <Arduino.h>
+
+class OneWire
+{
+  public:
+    OneWire(uint8_t pin) { (void) pin; }
+};
+
+#endif // _REPLAY_ONE_WIRE_H
@@ -0,0 +1,14 @@
+/*******************************************************************************
+ * @file    Wire.h
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Host stand-in of the Arduino Wire library for the replay, the LCD
+ *          goes through hal_i2c_write() of the simulated HAL.
+*******************************************************************************/
+
+#ifndef _REPLAY_WIRE_H
+#define _REPLAY_WIRE_H
+
+#include <Arduino.h>
+
+#endif // _REPLAY_WIRE_H
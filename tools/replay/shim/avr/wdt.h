@@ -0,0 +1,25 @@
+/*******************************************************************************
+ * @file    wdt.h
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Host stand-in of avr/wdt.h for the replay. The replay tool
+ *          implements the watchdog: it stops the replay as the watchdog would
+ *          reset the MCU, once enabled and not reset for its period.
+*******************************************************************************/
+
+#ifndef _REPLAY_AVR_WDT_H
+#define _REPLAY_AVR_WDT_H
+
+#include <stdint.h>
+
+#define WDTO_15MS 0
+#define WDTO_1S 6
+#define WDTO_2S 7
+#define WDTO_4S 8
+#define WDTO_8S 9
+
+void wdt_enable(uint8_t timeout);
+void wdt_disable(void);
+void wdt_reset(void);
+
+#endif // _REPLAY_AVR_WDT_H
@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+"""Converts the recorded experiments (experiments/*.xlsx) to the CSV stream
+read by the replay tool (see replay.cpp).
+
+Every data sheet of a recording has one row per second: timestamp in s, ADC
+value, volts and mg/L. The timestamp and the ADC value are kept, and the
+recorded mg/L as a reference for the mg/L the replay computes through the
+firmware (empty if missing). Standard library only, no spreadsheet package
+needed.
+
+Usage:
+  xlsx_to_csv.py RECORDING.xlsx --list
+  xlsx_to_csv.py RECORDING.xlsx [--sheet NAME|INDEX ...] > recording.csv
+
+Without --sheet all the data sheets are written one after the other, the
+timestamps of each continue from the previous sheet.
+"""
+
+import argparse
+import re
+import sys
+import zipfile
+import xml.etree.ElementTree as ET
+
+NS = {
+    'm': 'http://schemas.openxmlformats.org/spreadsheetml/2006/main',
+    'r': 'http://schemas.openxmlformats.org/officeDocument/2006/relationships',
+    'p': 'http://schemas.openxmlformats.org/package/2006/relationships',
+}
+CELL_REF = re.compile(r'([A-Z]+)(\d+)')
+# The plot sheets hold a few summary rows only
+MIN_SAMPLES = 60
+
+
+def sheets(book):
+    """Returns the (name, path) of every sheet, in workbook order."""
+    workbook = ET.fromstring(book.read('xl/workbook.xml'))
+    rels = ET.fromstring(book.read('xl/_rels/workbook.xml.rels'))
+    targets = {rel.get('Id'): rel.get('Target') for rel in rels.findall('p:Relationship', NS)}
+    result = []
+
+    for sheet in workbook.findall('m:sheets/m:sheet', NS):
+        target = targets[sheet.get('{%s}id' % NS['r'])].lstrip('/')
+        result.append((sheet.get('name'), target if target.startswith('xl/') else 'xl/' + target))
+
+    return result
+
+
+def samples(book, path):
+    """Yields the (timestamp, ADC value, mg/L or None) rows of a sheet,
+    skips the header and the rows without a timestamp or ADC value."""
+    with book.open(path) as f:
+        for _, row in ET.iterparse(f):
+            if row.tag != '{%s}row' % NS['m']:
+                continue
+            values = {}
+            for cell in row.findall('m:c', NS):
+                value = cell.find('m:v', NS)
+                if cell.get('t') is None and value is not None:
+                    values[CELL_REF.match(cell.get('r')).group(1)] = float(value.text)
+            row.clear()
+            if 'A' in values and 'B' in values:
+                yield int(values['A']), int(values['B']), values.get('D')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n\n')[0])
+    parser.add_argument('recording')
+    parser.add_argument('--list', action='store_true', help='list the data sheets and exit')
+    parser.add_argument('--sheet', action='append', help='sheet name or 0-based index, repeatable')
+    args = parser.parse_args()
+
+    book = zipfile.ZipFile(args.recording)
+    data = []
+    for name, path in sheets(book):
+        rows = list(samples(book, path))
+        if len(rows) >= MIN_SAMPLES:
+            data.append((name, rows))
+
+    if args.list:
+        for i, (name, rows) in enumerate(data):
+            print('%d: %s, %d samples, %d s' % (i, name, len(rows), rows[-1][0] - rows[0][0] + 1))
+        return 0
+
+    if args.sheet:
+        selected = []
+        for key in args.sheet:
+            match = [d for i, d in enumerate(data) if key in (d[0], str(i))]
+            if not match:
+                sys.exit('%s: no data sheet %s' % (args.recording, key))
+            selected += match
+        data = selected
+
+    out = sys.stdout
+    offset = 0
+    out.write('timestamp_s,avalue,mg_per_l\n')
+    for name, rows in data:
+        start = rows[0][0]
+        for timestamp, avalue, mgL in rows:
+            out.write('%d,%d,%s\n' % (offset + timestamp - start, avalue, '' if mgL is None else '%.4f' % mgL))
+        offset += rows[-1][0] - start + 1
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,155 @@
+/*******************************************************************************
+ * @file    telemetry_decode.cpp
+ * @author  Kostas Markostamos
+ * @date    16/10/2026
+ * @brief   Host decoder of the binary telemetry (see lib/Telemetry). Reads the
+ *          raw serial stream from stdin and writes one CSV line per valid
+ *          reading to stdout, and the text records (e.g. the replies to the
+ *          serial commands) to stderr. Build and run with:
+ *            pio run -e telemetry_decode
+ *            .pio/build/telemetry_decode/program < /dev/ttyACM0
+ *
+ *          With --history it writes the readings of a history dump (the
+ *          dump command) instead, from the TELEMETRY_TYPE_HISTORY records of
+ *          a binary build or from the "B <hex>" lines of the text log.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <Telemetry.h>
+#include <History.h>
+
+// "B ", the hex of a block and the line ending
+#define LINE_MAX (2 * HISTORY_BLOCK_SIZE + 4)
+
+static uint32_t Blocks = 0;
+static uint32_t BadBlocks = 0;
+
+static void print_block(const uint8_t *block, uint8_t len)
+{
+  ST_HISTORY_RECORD records[HISTORY_BLOCK_RECORDS_MAX];
+  const int16_t n = history_decode_block(block, len, records, HISTORY_BLOCK_RECORDS_MAX);
+
+  if (n < 0)
+  {
+    BadBlocks++;
+    return;
+  }
+  Blocks++;
+
+  for (int16_t i = 0; i < n; i++)
+  {
+    printf("%lu,%.3f,%lu,", (unsigned long) records[i].time_s, records[i].mgL_milli / 1000.0,
+      (unsigned long) records[i].rs);
+    if (records[i].temperature == HISTORY_NO_TEMP)
+      printf("\n");
+    else
+      printf("%.2f\n", records[i].temperature / 100.0);
+  }
+  fflush(stdout);
+}
+
+static int hex_digit(char c)
+{
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+
+  return -1;
+}
+
+// A "B <hex>" line of the text log
+static void parse_line(const char *line, size_t len)
+{
+  uint8_t block[HISTORY_BLOCK_SIZE];
+  size_t n = 0;
+
+  while (len > 0 && (line[len - 1] == '\r' || line[len - 1] == '\n'))
+    len--;
+  if (len < 2 || line[0] != 'B' || line[1] != ' ' || (len - 2) % 2 != 0 || (len - 2) / 2 > sizeof(block))
+    return;
+
+  for (size_t i = 2; i < len; i += 2)
+  {
+    const int hi = hex_digit(line[i]);
+    const int lo = hex_digit(line[i + 1]);
+
+    if (hi < 0 || lo < 0)
+    {
+      BadBlocks++;
+      return;
+    }
+    block[n++] = (uint8_t) (hi << 4 | lo);
+  }
+  print_block(block, (uint8_t) n);
+}
+
+int main(int argc, char **argv)
+{
+  TELEMETRY_DECODER decoder;
+  const bool history = argc > 1 && strcmp(argv[1], "--history") == 0;
+  char line[LINE_MAX];
+  size_t line_len = 0;
+  int c;
+
+  if (argc > 1 && !history)
+  {
+    fprintf(stderr, "usage: %s [--history] < stream\n", argv[0]);
+    return 2;
+  }
+
+  if (history)
+    printf("time_s,mg_per_l,rs_ohm,temperature_c\n");
+  else
+    printf("timestamp_ms,state,avalue,millivolts,rs_ohm,mg_per_l,temperature_c\n");
+
+  while ((c = getchar()) != EOF)
+  {
+    if (history)
+    {
+      if (c == '\n' || c == 0x00)
+      {
+        parse_line(line, line_len);
+        line_len = 0;
+      }
+      else if (line_len < sizeof(line))
+      {
+        line[line_len++] = (char) c;
+      }
+    }
+
+    if (!decoder.feed((uint8_t) c))
+      continue;
+
+    if (decoder.get_type() == TELEMETRY_TYPE_TEXT)
+    {
+      fprintf(stderr, "%.*s\n", decoder.get_payload_len(), (const char *) decoder.get_payload());
+    }
+    else if (decoder.get_type() == TELEMETRY_TYPE_HISTORY)
+    {
+      if (history)
+        print_block(decoder.get_payload(), decoder.get_payload_len());
+    }
+    else if (!history)
+    {
+      const ST_TELEMETRY_READING &r = decoder.get_reading();
+
+      printf("%lu,%u,%u,%u,%lu,%.5f,", (unsigned long) r.timestamp, r.state, r.avalue, r.millivolts,
+        (unsigned long) r.rs, r.mgL_q16 / 65536.0);
+      if (r.temperature == TELEMETRY_NO_TEMP)
+        printf("\n");
+      else
+        printf("%.2f\n", r.temperature / 100.0);
+      fflush(stdout);
+    }
+  }
+
+  fprintf(stderr, "%lu records, %lu errors\n", (unsigned long) decoder.get_frames(), (unsigned long) decoder.get_errors());
+  if (history)
+    fprintf(stderr, "%lu history blocks, %lu malformed\n", (unsigned long) Blocks, (unsigned long) BadBlocks);
+
+  return 0;
+}